@@ -0,0 +1,46 @@
+//
+//  Barrier.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef Barrier_h
+#define Barrier_h
+
+#include "gol-config.h"
+#include <mutex>
+#include <condition_variable>
+
+/// A reusable barrier for a fixed number of threads (like std::barrier in C++20).
+/// Every thread that calls wait() blocks until all threads have called wait().
+class Barrier
+{
+public:
+    explicit Barrier(int threadCount) : m_threadCount(threadCount), m_waiting(0), m_round(0) {}
+
+    Barrier(const Barrier&) = delete;
+    Barrier& operator=(const Barrier&) = delete;
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        unsigned long round = m_round;
+        if (++m_waiting == m_threadCount) {
+            m_waiting = 0;
+            m_round++;
+            m_condition.notify_all();
+        } else {
+            m_condition.wait(lock, [this, round] { return m_round != round; });
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    const int m_threadCount;
+    int m_waiting;
+    unsigned long m_round;
+};
+
+#endif // Barrier_h
@@ -0,0 +1,218 @@
+//
+//  BatchRunner.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "BatchRunner.h"
+#include "BoardIO.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+std::vector<BatchJob> BatchRunner::parseManifest(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Can't read the manifest " + path);
+    }
+    std::vector<BatchJob> jobs;
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++) {
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first) || first[0] == '#') {
+            continue;
+        }
+        BatchJob job;
+        job.inputPath = first;
+        std::string generations;
+        std::string rest;
+        char* end = nullptr;
+        bool ok = (fields >> generations) && !(fields >> job.outputPath && fields >> rest);
+        if (ok) {
+            job.generations = strtoll(generations.c_str(), &end, 10);
+            ok = *end == 0 && job.generations >= 0;
+        }
+        if (!ok) {
+            throw std::runtime_error("Manifest " + path + ", line " + std::to_string(lineNumber)
+                + ": expected \"INPUTFILE GENERATIONS [OUTPUTFILE]\"");
+        }
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+BatchRunner::BatchRunner(const std::vector<BatchJob>& jobs, int numberOfWorkers, const std::function<void(Board&, int64_t)>& run) {
+    m_jobs = jobs;
+    m_numberOfWorkers = std::max(1, numberOfWorkers);
+    m_run = run;
+}
+
+/// Like BoardIO::load() and BoardIO::save(), but with one thread. (The other threads are busy with other boards.)
+static Board loadBoard(const std::string& path) {
+    if (BoardIO::isBinaryFile(path)) {
+        Board board;
+        BoardIO::loadBinary(path).copyTo(board);
+        return board;
+    }
+    return BoardIO::loadText(path, 1);
+}
+
+static void saveBoard(const Board& board, const std::string& path) {
+    if (BoardIO::isBinaryPath(path)) {
+        BoardIO::saveBinary(BitBoard(board), path);
+    } else {
+        BoardIO::saveText(board, path, false);
+    }
+}
+
+// About the pipeline:
+// The I/O threads load the boards in the order of the jobs into `loaded`, but never more than
+// two boards per worker ahead of the workers. The workers take the boards from `loaded`, run them,
+// and put them into `calculated`. The I/O threads save the boards in `calculated` before they
+// load new ones, so the results don't pile up in memory. Everything is protected by one mutex;
+// it is only held to move boards around, never while loading, saving or running a board.
+
+std::vector<BatchResult> BatchRunner::run() {
+    struct Task {
+        size_t job;
+        Board board;
+    };
+
+    const size_t jobCount = m_jobs.size();
+    const size_t maxLoaded = 2 * (size_t)m_numberOfWorkers;
+    std::vector<BatchResult> results(jobCount);
+    m_cellGenerations = 0;
+    if (jobCount == 0) {
+        return results;
+    }
+
+    std::mutex mutex;
+    std::condition_variable ioCondition;
+    std::condition_variable workerCondition;
+    std::deque<Task> loaded;
+    std::deque<Task> calculated;
+    size_t nextJob = 0;
+    size_t loading = 0;
+    size_t finished = 0;
+
+    // Must be called with the mutex locked.
+    auto finishJob = [&]() {
+        finished++;
+        if (finished == jobCount) {
+            ioCondition.notify_all();
+            workerCondition.notify_all();
+        }
+    };
+
+    auto ioThread = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            ioCondition.wait(lock, [&] {
+                return !calculated.empty() || (nextJob < jobCount && loaded.size() + loading < maxLoaded) || finished == jobCount;
+            });
+            if (!calculated.empty()) {
+                Task task = std::move(calculated.front());
+                calculated.pop_front();
+                lock.unlock();
+                std::string error;
+                try {
+                    saveBoard(task.board, m_jobs[task.job].outputPath);
+                }
+                catch (const std::exception& e) {
+                    error = e.what();
+                }
+                lock.lock();
+                if (!error.empty()) {
+                    results[task.job].ok = false;
+                    results[task.job].error = error;
+                }
+                finishJob();
+            }
+            else if (nextJob < jobCount && loaded.size() + loading < maxLoaded) {
+                Task task;
+                task.job = nextJob++;
+                loading++;
+                lock.unlock();
+                std::string error;
+                try {
+                    task.board = loadBoard(m_jobs[task.job].inputPath);
+                }
+                catch (const std::exception& e) {
+                    error = e.what();
+                }
+                lock.lock();
+                loading--;
+                if (error.empty()) {
+                    loaded.push_back(std::move(task));
+                    workerCondition.notify_one();
+                } else {
+                    results[task.job].error = error;
+                    finishJob();
+                }
+            }
+            else {
+                return;
+            }
+        }
+    };
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            workerCondition.wait(lock, [&] { return !loaded.empty() || finished == jobCount; });
+            if (loaded.empty()) {
+                return;
+            }
+            Task task = std::move(loaded.front());
+            loaded.pop_front();
+            ioCondition.notify_one();
+            lock.unlock();
+            const BatchJob& job = m_jobs[task.job];
+            BatchResult result;
+            try {
+                m_run(task.board, job.generations);
+                result.ok = true;
+                result.rowCount = task.board.getRowCount();
+                result.colCount = task.board.getColCount();
+                result.hash = task.board.getHash();
+            }
+            catch (const std::exception& e) {
+                result.error = e.what();
+            }
+            lock.lock();
+            results[task.job] = result;
+            if (result.ok) {
+                m_cellGenerations += (double)result.rowCount * result.colCount * job.generations;
+            }
+            if (result.ok && !job.outputPath.empty()) {
+                calculated.push_back(std::move(task));
+                ioCondition.notify_one();
+            } else {
+                finishJob();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < std::max(1, m_numberOfIOThreads); i++) {
+        threads.push_back(std::thread(ioThread));
+    }
+    for (int i = 1; i < m_numberOfWorkers; i++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (auto& t : threads) {
+        t.join();
+    }
+    return results;
+}
@@ -0,0 +1,73 @@
+//
+//  BatchRunner.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef BatchRunner_h
+#define BatchRunner_h
+
+#include "gol-config.h"
+#include "Board.h"
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+/// One line of a batch manifest.
+struct BatchJob {
+    std::string inputPath;
+    int64_t generations = 0;
+    /// Empty if the result isn't saved.
+    std::string outputPath;
+};
+
+/// What happened to one job.
+struct BatchResult {
+    bool ok = false;
+    /// Why the job failed, if it failed.
+    std::string error;
+    int rowCount = 0;
+    int colCount = 0;
+    /// The hash of the result (see Board::getHash()).
+    uint64_t hash = 0;
+};
+
+/// Runs many (small) boards in one process. Every worker thread runs one board at a time,
+/// single-threaded, so the boards are calculated in parallel instead of the generations of one board.
+/// The boards are loaded and saved by a few I/O threads while the workers are busy, and only a
+/// few boards are loaded ahead of the workers, so it doesn't matter how many jobs there are.
+class BatchRunner
+{
+public:
+    /// Reads a manifest: one job per line, "INPUTFILE GENERATIONS [OUTPUTFILE]", separated by spaces or tabs.
+    /// Empty lines and lines that start with '#' are ignored.
+    /// @throws std::runtime_error if the file can't be read or a line is malformed.
+    static std::vector<BatchJob> parseManifest(const std::string& path);
+
+    /// @param run Calculates n generations of a board. It is called by several threads at once (with different boards).
+    BatchRunner(const std::vector<BatchJob>& jobs, int numberOfWorkers, const std::function<void(Board&, int64_t)>& run);
+
+    /// Runs all jobs. A job that fails (e.g. because its input file doesn't exist) doesn't stop the others.
+    /// @return One result per job, in the order of the jobs.
+    std::vector<BatchResult> run();
+
+    /// rows * cols * generations of all jobs that were calculated in the last run().
+    inline double getCellGenerations() const { return m_cellGenerations; }
+
+    int getNumberOfIOThreads() const { return m_numberOfIOThreads; };
+    void setNumberOfIOThreads(int n) { m_numberOfIOThreads = n; };
+
+    static const int DEFAULT_IO_THREADS = 2;
+
+private:
+    std::vector<BatchJob> m_jobs;
+    int m_numberOfWorkers;
+    int m_numberOfIOThreads = DEFAULT_IO_THREADS;
+    std::function<void(Board&, int64_t)> m_run;
+    double m_cellGenerations = 0;
+};
+
+#endif // BatchRunner_h
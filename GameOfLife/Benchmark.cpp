@@ -0,0 +1,330 @@
+//
+//  Benchmark.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "Benchmark.h"
+#include "Board.h"
+#include "ProcessRunner.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#if GOL_WIN_ONLY
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// About the workloads:
+// They are meant to show the strengths and weaknesses of the engines. "random" and "soup" are
+// busy everywhere (good for seq, bits, timeblock and the threads), "gliders" and "stilllife" are
+// mostly empty or static (good for tiles, steal and hashlife).
+// The random numbers come from our own generator (SplitMix64), not from <random>, because the
+// distributions of the standard library give different numbers with different compilers.
+
+static inline uint64_t nextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/// A random number in [0, 1).
+static inline double nextRandomDouble(uint64_t& state) {
+    return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/// A small pattern: `cells` has one string per row, 'x' is alive.
+struct Pattern {
+    int rowCount;
+    int colCount;
+    const char* cells[4];
+};
+
+static const Pattern GLIDER = { 3, 3, { ".x.", "..x", "xxx" } };
+static const Pattern BLINKER = { 1, 3, { "xxx" } };
+static const Pattern STILL_LIFES[] = {
+    { 2, 2, { "xx", "xx" } },                   // block
+    { 3, 4, { ".xx.", "x..x", ".xx." } },       // beehive
+    { 3, 3, { "xx.", "x.x", ".x." } },          // boat
+    { 4, 4, { ".xx.", "x..x", ".x.x", "..x." } } // loaf
+};
+
+/// Puts a pattern at (row, col), mirrored if flipRows/flipCols.
+static void putPattern(BitBoard& board, const Pattern& p, int row, int col, bool flipRows = false, bool flipCols = false) {
+    for (int r = 0; r < p.rowCount; r++) {
+        for (int c = 0; c < p.colCount; c++) {
+            if (p.cells[flipRows ? p.rowCount - 1 - r : r][flipCols ? p.colCount - 1 - c : c] == 'x') {
+                board.setCell(row + r, col + c, true);
+            }
+        }
+    }
+}
+
+Benchmark::Benchmark(int rowCount, int colCount) {
+    if (rowCount <= 0 || colCount <= 0) {
+        throw std::runtime_error("Invalid board size " + std::to_string(colCount) + "x" + std::to_string(rowCount));
+    }
+    m_rowCount = rowCount;
+    m_colCount = colCount;
+    m_workloads = getWorkloads();
+    m_modes = getModes();
+    const int hardwareThreads = Board::getDefaultThreadCount();
+    for (int t = 1; t < hardwareThreads; t *= 2) {
+        m_threadCounts.push_back(t);
+    }
+    m_threadCounts.push_back(hardwareThreads);
+}
+
+const std::vector<std::string>& Benchmark::getWorkloads() {
+    static const std::vector<std::string> workloads = { "random", "gliders", "soup", "stilllife" };
+    return workloads;
+}
+
+std::vector<std::string> Benchmark::getModes() {
+    std::vector<std::string> modes = { "seq", "bits", "tiles", "timeblock", "threads", "steal", "hashlife" };
+#if USE_OPENMP
+    modes.push_back("openmp");
+#endif
+#if USE_OPENCL
+    modes.push_back("opencl");
+    modes.push_back("hybrid");
+#endif
+#if USE_PROCESSES
+    modes.push_back("procs");
+#endif
+    return modes;
+}
+
+bool Benchmark::isMultiThreaded(const std::string& mode) {
+    return mode == "timeblock" || mode == "threads" || mode == "steal" || mode == "openmp" || mode == "hybrid" || mode == "procs";
+}
+
+BitBoard Benchmark::makeBoard(const std::string& workload, int rowCount, int colCount, double density, uint64_t seed) {
+    BitBoard board(rowCount, colCount);
+    uint64_t state = seed;
+    if (workload == "random") {
+        for (int row = 0; row < rowCount; row++) {
+            for (int col = 0; col < colCount; col++) {
+                if (nextRandomDouble(state) < density) {
+                    board.setCell(row, col, true);
+                }
+            }
+        }
+    }
+    else if (workload == "gliders") {
+        // One glider in every 16x16 square, flying in a random direction.
+        for (int row = 0; row + 3 <= rowCount; row += 16) {
+            for (int col = 0; col + 3 <= colCount; col += 16) {
+                uint64_t r = nextRandom(state);
+                putPattern(board, GLIDER, row, col, (r & 1) != 0, (r & 2) != 0);
+            }
+        }
+    }
+    else if (workload == "soup") {
+        // A 16x16 soup with 50% alive cells in every 32x32 square.
+        for (int row = 0; row + 16 <= rowCount; row += 32) {
+            for (int col = 0; col + 16 <= colCount; col += 32) {
+                for (int r = 0; r < 16; r++) {
+                    uint64_t bits = nextRandom(state);
+                    for (int c = 0; c < 16; c++) {
+                        if ((bits >> c) & 1) {
+                            board.setCell(row + r, col + c, true);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    else if (workload == "stilllife") {
+        // A still life in every 8x8 square; they are far enough apart not to touch each other.
+        // Every 16th square gets a blinker instead, so the board never becomes completely static.
+        for (int row = 0; row + 6 <= rowCount; row += 8) {
+            for (int col = 0; col + 6 <= colCount; col += 8) {
+                uint64_t r = nextRandom(state);
+                if (r % 16 == 0) {
+                    putPattern(board, BLINKER, row + 3, col + 2);
+                } else {
+                    putPattern(board, STILL_LIFES[(r >> 4) % 4], row + 2, col + 2, ((r >> 8) & 1) != 0, ((r >> 9) & 1) != 0);
+                }
+            }
+        }
+    }
+    else {
+        throw std::runtime_error("Unknown workload " + workload);
+    }
+    return board;
+}
+
+// About the memory measurement:
+// Linux can reset the peak (VmHWM in /proc/self/status) by writing "5" to /proc/self/clear_refs,
+// so every engine gets its own peak (if the kernel allows it). Windows and macOS only have the peak
+// of the whole process.
+
+static void resetPeakMemory() {
+#if defined(__linux__)
+    FILE* f = fopen("/proc/self/clear_refs", "w");
+    if (f != NULL) {
+        fputs("5", f);
+        fclose(f);
+    }
+#endif
+}
+
+static uint64_t getPeakMemory() {
+#if GOL_WIN_ONLY
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#elif defined(__linux__)
+    FILE* f = fopen("/proc/self/status", "r");
+    if (f == NULL) {
+        return 0;
+    }
+    char line[256];
+    unsigned long long kilobytes = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (sscanf(line, "VmHWM: %llu kB", &kilobytes) == 1) {
+            break;
+        }
+    }
+    fclose(f);
+    return kilobytes * 1024;
+#else
+    // ru_maxrss is in bytes on macOS.
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (uint64_t)usage.ru_maxrss;
+#endif
+}
+
+BenchmarkResult Benchmark::runOne(const BitBoard& start, const std::string& workload, const std::string& mode, int threads) const {
+    BenchmarkResult result;
+    result.workload = workload;
+    result.mode = mode;
+    result.threads = threads;
+    result.rowCount = m_rowCount;
+    result.colCount = m_colCount;
+
+    // The bit-packed modes run on a BitBoard, like in main() with a binary file, so they don't convert the board every time.
+    const bool useBitBoard = (mode == "bits" || mode == "timeblock" || mode == "steal" || mode == "opencl" || mode == "hybrid"
+                              || mode == "procs");
+    BitBoard bitBoard;
+    Board board;
+    if (useBitBoard) {
+        bitBoard.copyFrom(start);
+    } else {
+        start.copyTo(board);
+    }
+
+    // The generations are doubled until the time is up, so that the time of one run() call doesn't count much.
+    resetPeakMemory();
+    auto startTime = std::chrono::steady_clock::now();
+    int64_t n = 1;
+    for (;;) {
+        if (mode == "seq") {
+            board.runSingleThreaded((int)n);
+        } else if (mode == "bits") {
+            bitBoard.run((int)n);
+        } else if (mode == "tiles") {
+            board.runTiles((int)n);
+        } else if (mode == "timeblock") {
+            bitBoard.runTimeBlocked((int)n, 8, threads);
+        } else if (mode == "threads") {
+            board.runThreaded((int)n, threads);
+        } else if (mode == "steal") {
+            bitBoard.runWorkStealing((int)n, threads);
+        } else if (mode == "hashlife") {
+            board.runHashLife(n);
+#if USE_OPENMP
+        } else if (mode == "openmp") {
+            board.runOpenMP((int)n, threads);
+#endif
+#if USE_OPENCL
+        } else if (mode == "opencl") {
+            bitBoard.runOpenCL((int)n, BitBoard::DEVICE_TYPE_DONT_CARE);
+        } else if (mode == "hybrid") {
+            bitBoard.runHybrid((int)n, 8, threads, BitBoard::DEVICE_TYPE_DONT_CARE);
+#endif
+#if USE_PROCESSES
+        } else if (mode == "procs") {
+            // One process per thread
+            ProcessRunner(threads, Transport::SHARED_MEMORY).run(bitBoard, (int)n);
+#endif
+        } else {
+            throw std::runtime_error("Mode " + mode + " is not supported by the benchmark");
+        }
+        result.generations += n;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        if (result.seconds >= m_minSeconds || result.generations >= MAX_GENERATIONS) {
+            break;
+        }
+        n = std::min(result.generations, MAX_GENERATIONS - result.generations);
+    }
+    result.peakMemoryBytes = getPeakMemory();
+    return result;
+}
+
+std::vector<BenchmarkResult> Benchmark::run(const std::function<void(const BenchmarkResult&)>& progress) {
+    std::vector<BenchmarkResult> results;
+    for (const std::string& workload : m_workloads) {
+        BitBoard start = makeBoard(workload, m_rowCount, m_colCount, m_density);
+        start.setRule(m_rule);
+        for (const std::string& mode : m_modes) {
+            if (mode == "hashlife" && m_rule.isBorn(0)) {
+                continue;
+            }
+            std::vector<int> threadCounts = isMultiThreaded(mode) ? m_threadCounts : std::vector<int>(1, 1);
+            for (int threads : threadCounts) {
+                results.push_back(runOne(start, workload, mode, threads));
+                if (progress) {
+                    progress(results.back());
+                }
+            }
+        }
+    }
+    return results;
+}
+
+void Benchmark::writeJson(const std::vector<BenchmarkResult>& results, const std::string& path) const {
+    FILE* f = (path == "-") ? stdout : fopen(path.c_str(), "w");
+    if (f == NULL) {
+        throw std::runtime_error("fopen(w) failed for file at " + path);
+    }
+    fprintf(f, "{\n");
+    fprintf(f, "  \"rows\": %d,\n  \"cols\": %d,\n", m_rowCount, m_colCount);
+    fprintf(f, "  \"rule\": \"%s\",\n", m_rule.toString().c_str());
+    fprintf(f, "  \"density\": %g,\n  \"seed\": %llu,\n", m_density, (unsigned long long)DEFAULT_SEED);
+    fprintf(f, "  \"minSeconds\": %g,\n", m_minSeconds);
+    fprintf(f, "  \"hardwareThreads\": %d,\n", Board::getDefaultThreadCount());
+    fprintf(f, "  \"simdKernel\": \"%s\",\n", Board::getSimdKernelName(Board::getSimdKernel()));
+    fprintf(f, "  \"results\": [");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& r = results[i];
+        fprintf(f, "%s\n    { \"workload\": \"%s\", \"mode\": \"%s\", \"threads\": %d, \"generations\": %lld, \"seconds\": %.6f,"
+            " \"generationsPerSecond\": %.6g, \"cellsPerSecond\": %.6g, \"peakMemoryBytes\": %llu }",
+            i == 0 ? "" : ",", r.workload.c_str(), r.mode.c_str(), r.threads, (long long)r.generations, r.seconds,
+            r.getGenerationsPerSecond(), r.getCellsPerSecond(), (unsigned long long)r.peakMemoryBytes);
+    }
+    fprintf(f, "\n  ]\n}\n");
+    bool ok = !ferror(f);
+    if (f == stdout) {
+        ok = fflush(f) == 0 && ok;
+    } else {
+        ok = fclose(f) == 0 && ok;
+    }
+    if (!ok) {
+        throw std::runtime_error("Writing failed for file at " + path);
+    }
+}
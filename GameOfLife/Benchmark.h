@@ -0,0 +1,96 @@
+//
+//  Benchmark.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef Benchmark_h
+#define Benchmark_h
+
+#include "gol-config.h"
+#include "BitBoard.h"
+#include "Rule.h"
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+/// The result of one engine on one workload.
+struct BenchmarkResult {
+    std::string workload;
+    std::string mode;
+    /// 1 for the single-threaded modes.
+    int threads = 1;
+    int rowCount = 0;
+    int colCount = 0;
+    int64_t generations = 0;
+    double seconds = 0;
+    /// The peak memory usage of the process while the engine was running. 0 if it isn't known.
+    /// (On Linux, the peak is reset before every run if possible. Otherwise, it is the peak since the start of the process.)
+    uint64_t peakMemoryBytes = 0;
+
+    inline double getGenerationsPerSecond() const { return seconds > 0 ? generations / seconds : 0; }
+    inline double getCellsPerSecond() const { return getGenerationsPerSecond() * rowCount * colCount; }
+};
+
+/// Runs every engine (and thread count) on a few synthetic boards, so that the engines can be
+/// compared with each other and with older versions of the program.
+/// The boards are generated in-process from a fixed seed, so they are the same in every run.
+class Benchmark
+{
+public:
+    Benchmark(int rowCount, int colCount);
+
+    /// "random" (random cells, see setDensity()), "gliders" (a grid of gliders on an empty board),
+    /// "soup" (small, dense random patches that explode and settle into ash),
+    /// "stilllife" (blocks, beehives, boats and loafs, with a few blinkers)
+    static const std::vector<std::string>& getWorkloads();
+    /// The modes of --mode that are compiled in (without outofcore, which needs files).
+    static std::vector<std::string> getModes();
+    /// @return true if the mode uses --threads.
+    static bool isMultiThreaded(const std::string& mode);
+    /// Generates a board of a workload. The same arguments always give the same board.
+    /// @throws std::runtime_error if the workload doesn't exist.
+    static BitBoard makeBoard(const std::string& workload, int rowCount, int colCount, double density = DEFAULT_DENSITY, uint64_t seed = DEFAULT_SEED);
+
+    /// Runs all combinations of the workloads, modes and thread counts.
+    /// @param progress Called after every combination.
+    std::vector<BenchmarkResult> run(const std::function<void(const BenchmarkResult&)>& progress = nullptr);
+
+    /// Writes the results as JSON (`path` "-" = stdout).
+    /// @throws std::runtime_error if the file can't be written.
+    void writeJson(const std::vector<BenchmarkResult>& results, const std::string& path) const;
+
+    /// (Default: all)
+    void setWorkloads(const std::vector<std::string>& workloads) { m_workloads = workloads; };
+    /// (Default: all of getModes())
+    void setModes(const std::vector<std::string>& modes) { m_modes = modes; };
+    /// For the multi-threaded modes. (Default: 1, 2, 4, ... and the number of hardware threads)
+    void setThreadCounts(const std::vector<int>& threadCounts) { m_threadCounts = threadCounts; };
+    /// Every engine runs for at least this long. (Default: 1 second)
+    void setMinSeconds(double seconds) { m_minSeconds = seconds; };
+    /// For the "random" workload. (Default: 0.3)
+    void setDensity(double density) { m_density = density; };
+    void setRule(const Rule& rule) { m_rule = rule; };
+
+    static constexpr double DEFAULT_DENSITY = 0.3;
+    static const uint64_t DEFAULT_SEED = 20171206;
+    /// No engine calculates more generations than this, even if it is faster than the time limit.
+    static const int64_t MAX_GENERATIONS = (int64_t)1 << 30;
+
+private:
+    BenchmarkResult runOne(const BitBoard& start, const std::string& workload, const std::string& mode, int threads) const;
+
+    int m_rowCount;
+    int m_colCount;
+    std::vector<std::string> m_workloads;
+    std::vector<std::string> m_modes;
+    std::vector<int> m_threadCounts;
+    double m_minSeconds = 1.0;
+    double m_density = DEFAULT_DENSITY;
+    Rule m_rule;
+};
+
+#endif // Benchmark_h
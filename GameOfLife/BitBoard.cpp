@@ -0,0 +1,421 @@
+//
+//  BitBoard.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "BitBoard.h"
+#include "Board.h"
+#include "Hash.h"
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <utility>
+
+BitBoard::BitBoard(int rowCount, int colCount) {
+    m_rowCount = rowCount;
+    m_colCount = colCount;
+    m_wordsPerRow = (colCount + 63) / 64;
+    m_words.resize((size_t)rowCount * m_wordsPerRow, 0);
+}
+
+BitBoard::BitBoard(const Board& board) {
+    copyFrom(board);
+}
+
+void BitBoard::setCell(int row, int col, bool isAlive) {
+    forgetPreviousGeneration();
+    uint64_t mask = (uint64_t)1 << (col & 63);
+    if (isAlive) {
+        m_words[getWordIndex(row, col)] |= mask;
+    } else {
+        m_words[getWordIndex(row, col)] &= ~mask;
+    }
+}
+
+/// Copies `count` bits from bit `srcBit` of `src` to bit `dstBit` of `dst`. The other bits of `dst` stay the same.
+static void copyBits(const uint64_t* src, size_t srcBit, uint64_t* dst, size_t dstBit, size_t count) {
+    while (count > 0) {
+        size_t w = dstBit >> 6;
+        int shift = (int)(dstBit & 63);
+        size_t n = std::min((size_t)(64 - shift), count);
+        // The next n bits of src
+        size_t sw = srcBit >> 6;
+        int sShift = (int)(srcBit & 63);
+        uint64_t bits = src[sw] >> sShift;
+        if (sShift != 0 && sShift + n > 64) {
+            bits |= src[sw + 1] << (64 - sShift);
+        }
+        uint64_t mask = ((n == 64) ? ~(uint64_t)0 : (((uint64_t)1 << n) - 1)) << shift;
+        dst[w] = (dst[w] & ~mask) | ((bits << shift) & mask);
+        srcBit += n;
+        dstBit += n;
+        count -= n;
+    }
+}
+
+void BitBoard::setRegion(int row, int col, int rowCount, int colCount, const uint64_t* src, size_t srcWordsPerRow) {
+    forgetPreviousGeneration();
+    for (int r = 0; r < rowCount; r++) {
+        copyBits(src + (size_t)r * srcWordsPerRow, 0, getRow(row + r), col, colCount);
+    }
+}
+
+void BitBoard::getRegion(int row, int col, int rowCount, int colCount, uint64_t* dst, size_t dstWordsPerRow) const {
+    if (colCount <= 0) {
+        return;
+    }
+    for (int r = 0; r < rowCount; r++) {
+        uint64_t* out = dst + (size_t)r * dstWordsPerRow;
+        out[(colCount - 1) >> 6] = 0;
+        copyBits(getRow(row + r), col, out, 0, colCount);
+    }
+}
+
+uint64_t BitBoard::getPopulation() const {
+    uint64_t population = 0;
+    for (uint64_t w : m_words) {
+        population += popCount(w);
+    }
+    return population;
+}
+
+GenerationStats BitBoard::getStats() const {
+    GenerationStats stats;
+    stats.population = getPopulation();
+    if (m_nextIsPrevious) {
+        for (size_t i = 0; i < m_words.size(); i++) {
+            stats.births += popCount(m_words[i] & ~m_next[i]);
+            stats.deaths += popCount(m_next[i] & ~m_words[i]);
+        }
+    } else {
+        stats.births = m_births;
+        stats.deaths = m_deaths;
+    }
+    return stats;
+}
+
+void BitBoard::forgetPreviousGeneration() {
+    markChanged();
+    m_nextIsPrevious = false;
+    m_births = 0;
+    m_deaths = 0;
+}
+
+void BitBoard::copyTo(Board& board) const {
+    board = Board(m_rowCount, m_colCount);
+    board.setRule(m_rule);
+    for (int row = 0; row < m_rowCount; row++) {
+        char* cells = &board.m_cells[(size_t)row * m_colCount];
+        const uint64_t* words = getRow(row);
+        for (int col = 0; col < m_colCount; col++) {
+            cells[col] = (char)((words[col >> 6] >> (col & 63)) & 1);
+        }
+    }
+    board.rebuildNeighbourCounts();
+    GenerationStats stats = getStats();
+    board.m_stats.births = stats.births;
+    board.m_stats.deaths = stats.deaths;
+}
+
+void BitBoard::copyFrom(const Board& board) {
+    if (m_rowCount != board.getRowCount() || m_colCount != board.getColCount()) {
+        *this = BitBoard(board.getRowCount(), board.getColCount());
+    }
+    forgetPreviousGeneration();
+    m_rule = board.getRule();
+    for (int row = 0; row < m_rowCount; row++) {
+        const char* cells = &board.m_cells[(size_t)row * m_colCount];
+        uint64_t* words = getRow(row);
+        memset(words, 0, m_wordsPerRow * sizeof(uint64_t));
+        for (int col = 0; col < m_colCount; col++) {
+            words[col >> 6] |= (uint64_t)(cells[col] & 1) << (col & 63);
+        }
+    }
+}
+
+void BitBoard::copyFrom(const BitBoard& board) {
+    if (m_rowCount != board.m_rowCount || m_colCount != board.m_colCount) {
+        *this = BitBoard(board.m_rowCount, board.m_colCount);
+    }
+    forgetPreviousGeneration();
+    m_rule = board.m_rule;
+    std::copy(board.m_words.begin(), board.m_words.end(), m_words.begin());
+}
+
+void BitBoard::nextGeneration() {
+    run(1);
+}
+
+void BitBoard::run(int numberOfGenerations) {
+    if (numberOfGenerations <= 0 || m_words.empty()) {
+        return;
+    }
+    m_next.resize(m_words.size());
+    for (int i = 0; i < numberOfGenerations; i++) {
+        nextGeneration(&m_words[0], &m_next[0], 0, m_rowCount);
+        std::swap(m_words, m_next);
+    }
+    m_nextIsPrevious = true;
+    markChanged();
+}
+
+// About temporal blocking:
+// A band of rows [b, e) after k generations depends on the rows [b-k, e+k) of the current
+// generation (with wrap-around). These rows are copied into a buffer, and every generation
+// is calculated on the buffer: after generation g, only the rows [g, rows-g) of the buffer are
+// still correct, so the buffer shrinks by one row at the top and at the bottom (a trapezoid).
+// The rows at the edge are calculated more than once, that's the price for reading and writing
+// the whole board only once every k generations. All bands are independent, so the threads just
+// take the next band that no one took yet.
+
+void BitBoard::runTimeBlocked(int numberOfGenerations, int timeBlock, int numberOfThreads) {
+    if (numberOfGenerations <= 0 || m_words.empty()) {
+        return;
+    }
+    timeBlock = std::max(1, std::min(timeBlock, numberOfGenerations));
+    numberOfThreads = std::max(1, numberOfThreads);
+    const int bandRows = getBandRows(timeBlock);
+    const int bandCount = (m_rowCount + bandRows - 1) / bandRows;
+    numberOfThreads = std::min(numberOfThreads, bandCount);
+    const size_t bufferWords = 2 * (size_t)(bandRows + 2 * timeBlock) * m_wordsPerRow;
+
+    m_next.resize(m_words.size());
+    std::vector<std::vector<uint64_t>> buffers(numberOfThreads, std::vector<uint64_t>(bufferWords));
+    // The previous generation only exists in the buffers, so the births and deaths are counted there.
+    std::vector<GenerationStats> counts(numberOfThreads);
+    for (int done = 0; done < numberOfGenerations; done += timeBlock) {
+        const int generations = std::min(timeBlock, numberOfGenerations - done);
+        const bool isLastBlock = done + generations == numberOfGenerations;
+        std::atomic<int> nextBand(0);
+        auto worker = [&](int i) {
+            for (int band = nextBand++; band < bandCount; band = nextBand++) {
+                int bandBegin = band * bandRows;
+                int bandEnd = std::min(bandBegin + bandRows, m_rowCount);
+                runBand(&m_words[0], &m_next[0], bandBegin, bandEnd, generations, &buffers[i][0], isLastBlock ? &counts[i] : nullptr);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int i = 1; i < numberOfThreads; i++) {
+            threads.push_back(std::thread(worker, i));
+        }
+        worker(0);
+        for (auto& t : threads) {
+            t.join();
+        }
+        std::swap(m_words, m_next);
+    }
+    forgetPreviousGeneration();
+    for (const GenerationStats& c : counts) {
+        m_births += c.births;
+        m_deaths += c.deaths;
+    }
+}
+
+int BitBoard::getBandRows(int timeBlock) const {
+    const size_t rowBytes = (size_t)m_wordsPerRow * sizeof(uint64_t);
+    // Two buffers of bandRows + 2*timeBlock rows each should fit into the cache,
+    // but the band should be at least as big as the halo, or most of the work is wasted.
+    int rowsInCache = (int)std::min((size_t)m_rowCount + 2 * timeBlock, TIME_BLOCK_CACHE_BYTES / 2 / rowBytes);
+    return std::min(std::max(rowsInCache - 2 * timeBlock, 2 * timeBlock), m_rowCount);
+}
+
+void BitBoard::runBand(const uint64_t* src, uint64_t* dst, int bandBegin, int bandEnd, int generations, uint64_t* buffer,
+                       GenerationStats* counts) const {
+    const size_t nw = m_wordsPerRow;
+    const int rows = bandEnd - bandBegin + 2 * generations;
+    uint64_t* cur = buffer;
+    uint64_t* next = buffer + (size_t)rows * nw;
+
+    int srcRow = ((bandBegin - generations) % m_rowCount + m_rowCount) % m_rowCount;
+    for (int i = 0; i < rows; i++) {
+        memcpy(cur + i * nw, src + (size_t)srcRow * nw, nw * sizeof(uint64_t));
+        srcRow = (srcRow == m_rowCount - 1) ? 0 : srcRow + 1;
+    }
+    for (int g = 1; g < generations; g++) {
+        for (int i = g; i < rows - g; i++) {
+            nextGenerationRow(cur + (i - 1) * nw, cur + i * nw, cur + (i + 1) * nw, next + i * nw, m_colCount, m_rule);
+        }
+        std::swap(cur, next);
+    }
+    // The last generation goes directly into the board.
+    for (int i = generations; i < rows - generations; i++) {
+        uint64_t* out = dst + (size_t)(bandBegin + i - generations) * nw;
+        nextGenerationRow(cur + (i - 1) * nw, cur + i * nw, cur + (i + 1) * nw, out, m_colCount, m_rule);
+        if (counts != nullptr) {
+            const uint64_t* previous = cur + i * nw;
+            for (size_t w = 0; w < nw; w++) {
+                counts->births += popCount(out[w] & ~previous[w]);
+                counts->deaths += popCount(previous[w] & ~out[w]);
+            }
+        }
+    }
+}
+
+// About the bit-sliced logic:
+// For every cell, the eight neighbours are added with full adders. All 64 cells
+// of a word are added in parallel: bit i of every variable belongs to cell i.
+//
+//   row above: aW + aC + aE = a0 + 2*a1   (full adder)
+//   this row:  bW      + bE = b0 + 2*b1   (half adder)
+//   row below: cW + cC + cE = c0 + 2*c1   (full adder)
+//
+// The ones add up to s0 + 2*k (full adder again), so the neighbour count is
+// s0 + 2*(a1 + b1 + c1 + k). For Conway's Game of Life, the count is 2 or 3 exactly
+// if one of a1, b1, c1, k is set. A cell is alive in the next generation if its
+// count is 3, or if it is 2 and the cell is alive right now.
+// For all other rules, a1 + b1 + c1 + k is added up too, which gives the count as
+// 4 bit planes. Then the counts of the rule are compared with these bit planes.
+
+/// The west neighbours of the cells in word `w`, i.e. bit i is the cell left of bit i.
+static inline uint64_t westOf(const uint64_t* row, int w, int wordsPerRow, int lastBit) {
+    uint64_t carry = (w == 0) ? (row[wordsPerRow - 1] >> lastBit) : (row[w - 1] >> 63);
+    return (row[w] << 1) | (carry & 1);
+}
+
+/// The east neighbours of the cells in word `w`, i.e. bit i is the cell right of bit i.
+static inline uint64_t eastOf(const uint64_t* row, int w, int wordsPerRow, int lastBit) {
+    if (w == wordsPerRow - 1) {
+        return (row[w] >> 1) | ((row[0] & 1) << lastBit);
+    }
+    return (row[w] >> 1) | (row[w + 1] << 63);
+}
+
+/// Conway's Game of Life.
+static inline uint64_t nextWord(const LifeRule&, uint64_t aW, uint64_t aC, uint64_t aE,
+                                uint64_t bW, uint64_t bC, uint64_t bE,
+                                uint64_t cW, uint64_t cC, uint64_t cE) {
+    uint64_t aX = aW ^ aE;
+    uint64_t a0 = aX ^ aC;
+    uint64_t a1 = (aW & aE) | (aX & aC);
+    uint64_t b0 = bW ^ bE;
+    uint64_t b1 = bW & bE;
+    uint64_t cX = cW ^ cE;
+    uint64_t c0 = cX ^ cC;
+    uint64_t c1 = (cW & cE) | (cX & cC);
+
+    uint64_t sX = a0 ^ b0;
+    uint64_t s0 = sX ^ c0;
+    uint64_t k = (a0 & b0) | (sX & c0);
+
+    uint64_t x1 = a1 ^ b1;
+    uint64_t y1 = a1 & b1;
+    uint64_t x2 = c1 ^ k;
+    uint64_t y2 = c1 & k;
+    uint64_t exactlyOne = (x1 ^ x2) & ~(y1 | y2);
+
+    return exactlyOne & (s0 | bC);
+}
+
+/// Any other rule.
+template <class R>
+static inline uint64_t nextWord(const R& rule, uint64_t aW, uint64_t aC, uint64_t aE,
+                                uint64_t bW, uint64_t bC, uint64_t bE,
+                                uint64_t cW, uint64_t cC, uint64_t cE) {
+    uint64_t aX = aW ^ aE;
+    uint64_t a0 = aX ^ aC;
+    uint64_t a1 = (aW & aE) | (aX & aC);
+    uint64_t b0 = bW ^ bE;
+    uint64_t b1 = bW & bE;
+    uint64_t cX = cW ^ cE;
+    uint64_t c0 = cX ^ cC;
+    uint64_t c1 = (cW & cE) | (cX & cC);
+
+    uint64_t sX = a0 ^ b0;
+    uint64_t s0 = sX ^ c0;
+    uint64_t k = (a0 & b0) | (sX & c0);
+
+    // a1 + b1 + c1 + k = n1 + 2*(t1 + u1) = n1 + 2*n2 + 4*n3
+    uint64_t tX = a1 ^ b1;
+    uint64_t t0 = tX ^ c1;
+    uint64_t t1 = (a1 & b1) | (tX & c1);
+    uint64_t n1 = t0 ^ k;
+    uint64_t u1 = t0 & k;
+    uint64_t n2 = t1 ^ u1;
+    uint64_t n3 = t1 & u1;
+
+    auto countIs = [&](int n) {
+        return ((n & 1) ? s0 : ~s0) & ((n & 2) ? n1 : ~n1) & ((n & 4) ? n2 : ~n2) & ((n & 8) ? n3 : ~n3);
+    };
+    uint64_t born = 0;
+    uint64_t survives = 0;
+    forEachBirthCount(rule, [&](int n) { born |= countIs(n); });
+    forEachSurvivalCount(rule, [&](int n) { survives |= countIs(n); });
+    return (bC & survives) | (~bC & born);
+}
+
+void BitBoard::nextGeneration(const uint64_t* src, uint64_t* dst, int rowBegin, int rowEnd) const {
+    const int nw = m_wordsPerRow;
+    for (int row = rowBegin; row < rowEnd; row++) {
+        int rowAbove = (row == 0) ? m_rowCount - 1 : row - 1;
+        int rowBelow = (row == m_rowCount - 1) ? 0 : row + 1;
+        nextGenerationRow(src + (size_t)rowAbove * nw, src + (size_t)row * nw, src + (size_t)rowBelow * nw,
+                          dst + (size_t)row * nw, m_colCount, m_rule);
+    }
+}
+
+template <class R>
+static void nextGenerationWordsWithRule(const R& rule, const uint64_t* a, const uint64_t* b, const uint64_t* c, uint64_t* out,
+                                        int colCount, int wordBegin, int wordEnd) {
+    const int nw = (colCount + 63) / 64;
+    const int lastBit = (colCount - 1) & 63;
+    const uint64_t lastMask = (lastBit == 63) ? ~(uint64_t)0 : (((uint64_t)1 << (lastBit + 1)) - 1);
+
+    // The first and the last word need the wrap-around, everything in between is straightforward.
+    int w = wordBegin;
+    if (w == 0 && w < wordEnd) {
+        out[0] = nextWord(rule, westOf(a, 0, nw, lastBit), a[0], eastOf(a, 0, nw, lastBit),
+                          westOf(b, 0, nw, lastBit), b[0], eastOf(b, 0, nw, lastBit),
+                          westOf(c, 0, nw, lastBit), c[0], eastOf(c, 0, nw, lastBit));
+        w++;
+    }
+    const int innerEnd = std::min(wordEnd, nw - 1);
+    for (; w < innerEnd; w++) {
+        out[w] = nextWord(rule, (a[w] << 1) | (a[w - 1] >> 63), a[w], (a[w] >> 1) | (a[w + 1] << 63),
+                          (b[w] << 1) | (b[w - 1] >> 63), b[w], (b[w] >> 1) | (b[w + 1] << 63),
+                          (c[w] << 1) | (c[w - 1] >> 63), c[w], (c[w] >> 1) | (c[w + 1] << 63));
+    }
+    if (w < wordEnd) {
+        // w is the last word, and it's not the first one.
+        out[w] = nextWord(rule, westOf(a, w, nw, lastBit), a[w], eastOf(a, w, nw, lastBit),
+                          westOf(b, w, nw, lastBit), b[w], eastOf(b, w, nw, lastBit),
+                          westOf(c, w, nw, lastBit), c[w], eastOf(c, w, nw, lastBit));
+    }
+    if (wordEnd == nw) {
+        out[nw - 1] &= lastMask;
+    }
+}
+
+void BitBoard::nextGenerationRow(const uint64_t* a, const uint64_t* b, const uint64_t* c, uint64_t* out, int colCount,
+                                 const Rule& rule) {
+    nextGenerationWords(a, b, c, out, colCount, 0, (colCount + 63) / 64, rule);
+}
+
+void BitBoard::nextGenerationWords(const uint64_t* a, const uint64_t* b, const uint64_t* c, uint64_t* out, int colCount,
+                                   int wordBegin, int wordEnd, const Rule& rule) {
+    withStaticRule(rule, [&](const auto& r) {
+        nextGenerationWordsWithRule(r, a, b, c, out, colCount, wordBegin, wordEnd);
+    });
+}
+
+uint64_t BitBoard::newVersion() {
+    static std::atomic<uint64_t> lastVersion(0);
+    return ++lastVersion;
+}
+
+uint64_t BitBoard::getHash() const {
+    XxHash64 hash;
+    int32_t size[2] = { m_rowCount, m_colCount };
+    hash.update(size, sizeof(size));
+    if (!m_words.empty()) {
+        hash.update(&m_words[0], m_words.size() * sizeof(uint64_t));
+    }
+    return hash.digest();
+}
+
+bool operator==(const BitBoard& b1, const BitBoard& b2) {
+    return b1.m_rowCount == b2.m_rowCount && b1.m_colCount == b2.m_colCount && b1.m_words == b2.m_words;
+}
@@ -0,0 +1,217 @@
+//
+//  BitBoard.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef BitBoard_h
+#define BitBoard_h
+
+#include "gol-config.h"
+#include "Rule.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+class Board;
+
+/// The counters of a board. (See Board::getStats() and BitBoard::getStats())
+struct GenerationStats {
+    /// The number of alive cells.
+    uint64_t population = 0;
+    /// The number of cells that were born and that died in the last generation.
+    uint64_t births = 0;
+    uint64_t deaths = 0;
+};
+
+/// A bit-packed "Game of Life" board with the same wrap-around semantics as `Board`.
+/// Every row is stored as an array of 64-bit words, one bit per cell, so the board
+/// needs 8 times less memory than a `Board`. The next generation is calculated with
+/// bit-sliced adder logic, 64 cells at a time, without any per-cell branching.
+class BitBoard
+{
+public:
+    /// Creates an empty (useless) board with zero size.
+    BitBoard() = default;
+    /// Creates an empty board of a particular size
+    BitBoard(int rowCount, int colCount);
+    /// Creates a packed copy of a `Board`.
+    explicit BitBoard(const Board& board);
+
+    inline int getRowCount() const { return m_rowCount; }
+    inline int getColCount() const { return m_colCount; }
+    inline int getWordsPerRow() const { return m_wordsPerRow; }
+
+    /// @return true if the cell is alive, false otherwise.
+    inline bool getCell(int row, int col) const {
+        return (m_words[getWordIndex(row, col)] >> (col & 63)) & 1;
+    };
+    void setCell(int row, int col, bool isAlive);
+
+    /// Copies a rectangle of `rowCount` x `colCount` cells into the board, with its top-left cell at (row, col).
+    /// Row r of the rectangle starts at `src + r * srcWordsPerRow`, in the layout of getRow(). The rectangle
+    /// must be inside the board. The bits are shifted a word at a time, if `col` isn't a multiple of 64.
+    void setRegion(int row, int col, int rowCount, int colCount, const uint64_t* src, size_t srcWordsPerRow);
+    /// The opposite of setRegion(). Bits beyond the last column of the rectangle are set to 0.
+    void getRegion(int row, int col, int rowCount, int colCount, uint64_t* dst, size_t dstWordsPerRow) const;
+    /// The number of alive cells.
+    uint64_t getPopulation() const;
+    /// The population, and the births and deaths of the last generation. The population is counted
+    /// when this is called; the births and deaths are compared with the previous generation, which
+    /// run() and runWorkStealing() keep anyway, or were counted by runTimeBlocked().
+    /// They are 0 before the first generation and after setCell() or setRegion().
+    GenerationStats getStats() const;
+
+    /// The rule that all engines use. (Default: Conway's Game of Life, B3/S23)
+    inline const Rule& getRule() const { return m_rule; }
+    inline void setRule(const Rule& rule) { m_rule = rule; }
+
+    /// Calculates the next generation.
+    void nextGeneration();
+    void run(int numberOfGenerations);
+    /// Like run(), but with temporal blocking: a band of rows (plus `timeBlock` rows above and below)
+    /// is copied into a small buffer and advanced by `timeBlock` generations while it is in the cache.
+    /// The board itself is read and written only once every `timeBlock` generations.
+    /// The bands are shared by `numberOfThreads` threads.
+    void runTimeBlocked(int numberOfGenerations, int timeBlock, int numberOfThreads = 1);
+    /// The size of the buffers of one band in runTimeBlocked(). Should fit into the L2 cache.
+    static const size_t TIME_BLOCK_CACHE_BYTES = 512 * 1024;
+
+    /// What one thread did in runWorkStealing().
+    struct ThreadStats {
+        /// Time spent calculating tiles (and looking for tiles to steal).
+        double busySeconds = 0;
+        /// Time spent waiting for the other threads.
+        double idleSeconds = 0;
+        long long tileCount = 0;
+        /// How many of the tiles were stolen from other threads.
+        long long stolenTileCount = 0;
+    };
+    /// Multi-threaded, and only calculates the tiles that can change (like Board::runTiles()).
+    /// The active tiles are shared by the threads with work stealing, so the threads are busy
+    /// even if the active tiles are all in one part of the board. (Implemented in BitBoard_tiles.cpp)
+    /// @param stats If not null, receives one entry per thread.
+    void runWorkStealing(int numberOfGenerations, int numberOfThreads, std::vector<ThreadStats>* stats = nullptr);
+
+    enum OpenCLDeviceType {
+        DEVICE_TYPE_DONT_CARE,
+        DEVICE_TYPE_CPU_ONLY,
+        DEVICE_TYPE_GPU_ONLY
+    };
+
+#if USE_OPENCL
+    /// Runs on an OpenCL device. The words are copied to the device as they are, so this transfers
+    /// 8 times less than Board::runOpenCL(). (Implemented in Board_opencl.cpp)
+    /// @throws std::runtime_error if there is no such device, or OpenCL fails.
+    void runOpenCL(int numberOfGenerations, OpenCLDeviceType deviceType, bool verbose = false);
+
+    /// What runHybrid() did.
+    struct HybridStats {
+        /// The number of rows that the device calculated at the end (the CPU threads calculated the others).
+        int deviceRows = 0;
+        /// How long the device (with the halo exchange) and the CPU threads were busy.
+        double deviceSeconds = 0;
+        double cpuSeconds = 0;
+        /// How often the rows were split again while tuning.
+        int resplitCount = 0;
+    };
+    /// Calculates a band of rows on an OpenCL device and the other rows with `numberOfThreads` CPU threads
+    /// (like runTimeBlocked()), at the same time. The halo rows are exchanged every `timeBlock` generations,
+    /// and the split is tuned from the measured speed of both. The births and deaths aren't counted, like
+    /// in runOpenCL(). (Implemented in Board_opencl.cpp)
+    /// @param stats If not null, receives what the device and the threads did.
+    /// @throws std::runtime_error if there is no such device, or OpenCL fails.
+    void runHybrid(int numberOfGenerations, int timeBlock, int numberOfThreads, OpenCLDeviceType deviceType,
+                   HybridStats* stats = nullptr, bool verbose = false);
+#endif
+
+    /// Replaces the contents of `board` with the contents of this board.
+    void copyTo(Board& board) const;
+    /// Replaces the cells and the rule of this board with those of `board`. The memory of this
+    /// board is reused if it has the same size, so a board can be copied again and again without allocations.
+    void copyFrom(const Board& board);
+    void copyFrom(const BitBoard& board);
+
+    /// Direct access to the words of one row. Bit `i` of word `w` is the cell in column `w*64 + i`.
+    /// Bits beyond the last column are always 0. Call markChanged() after writing to the rows.
+    inline uint64_t* getRow(int row) { return &m_words[(size_t)row * m_wordsPerRow]; };
+    inline const uint64_t* getRow(int row) const { return &m_words[(size_t)row * m_wordsPerRow]; };
+
+    /// Calculates one row of the next generation from the row above, the row itself and the row below
+    /// (all in the layout of getRow()). This is the whole engine, for callers that keep rows elsewhere.
+    static void nextGenerationRow(const uint64_t* above, const uint64_t* row, const uint64_t* below, uint64_t* out, int colCount,
+                                  const Rule& rule);
+    /// Like nextGenerationRow(), but only calculates the words [wordBegin, wordEnd) of the row.
+    static void nextGenerationWords(const uint64_t* above, const uint64_t* row, const uint64_t* below, uint64_t* out, int colCount,
+                                    int wordBegin, int wordEnd, const Rule& rule);
+
+    static inline int popCount(uint64_t x) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return (int)__popcnt64(x);
+#elif defined(_MSC_VER)
+        return (int)(__popcnt((unsigned int)x) + __popcnt((unsigned int)(x >> 32)));
+#else
+        return __builtin_popcountll(x);
+#endif
+    }
+
+    /// XXH64 of the row count and the column count (32-bit little-endian each),
+    /// followed by all rows as returned by getRow().
+    uint64_t getHash() const;
+
+    /// A number that changes whenever the cells change. A copy has the same version as the original,
+    /// until one of them changes; two boards with the same version have the same cells. runOpenCL()
+    /// uses it to see if the device still has the board.
+    inline uint64_t getVersion() const { return m_version; }
+    /// Gives the board a new version, after the rows were changed through getRow().
+    void markChanged() { m_version = newVersion(); }
+    /// A version that no board had before. (Thread-safe)
+    static uint64_t newVersion();
+
+    friend bool operator==(const BitBoard& b1, const BitBoard& b2);
+
+private:
+    /// Calculates the rows [rowBegin, rowEnd) of the next generation.
+    /// Reads from `src` and writes to `dst`, which must not overlap.
+    void nextGeneration(const uint64_t* src, uint64_t* dst, int rowBegin, int rowEnd) const;
+    /// Calculates the rows [bandBegin, bandEnd) of the generation that is `generations` generations
+    /// after `src`. `buffer` must have room for 2 * (bandEnd - bandBegin + 2 * generations) rows.
+    /// If `counts` isn't null, the births and deaths of the last of these generations are added to it.
+    void runBand(const uint64_t* src, uint64_t* dst, int bandBegin, int bandEnd, int generations, uint64_t* buffer,
+                 GenerationStats* counts) const;
+    /// The number of rows of the bands of runBand(), so that the buffer of a band fits into TIME_BLOCK_CACHE_BYTES.
+    int getBandRows(int timeBlock) const;
+
+    /// For getStats(): the board was changed by something other than a generation.
+    void forgetPreviousGeneration();
+
+    inline size_t getWordIndex(int row, int col) const {
+        return (size_t)row * m_wordsPerRow + (col >> 6);
+    };
+
+    int m_rowCount = 0;
+    int m_colCount = 0;
+    int m_wordsPerRow = 0;
+    std::vector<uint64_t> m_words;
+    /// Scratch buffer for the next generation. m_words and m_next are swapped after every generation.
+    std::vector<uint64_t> m_next;
+    /// For getStats(): whether m_next has the previous generation. If not, the births and deaths
+    /// of the last generation are in m_births and m_deaths.
+    bool m_nextIsPrevious = false;
+    uint64_t m_births = 0;
+    uint64_t m_deaths = 0;
+    Rule m_rule;
+    uint64_t m_version = newVersion();
+};
+
+bool operator==(const BitBoard& b1, const BitBoard& b2);
+inline bool operator!=(const BitBoard& b1, const BitBoard& b2) {
+    return !(b1 == b2);
+}
+
+#endif // BitBoard_h
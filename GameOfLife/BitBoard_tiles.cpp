@@ -0,0 +1,194 @@
+//
+//  BitBoard_tiles.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "BitBoard.h"
+#include "Barrier.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+// About the tiles:
+// The board is divided into tiles of TILE_ROWS rows and TILE_WORDS words (64 cells each).
+// Like in Board::runTiles(), a tile can only change in this generation if it or one of its
+// 8 neighbour tiles changed in the previous generation; all other tiles are skipped.
+// A skipped tile doesn't even have to be copied: the board is double-buffered, and the
+// other buffer holds the generation before, which is the same for a tile that didn't change.
+//
+// About the scheduling:
+// Every generation, the active tiles are dealt out to the threads in contiguous chunks,
+// one queue per thread. A thread takes tiles from the front of its own queue. When it is
+// empty, the thread steals from the back of the other queues, so a thread with a "hot"
+// chunk doesn't keep the others waiting at the barrier. No tiles are added during a
+// generation, so a thread is done when all queues are empty.
+
+static const int TILE_ROWS = 64;
+static const int TILE_WORDS = 16;
+
+namespace {
+
+/// The tiles of one thread. The owner takes from the front, thieves take from the back.
+class TileQueue
+{
+public:
+    void assign(const int* begin, const int* end) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tiles.assign(begin, end);
+        m_front = 0;
+    }
+
+    bool takeFront(int& tile) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_front == m_tiles.size()) {
+            return false;
+        }
+        tile = m_tiles[m_front++];
+        return true;
+    }
+
+    bool takeBack(int& tile) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_front == m_tiles.size()) {
+            return false;
+        }
+        tile = m_tiles.back();
+        m_tiles.pop_back();
+        return true;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<int> m_tiles;
+    size_t m_front = 0;
+};
+
+}
+
+void BitBoard::runWorkStealing(int numberOfGenerations, int numberOfThreads, std::vector<ThreadStats>* stats) {
+    typedef std::chrono::high_resolution_clock Clock;
+
+    numberOfThreads = std::max(1, numberOfThreads);
+    if (stats != nullptr) {
+        stats->assign(numberOfThreads, ThreadStats());
+    }
+    if (numberOfGenerations <= 0 || m_words.empty()) {
+        return;
+    }
+
+    const int nw = m_wordsPerRow;
+    const int tileRowCount = (m_rowCount + TILE_ROWS - 1) / TILE_ROWS;
+    const int tileColCount = (nw + TILE_WORDS - 1) / TILE_WORDS;
+    const int tileCount = tileRowCount * tileColCount;
+
+    m_next.resize(m_words.size());
+    // In the first generation, we don't know what changed before, so everything is active.
+    std::vector<char> tileChanged(tileCount, 1);
+    std::vector<int> activeTiles;
+    std::vector<TileQueue> queues(numberOfThreads);
+    std::vector<ThreadStats> threadStats(numberOfThreads);
+    Barrier barrier(numberOfThreads);
+
+    // Runs on thread 0 between the generations.
+    auto dealActiveTiles = [&]() {
+        activeTiles.clear();
+        for (int tRow = 0; tRow < tileRowCount; tRow++) {
+            int rowAbove = (tRow == 0) ? tileRowCount - 1 : tRow - 1;
+            int rowBelow = (tRow == tileRowCount - 1) ? 0 : tRow + 1;
+            for (int tCol = 0; tCol < tileColCount; tCol++) {
+                int colLeft = (tCol == 0) ? tileColCount - 1 : tCol - 1;
+                int colRight = (tCol == tileColCount - 1) ? 0 : tCol + 1;
+                bool active = false;
+                for (int r : { rowAbove, tRow, rowBelow }) {
+                    const char* changed = &tileChanged[r * tileColCount];
+                    active = active || changed[colLeft] || changed[tCol] || changed[colRight];
+                }
+                if (active) {
+                    activeTiles.push_back(tRow * tileColCount + tCol);
+                }
+            }
+        }
+        const int* tiles = activeTiles.data();
+        for (int i = 0; i < numberOfThreads; i++) {
+            size_t begin = activeTiles.size() * i / numberOfThreads;
+            size_t end = activeTiles.size() * (i + 1) / numberOfThreads;
+            queues[i].assign(tiles + begin, tiles + end);
+        }
+    };
+
+    auto calculateTile = [&](int tile, const uint64_t* src, uint64_t* dst) {
+        int rowBegin = (tile / tileColCount) * TILE_ROWS;
+        int rowEnd = std::min(rowBegin + TILE_ROWS, m_rowCount);
+        int wordBegin = (tile % tileColCount) * TILE_WORDS;
+        int wordEnd = std::min(wordBegin + TILE_WORDS, nw);
+        uint64_t diff = 0;
+        for (int row = rowBegin; row < rowEnd; row++) {
+            int rowAbove = (row == 0) ? m_rowCount - 1 : row - 1;
+            int rowBelow = (row == m_rowCount - 1) ? 0 : row + 1;
+            const uint64_t* in = src + (size_t)row * nw;
+            uint64_t* out = dst + (size_t)row * nw;
+            nextGenerationWords(src + (size_t)rowAbove * nw, in, src + (size_t)rowBelow * nw, out, m_colCount, wordBegin, wordEnd, m_rule);
+            for (int w = wordBegin; w < wordEnd; w++) {
+                diff |= in[w] ^ out[w];
+            }
+        }
+        // Different threads write different bytes, that's fine.
+        tileChanged[tile] = (diff != 0);
+    };
+
+    auto worker = [&](int i) {
+        ThreadStats& myStats = threadStats[i];
+        Clock::time_point start = Clock::now();
+        for (int gIdx = 0; gIdx < numberOfGenerations; gIdx++) {
+            Clock::time_point busyStart = Clock::now();
+            if (i == 0) {
+                dealActiveTiles();
+            }
+            barrier.wait();
+
+            busyStart = (i == 0) ? busyStart : Clock::now();
+            const uint64_t* src = &m_words[0];
+            uint64_t* dst = &m_next[0];
+            int tile;
+            while (queues[i].takeFront(tile)) {
+                calculateTile(tile, src, dst);
+                myStats.tileCount++;
+            }
+            for (int k = 1; k < numberOfThreads; k++) {
+                TileQueue& victim = queues[(i + k) % numberOfThreads];
+                while (victim.takeBack(tile)) {
+                    calculateTile(tile, src, dst);
+                    myStats.tileCount++;
+                    myStats.stolenTileCount++;
+                }
+            }
+            myStats.busySeconds += std::chrono::duration<double>(Clock::now() - busyStart).count();
+            barrier.wait();
+
+            if (i == 0) {
+                std::swap(m_words, m_next);
+            }
+        }
+        myStats.idleSeconds = std::chrono::duration<double>(Clock::now() - start).count() - myStats.busySeconds;
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < numberOfThreads; i++) {
+        threads.push_back(std::thread(worker, i));
+    }
+    worker(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+    // m_next is what the last generation was calculated from.
+    m_nextIsPrevious = true;
+    markChanged();
+    if (stats != nullptr) {
+        *stats = threadStats;
+    }
+}
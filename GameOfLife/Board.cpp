@@ -7,37 +7,46 @@
 //
 
 #include "Board.h"
+#include "BitBoard.h"
+#include "HashLife.h"
+#include "Hash.h"
+#include <string.h>
+#include <algorithm>
 
 Board::Board(int rowCount, int colCount) {
     m_rowCount = rowCount;
     m_colCount = colCount;
-    m_cells.resize(rowCount*colCount, 0);
+    m_cells.resize((size_t)rowCount * colCount, 0);
 }
 
 void Board::setCell(int row, int col, bool val) {
+    markChanged();
     val = val ? true : false;
     bool currentVal = getCell(row, col);
     if(val != currentVal) {
         if(val) {
             setCell_unsafe(row, col);
+            m_stats.population++;
         } else {
             clearCell_unsafe(row, col);
+            m_stats.population--;
         }
     }
 }
 
 void Board::setCell_unsafe(int row, int col) {
-    char* ptr = &m_cells[row*m_colCount + col];
+    char* ptr = &m_cells[getIndex(row, col)];
 
-    int rAboveOffset, rBelowOffset, cLeftOffset, cRightOffset;
+    // The offsets can be bigger than 2^31 on huge boards
+    ptrdiff_t rAboveOffset, rBelowOffset, cLeftOffset, cRightOffset;
     if (row == 0) {
-        rAboveOffset = (int)m_cells.size() - m_colCount;
+        rAboveOffset = (ptrdiff_t)m_cells.size() - m_colCount;
     }
     else {
         rAboveOffset = -m_colCount;
     }
     if (row == (m_rowCount - 1)) {
-        rBelowOffset = -(int)m_cells.size() + m_colCount;
+        rBelowOffset = -(ptrdiff_t)m_cells.size() + m_colCount;
     }
     else {
         rBelowOffset = +m_colCount;
@@ -67,17 +76,18 @@ void Board::setCell_unsafe(int row, int col) {
 }
 
 void Board::clearCell_unsafe(int row, int col) {
-    char* ptr = &m_cells[row*m_colCount + col];
+    char* ptr = &m_cells[getIndex(row, col)];
 
-    int rAboveOffset, rBelowOffset, cLeftOffset, cRightOffset;
+    // The offsets can be bigger than 2^31 on huge boards
+    ptrdiff_t rAboveOffset, rBelowOffset, cLeftOffset, cRightOffset;
     if (row == 0) {
-        rAboveOffset = (int)m_cells.size() - m_colCount;
+        rAboveOffset = (ptrdiff_t)m_cells.size() - m_colCount;
     }
     else {
         rAboveOffset = -m_colCount;
     }
     if (row == (m_rowCount - 1)) {
-        rBelowOffset = -(int)m_cells.size() + m_colCount;
+        rBelowOffset = -(ptrdiff_t)m_cells.size() + m_colCount;
     }
     else {
         rBelowOffset = +m_colCount;
@@ -106,58 +116,179 @@ void Board::clearCell_unsafe(int row, int col) {
     ptr[rBelowOffset + cRightOffset] -= 2;
 }
 
+void Board::rebuildNeighbourCounts() {
+    markChanged();
+    m_stats = GenerationStats();
+    if (m_cells.empty()) {
+        return;
+    }
+    // Only the 'alive' bit of the neighbours is read, so the counts can be written in place.
+    uint64_t population = 0;
+    for (int row = 0; row < m_rowCount; row++) {
+        const char* above = &m_cells[getIndex(row == 0 ? m_rowCount - 1 : row - 1, 0)];
+        char* cur = &m_cells[getIndex(row, 0)];
+        const char* below = &m_cells[getIndex(row == m_rowCount - 1 ? 0 : row + 1, 0)];
+        
+        // The interior columns don't need wrap-around. This loop is simple enough to be vectorized by the compiler.
+        for (int col = 1; col < m_colCount - 1; col++) {
+            int neighbours = (above[col - 1] & 1) + (above[col] & 1) + (above[col + 1] & 1)
+                + (cur[col - 1] & 1) + (cur[col + 1] & 1)
+                + (below[col - 1] & 1) + (below[col] & 1) + (below[col + 1] & 1);
+            cur[col] = (char)((cur[col] & 1) | (neighbours << 1));
+            population += cur[col] & 1;
+        }
+        
+        int edgeCols[2] = { 0, m_colCount - 1 };
+        for (int i = 0; i < (m_colCount > 1 ? 2 : 1); i++) {
+            int col = edgeCols[i];
+            int left = (col == 0) ? m_colCount - 1 : col - 1;
+            int right = (col == m_colCount - 1) ? 0 : col + 1;
+            int neighbours = (above[left] & 1) + (above[col] & 1) + (above[right] & 1)
+                + (cur[left] & 1) + (cur[right] & 1)
+                + (below[left] & 1) + (below[col] & 1) + (below[right] & 1);
+            cur[col] = (char)((cur[col] & 1) | (neighbours << 1));
+            population += cur[col] & 1;
+        }
+    }
+    m_stats.population = population;
+}
+
 void Board::nextGeneration()
 {
-    std::vector<char> oldCells = m_cells;
-    nextGeneration(&oldCells[0], 0, m_rowCount);
+    runSingleThreaded(1);
+}
+
+// About the old state of the cells:
+// Calculating a row needs the state of the row before the generation started. But calculating
+// a row also changes the neighbour counts in the row above and the row below. So we need a copy
+// of the old state of a row. Copying the whole board before every generation would do, but on
+// big boards this copy takes about as long as the calculation. Instead, each row is copied right
+// before it is modified for the first time, i.e. right before the row above is calculated. Then
+// we only need to keep 2 rows around, and these are hot in the cache anyway.
+// The first row is an exception: it is modified by the previous row, which may belong to
+// someone else (or is the last row of the board). The caller has to save it before that happens.
+
+void Board::nextGeneration(int rowBegin, int rowEnd, std::vector<char>& rowBuffer, GenerationStats& counts)
+{
+    if (rowBegin >= rowEnd) {
+        return;
+    }
+    rowBuffer.resize(2 * (size_t)m_colCount);
+    char* oldRows[2] = { &rowBuffer[0], &rowBuffer[m_colCount] };
+    int current = 0;
+    memcpy(oldRows[current], &m_cells[getIndex(rowBegin, 0)], m_colCount);
+    for (int row = rowBegin; row < rowEnd; row++) {
+        if (row + 1 < rowEnd) {
+            memcpy(oldRows[1 - current], &m_cells[getIndex(row + 1, 0)], m_colCount);
+        }
+        nextGenerationRow(oldRows[current], row, counts);
+        current = 1 - current;
+    }
 }
 
-void Board::nextGeneration(char* oldCells, int rowBegin, int rowEnd)
+void Board::nextGenerationRow(const char* oldRow, int row, GenerationStats& counts)
 {
-    int idx = rowBegin * m_colCount;
-    for (int row = rowBegin; row<rowEnd; row++) {
-        for (int col = 0; col<m_colCount; col++, idx++) {
-            char val = oldCells[idx];
-            switch (val) {
-            case 0: // not set, no neighbours
-            case 2: // not set, 1 neighbour
-            case 4: // not set, 2 neighbours
-            case 5: // set, 2 neighbours
-            case 7: // set, 3 neighbours
-            case 8: // not set, 4 neighbours
-            case 10: // not set, 5 neighbours
-            case 12: // not set, 6 neighbours
-            case 14: // not set, 7 neighbours
-            case 16: // not set, 8 neighbours
-                break;
-
-            case 6: // not set, 3 neighbours
-                setCell_unsafe(row, col);
-                break;
-
-            case 1: // set, no neighbours
-            case 3: // set, 1 neighbour
-            case 9: // set, 4 neighbours
-            case 11: // set, 5 neighbours
-            case 13: // set, 6 neighbours
-            case 15: // set, 7 neighbours
-            case 17: // set, 8 neighbours
+    withStaticRule(m_rule, [&](const auto& rule) {
+        // The SIMD kernels only handle cells that don't need wrap-around. That is, all
+        // rows except the first and the last one, and all columns except the first and the last one.
+        SimdKernel kernel = getSimdKernel();
+        if (kernel != SIMD_KERNEL_SCALAR && row > 0 && row < m_rowCount - 1) {
+            int colEnd = nextGenerationRowSimd(kernel, m_rule, oldRow, &m_cells[getIndex(row, 0)], m_colCount, counts);
+            nextGenerationRowScalar(rule, oldRow, row, 0, 1, counts);
+            nextGenerationRowScalar(rule, oldRow, row, colEnd, m_colCount, counts);
+        } else {
+            nextGenerationRowScalar(rule, oldRow, row, 0, m_colCount, counts);
+        }
+    });
+}
+
+template <class R>
+void Board::nextGenerationRowScalar(const R& rule, const char* oldRow, int row, int colBegin, int colEnd, GenerationStats& counts)
+{
+    for (int col = colBegin; col < colEnd; col++) {
+        char val = oldRow[col];
+        int neighbours = val >> 1;
+        if (val & 1) {
+            if (!rule.survives(neighbours)) {
                 clearCell_unsafe(row, col);
-                break;
+                counts.deaths++;
             }
+        } else if (rule.isBorn(neighbours)) {
+            setCell_unsafe(row, col);
+            counts.births++;
         }
     }
 }
 
+void Board::finishGeneration(const GenerationStats& counts)
+{
+    markChanged();
+    m_stats.population += counts.births - counts.deaths;
+    m_stats.births = counts.births;
+    m_stats.deaths = counts.deaths;
+}
+
 void Board::runSingleThreaded(int numberOfGenerations) {
-    std::vector<char> oldCells = m_cells;
-    size_t size = oldCells.size();
+    if (m_cells.empty()) {
+        return;
+    }
+    // The last row is modified when the first row is calculated, so it is saved first.
+    std::vector<char> oldLastRow(m_colCount);
+    std::vector<char> rowBuffer;
     for(int i=0; i<numberOfGenerations; i++) {
-        if (i != 0) {
-            memcpy(&oldCells[0], &m_cells[0], size);
-        }
-        nextGeneration(&oldCells[0], 0, m_rowCount);
+        GenerationStats counts;
+        memcpy(&oldLastRow[0], &m_cells[getIndex(m_rowCount - 1, 0)], m_colCount);
+        nextGeneration(0, m_rowCount - 1, rowBuffer, counts);
+        nextGenerationRow(&oldLastRow[0], m_rowCount - 1, counts);
+        finishGeneration(counts);
+    }
+}
+
+void Board::runBits(int numberOfGenerations) {
+    if (numberOfGenerations <= 0) {
+        return;
+    }
+    BitBoard bits(*this);
+    bits.run(numberOfGenerations);
+    bits.copyTo(*this);
+}
+
+void Board::runTimeBlocked(int numberOfGenerations, int timeBlock, int numberOfThreads) {
+    if (numberOfGenerations <= 0) {
+        return;
     }
+    BitBoard bits(*this);
+    bits.runTimeBlocked(numberOfGenerations, timeBlock, numberOfThreads);
+    bits.copyTo(*this);
+}
+
+void Board::runWorkStealing(int numberOfGenerations, int numberOfThreads, std::vector<BitBoard::ThreadStats>* stats) {
+    BitBoard bits(*this);
+    bits.runWorkStealing(numberOfGenerations, numberOfThreads, stats);
+    bits.copyTo(*this);
+}
+
+#if USE_OPENCL
+void Board::runHybrid(int numberOfGenerations, int timeBlock, int numberOfThreads, OpenCLDeviceType deviceType, BitBoard::HybridStats* stats) {
+    if (numberOfGenerations <= 0) {
+        return;
+    }
+    BitBoard bits(*this);
+    bits.runHybrid(numberOfGenerations, timeBlock, numberOfThreads, deviceType, stats, m_verbose);
+    bits.copyTo(*this);
+}
+#endif
+
+void Board::runHashLife(int64_t numberOfGenerations, bool infinitePlane, size_t maxNodes) {
+    if (numberOfGenerations <= 0) {
+        return;
+    }
+    BitBoard bits(*this);
+    HashLife life(bits, infinitePlane ? HashLife::TOPOLOGY_PLANE : HashLife::TOPOLOGY_TORUS, maxNodes);
+    life.setVerbose(m_verbose);
+    life.run(numberOfGenerations);
+    life.copyTo(bits);
+    bits.copyTo(*this);
 }
 
 #if USE_OPENMP
@@ -185,7 +316,7 @@ void Board::runOpenMP(int numberOfGenerations, int numberOfThreads)
     std::vector<int> edgeRows;
 
     for (int i = 0; i < numberOfThreads; i++) {
-        slicesBegin.push_back(m_rowCount * i / numberOfThreads + 2);
+        slicesBegin.push_back((int)((int64_t)m_rowCount * i / numberOfThreads) + 2);
     }
     for (int i = 0; i < numberOfThreads -1; i++) {
         slicesEnd.push_back(slicesBegin[i + 1] - 2);
@@ -197,21 +328,30 @@ void Board::runOpenMP(int numberOfGenerations, int numberOfThreads)
         edgeRows.push_back(row - 1);
     }
 
-    std::vector<char> oldCells = m_cells;
-    size_t size = oldCells.size();
+    // The slices only modify their own rows and the edge rows, so only the edge rows have to be saved.
+    std::vector<char> oldEdgeRows(edgeRows.size() * m_colCount);
+    std::vector<std::vector<char>> rowBuffers(numberOfThreads);
+    std::vector<GenerationStats> sliceCounts(numberOfThreads);
     for (int gIdx = 0; gIdx < numberOfGenerations; gIdx++) {
-        if (gIdx != 0) {
-            memcpy(&oldCells[0], &m_cells[0], size);
+        for (size_t i = 0; i < edgeRows.size(); i++) {
+            memcpy(&oldEdgeRows[i * m_colCount], &m_cells[getIndex(edgeRows[i], 0)], m_colCount);
         }
 
         #pragma omp parallel for
         for (int i = 0; i < numberOfThreads; i++) {
-            nextGeneration(&oldCells[0], slicesBegin[i], slicesEnd[i]);
+            sliceCounts[i] = GenerationStats();
+            nextGeneration(slicesBegin[i], slicesEnd[i], rowBuffers[i], sliceCounts[i]);
         }
 
-        for (auto row : edgeRows) {
-            nextGeneration(&oldCells[0], row, row + 1);
+        GenerationStats counts;
+        for (size_t i = 0; i < edgeRows.size(); i++) {
+            nextGenerationRow(&oldEdgeRows[i * m_colCount], edgeRows[i], counts);
+        }
+        for (const GenerationStats& c : sliceCounts) {
+            counts.births += c.births;
+            counts.deaths += c.deaths;
         }
+        finishGeneration(counts);
     }
 }
 #endif
@@ -232,6 +372,35 @@ std::string Board::toString() const {
     return s;
 }
 
+/// Packs bit 0 of 8 cells into the low 8 bits, with one multiplication instead of a loop.
+static inline uint64_t packCells(const char* cells) {
+    uint64_t x;
+    memcpy(&x, cells, 8);
+    // Moves bit 8*i to bit 56 + i
+    return ((x & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56;
+}
+
+uint64_t Board::getHash() const {
+    // Same as BitBoard(*this).getHash(), but packs only one row at a time.
+    XxHash64 hash;
+    int32_t size[2] = { m_rowCount, m_colCount };
+    hash.update(size, sizeof(size));
+    std::vector<uint64_t> words((m_colCount + 63) / 64);
+    for (int row = 0; row < m_rowCount; row++) {
+        const char* cells = &m_cells[getIndex(row, 0)];
+        std::fill(words.begin(), words.end(), 0);
+        int col = 0;
+        for (; col + 8 <= m_colCount; col += 8) {
+            words[col >> 6] |= packCells(cells + col) << (col & 63);
+        }
+        for (; col < m_colCount; col++) {
+            words[col >> 6] |= (uint64_t)(cells[col] & 1) << (col & 63);
+        }
+        hash.update(&words[0], words.size() * sizeof(uint64_t));
+    }
+    return hash.digest();
+}
+
 bool operator==(const Board& b1, const Board& b2) {
     return b1.getRowCount() == b2.getRowCount() && b1.m_cells == b2.m_cells;
 }
@@ -10,7 +10,12 @@
 #define Board_h
 
 #include "gol-config.h"
+#include "BitBoard.h"
+#include "Rule.h"
+#include "ThreadPool.h"
 #include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <vector>
 #include <string>
 
@@ -30,52 +35,135 @@ public:
     inline int getColCount() const { return m_colCount; }
     
     /// @return true if the cell is alive, false otherwise.
-    inline bool getCell(int row, int col) const { return m_cells[row*m_colCount + col] & 1; };
+    inline bool getCell(int row, int col) const { return m_cells[getIndex(row, col)] & 1; };
     void setCell(int row, int col, bool isAlive);
     
+    /// The rule that all engines use. (Default: Conway's Game of Life, B3/S23)
+    inline const Rule& getRule() const { return m_rule; }
+    inline void setRule(const Rule& rule) { m_rule = rule; }
+    
     /// Calculates the next generation. (Single-threaded, on the CPU.)
     void nextGeneration();
     void runSingleThreaded(int numberOfGenerations);
+    /// Runs on a bit-packed copy of the board (see BitBoard) and copies the result back.
+    /// This is faster, but needs more memory than the board itself. To save memory, load the board
+    /// into a BitBoard (BoardIO::loadTextBits()) and run that.
+    void runBits(int numberOfGenerations);
+    /// Like runBits(), but with temporal blocking (see BitBoard::runTimeBlocked()).
+    void runTimeBlocked(int numberOfGenerations, int timeBlock, int numberOfThreads);
+    /// Multi-threaded with work stealing, skips the parts of the board that can't change
+    /// (see BitBoard::runWorkStealing()).
+    void runWorkStealing(int numberOfGenerations, int numberOfThreads, std::vector<BitBoard::ThreadStats>* stats = nullptr);
+    /// Single-threaded, but only looks at the parts of the board that changed in the
+    /// previous generation. Fast for boards that are mostly empty or stable. (Implemented in Board_tiles.cpp)
+    void runTiles(int numberOfGenerations);
+    /// Runs the HashLife algorithm (see HashLife.h). Can run a huge number of generations if the
+    /// pattern is regular. With infinitePlane, cells that leave the board are gone (no wrap-around).
+    void runHashLife(int64_t numberOfGenerations, bool infinitePlane = false, size_t maxNodes = 8 * 1024 * 1024);
 
 #if USE_OPENMP
     void runOpenMP(int numberOfGenerations, int numberOfThreads);
 #endif
     
-    enum OpenCLDeviceType {
-        DEVICE_TYPE_DONT_CARE,
-        DEVICE_TYPE_CPU_ONLY,
-        DEVICE_TYPE_GPU_ONLY
-    };
+    /// Multi-threaded with std::thread, works on every platform. The threads are started at the first call
+    /// and reused by the next ones. (Implemented in Board_threads.cpp)
+    void runThreaded(int numberOfGenerations, int numberOfThreads);
+    /// The number of hardware threads, or 4 if it can't be determined.
+    static int getDefaultThreadCount();
+    
+    typedef BitBoard::OpenCLDeviceType OpenCLDeviceType;
+    static const OpenCLDeviceType DEVICE_TYPE_DONT_CARE = BitBoard::DEVICE_TYPE_DONT_CARE;
+    static const OpenCLDeviceType DEVICE_TYPE_CPU_ONLY = BitBoard::DEVICE_TYPE_CPU_ONLY;
+    static const OpenCLDeviceType DEVICE_TYPE_GPU_ONLY = BitBoard::DEVICE_TYPE_GPU_ONLY;
     
 #if USE_OPENCL
+    /// Runs on an OpenCL device (see gol_kernel.cl). The cells are packed into bits and unpacked
+    /// again (with the neighbour counts) on the device.
+    /// @throws std::runtime_error if there is no such device, or OpenCL fails.
     void runOpenCL(int numberOfGenerations, OpenCLDeviceType deviceType);
+    /// Runs on a bit-packed copy of the board, partly on an OpenCL device and partly on the CPU
+    /// (see BitBoard::runHybrid()).
+    void runHybrid(int numberOfGenerations, int timeBlock, int numberOfThreads, OpenCLDeviceType deviceType,
+                   BitBoard::HybridStats* stats = nullptr);
 #endif
     
+    /// Instruction sets for the kernel of nextGeneration(), runSingleThreaded() and runOpenMP().
+    enum SimdKernel {
+        SIMD_KERNEL_SCALAR,
+        SIMD_KERNEL_SSE2,
+        SIMD_KERNEL_AVX2,
+        SIMD_KERNEL_AVX512
+    };
+    
+    /// The kernel is chosen once at startup, from the instruction sets the CPU supports.
+    static SimdKernel getSimdKernel();
+    /// Forces a particular kernel. Returns false (and changes nothing) if the CPU doesn't support it.
+    static bool setSimdKernel(SimdKernel kernel);
+    static bool isSimdKernelSupported(SimdKernel kernel);
+    static const char* getSimdKernelName(SimdKernel kernel);
+    
+    /// The population, and the births and deaths of the last generation. The engines count them
+    /// while they run, so this doesn't look at the board. runHashLife() and runOpenCL() don't calculate
+    /// the generations one by one on the CPU, so the births and deaths are 0 after them.
+    inline const GenerationStats& getStats() const { return m_stats; }
+    /// A number that changes whenever the cells change (see BitBoard::getVersion()).
+    inline uint64_t getVersion() const { return m_version; }
+    
     std::string toString() const;
+    /// A hash of the size and the alive cells (XXH64, see BitBoard::getHash()).
+    /// Boards with the same cells have the same hash, no matter which engine calculated them.
+    uint64_t getHash() const;
     
     bool isVerbose() const { return m_verbose; };
     void setVerbose(bool v) { m_verbose = v; };
     
     friend bool operator==(const Board& b1, const Board& b2);
+    friend class BitBoard;
+    friend class BoardIO;
     
 private:
     bool m_verbose = false;
     
-    /// Runs on a slice of the data. Slicing is for OpenMP.
-    void nextGeneration(char* oldCells, int rowBegin, int rowEnd);
+    /// Runs on a slice of the data. Slicing is for multi-threading.
+    /// The rows [rowBegin, rowEnd) must not have been modified in this generation yet, and nobody
+    /// else may modify them while this runs. `rowBuffer` is scratch space for the old state of two rows.
+    /// The births and deaths are added to `counts` (the population isn't touched).
+    void nextGeneration(int rowBegin, int rowEnd, std::vector<char>& rowBuffer, GenerationStats& counts);
+    /// Calculates one row. `oldRow` is the state of the row before the generation started.
+    void nextGenerationRow(const char* oldRow, int row, GenerationStats& counts);
+    template <class R>
+    void nextGenerationRowScalar(const R& rule, const char* oldRow, int row, int colBegin, int colEnd, GenerationStats& counts);
+    /// Calculates the cells of a row that is neither the first nor the last row, starting
+    /// at column 1. Returns the column where it stopped; the rest of the row is left to the
+    /// scalar code. (Implemented in Board_simd.cpp)
+    static int nextGenerationRowSimd(SimdKernel kernel, const Rule& rule, const char* oldRow, char* row, int colCount,
+                                     GenerationStats& counts);
+    /// Updates m_stats with the births and deaths of a generation.
+    void finishGeneration(const GenerationStats& counts);
+    /// Gives the board a new version.
+    void markChanged() { m_version = BitBoard::newVersion(); }
 
     /// Sets cell to 'alive', assuming its dead
     void setCell_unsafe(int row, int col);
     /// Sets cell to 'dead', assuming its alive
     void clearCell_unsafe(int row, int col);
     
-    inline int getIndex(int row, int col) const {
-        return row * m_colCount + col;
+    /// Recalculates all neighbour-counts (and the population) from the 'alive' bits, in a single pass over the board.
+    /// Faster than calling setCell() for every cell when a whole board is imported.
+    void rebuildNeighbourCounts();
+    
+    inline size_t getIndex(int row, int col) const {
+        return (size_t)row * m_colCount + col;
     };
     
     int m_rowCount = 0;
     int m_colCount = 0;
     std::vector<char> m_cells;
+    Rule m_rule;
+    GenerationStats m_stats;
+    uint64_t m_version = BitBoard::newVersion();
+    /// The threads of runThreaded(), kept for the next call.
+    ThreadPool m_threadPool;
 
     // About the memory layout:
     // Each element (char) of m_cells represents one cell on the board.
@@ -84,7 +172,8 @@ private:
     // E.g. 000001001
     //      ........1 => cell is alive
     //      ....0100. => it has 4 neighbours
-    // => the cell will die in the next generation because it is alive and has more than 3 neighbours.
+    // => the cell will die in the next generation because it is alive and has more than 3 neighbours
+    //    (with the default rule).
 };
 
 bool operator==(const Board& b1, const Board& b2);
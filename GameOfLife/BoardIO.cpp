@@ -0,0 +1,654 @@
+//
+//  BoardIO.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "BoardIO.h"
+#include "MappedFile.h"
+#include "Hash.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// About loading text files:
+// Most files are written by us, so all lines have the same length. In this case, the start of
+// every row can be calculated without looking at the file, and every thread can start parsing
+// its rows right away. Every thread checks that its rows really end where we expected them to end.
+// If they don't (e.g. lines of different length), we search for all newlines first and parse again.
+// Parsing only writes the 'alive' bit of every cell. The neighbour counts are calculated afterwards,
+// in one pass over the whole board (see Board::rebuildNeighbourCounts()).
+
+// About the binary format:
+// All numbers are little-endian. The header is followed by rowCount * wordsPerRow 64-bit words.
+// Bits beyond the last column must be 0. If the checksum flag is set, the checksum is the XXH64
+// hash (seed 0) of these words.
+// Readers must reject files with a different version, but ignore the reserved bytes.
+// The generation and the rule were added later, in bytes that used to be reserved, so they
+// have flags that tell whether they are there. (Older files have them set to 0.)
+
+static const char BINARY_MAGIC[4] = { 'G', 'O', 'L', 'B' };
+static const uint32_t BINARY_VERSION = 1;
+static const uint32_t BINARY_FLAG_CHECKSUM = 1;
+static const uint32_t BINARY_FLAG_GENERATION = 2;
+static const uint32_t BINARY_FLAG_RULE = 4;
+
+struct BinaryHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t flags;
+    /// Offset of the first row. (64 for version 1)
+    uint32_t headerSize;
+    int32_t rowCount;
+    int32_t colCount;
+    uint32_t wordsPerRow;
+    uint32_t reserved0;
+    uint64_t checksum;
+    /// The generation of the board, e.g. of a checkpoint. (If BINARY_FLAG_GENERATION is set)
+    int64_t generation;
+    /// See Rule::getBirthMask() and Rule::getSurvivalMask(). (If BINARY_FLAG_RULE is set)
+    uint16_t birthMask;
+    uint16_t survivalMask;
+    uint8_t reserved[12];
+};
+static_assert(sizeof(BinaryHeader) == 64, "The binary header must have 64 bytes");
+
+/// Files smaller than this are parsed by one thread.
+static const size_t MIN_PARALLEL_FILE_SIZE = 1024 * 1024;
+
+/// Parses "COLS,ROWS" and returns the offset of the first row, or 0 on error.
+static size_t parseTextHeader(const char* data, size_t size, int& rowCount, int& colCount)
+{
+    char header[64];
+    size_t headerLength = std::min(size, sizeof(header) - 1);
+    memcpy(header, data, headerLength);
+    header[headerLength] = 0;
+    int length = 0;
+    if (sscanf(header, "%d,%d%n", &colCount, &rowCount, &length) != 2 || rowCount < 1 || colCount < 1) {
+        return 0;
+    }
+    size_t offset = (size_t)length;
+    while (offset < size && (data[offset] == '\n' || data[offset] == '\r' || data[offset] == ' ' || data[offset] == '\t')) {
+        offset++;
+    }
+    return offset;
+}
+
+Board BoardIO::load(const std::string& path)
+{
+    if (isBinaryFile(path)) {
+        Board board;
+        loadBinary(path).copyTo(board);
+        return board;
+    }
+    return loadText(path);
+}
+
+void BoardIO::save(const Board& board, const std::string& path)
+{
+    if (isBinaryPath(path)) {
+        saveBinary(BitBoard(board), path);
+    } else {
+        saveText(board, path);
+    }
+}
+
+bool BoardIO::isBinaryFile(const std::string& path)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == NULL) {
+        return false;
+    }
+    char magic[4];
+    bool isBinary = fread(magic, 1, 4, f) == 4 && memcmp(magic, BINARY_MAGIC, 4) == 0;
+    fclose(f);
+    return isBinary;
+}
+
+bool BoardIO::isBinaryPath(const std::string& path)
+{
+    const std::string extension = ".golb";
+    return path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+template <typename ParseRow>
+void BoardIO::parseTextRows(const std::string& path, const char* data, size_t size, size_t bodyStart, int rowCount,
+                            int numberOfThreads, ParseRow parseRow)
+{
+    std::vector<size_t> rowStarts(rowCount + 1);
+
+    // Guess the row starts from the length of the first line
+    const char* firstNewline = (const char*)memchr(data + bodyStart, '\n', size - bodyStart);
+    size_t lineLength = firstNewline != nullptr ? (size_t)(firstNewline - data) - bodyStart + 1 : size - bodyStart;
+    bool uniform = lineLength > 0 && bodyStart + lineLength * (rowCount - 1) < size;
+    if (uniform) {
+        for (int row = 0; row <= rowCount; row++) {
+            rowStarts[row] = std::min(bodyStart + lineLength * row, size);
+        }
+    }
+
+    if (size < MIN_PARALLEL_FILE_SIZE) {
+        numberOfThreads = 1;
+    }
+    numberOfThreads = std::max(1, std::min(numberOfThreads, rowCount));
+
+    auto parseInParallel = [&]() {
+        std::atomic<bool> ok(true);
+        auto worker = [&](int i) {
+            int rowBegin = (int)((long long)rowCount * i / numberOfThreads);
+            int rowEnd = (int)((long long)rowCount * (i + 1) / numberOfThreads);
+            if (!parseRows(data, size, &rowStarts[0], rowBegin, rowEnd, parseRow)) {
+                ok = false;
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int i = 1; i < numberOfThreads; i++) {
+            threads.push_back(std::thread(worker, i));
+        }
+        worker(0);
+        for (auto& t : threads) {
+            t.join();
+        }
+        return ok.load();
+    };
+
+    if (uniform && parseInParallel()) {
+        return;
+    }
+
+    // Lines of different length: find all row starts first.
+    size_t offset = bodyStart;
+    for (int row = 0; row < rowCount; row++) {
+        if (offset >= size) {
+            throw std::runtime_error("Unexpected end of file at " + path);
+        }
+        rowStarts[row] = offset;
+        const char* newline = (const char*)memchr(data + offset, '\n', size - offset);
+        offset = newline != nullptr ? (size_t)(newline - data) + 1 : size;
+    }
+    rowStarts[rowCount] = offset;
+    if (!parseInParallel()) {
+        throw std::runtime_error("Invalid rows in file at " + path);
+    }
+}
+
+template <typename ParseRow>
+bool BoardIO::parseRows(const char* data, size_t size, const size_t* rowStarts, int rowBegin, int rowEnd, ParseRow parseRow)
+{
+    for (int row = rowBegin; row < rowEnd; row++) {
+        size_t lineBegin = rowStarts[row];
+        size_t lineEnd = rowStarts[row + 1];
+        // A row ends with a newline, except for the last row in the file.
+        if (lineEnd < lineBegin || (lineEnd < size && data[lineEnd - 1] != '\n') || (lineEnd == size && lineEnd == lineBegin)) {
+            return false;
+        }
+        if (lineEnd > lineBegin && data[lineEnd - 1] == '\n') {
+            lineEnd--;
+        }
+        if (!parseRow(row, data + lineBegin, lineEnd - lineBegin)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Board BoardIO::loadText(const std::string& path, int numberOfThreads)
+{
+    MappedFile file(path);
+    const char* data = file.getData();
+    const size_t size = file.getSize();
+
+    int rowCount = -1, colCount = -1;
+    size_t bodyStart = parseTextHeader(data, size, rowCount, colCount);
+    if (bodyStart == 0) {
+        throw std::runtime_error("Invalid header in file at " + path);
+    }
+
+    Board board = Board(rowCount, colCount);
+    parseTextRows(path, data, size, bodyStart, rowCount, numberOfThreads, [&](int row, const char* line, size_t length) {
+        int n = (int)std::min((size_t)colCount, length);
+        char* cells = &board.m_cells[board.getIndex(row, 0)];
+        // This loop is simple enough to be vectorized by the compiler.
+        int newlines = 0;
+        for (int col = 0; col < n; col++) {
+            char c = line[col];
+            cells[col] = (char)((c | 0x20) == 'x');
+            newlines += (c == '\n');
+        }
+        memset(cells + n, 0, colCount - n);
+        return newlines == 0;
+    });
+    board.rebuildNeighbourCounts();
+    return board;
+}
+
+BitBoard BoardIO::loadTextBits(const std::string& path, int numberOfThreads)
+{
+    MappedFile file(path);
+    const char* data = file.getData();
+    const size_t size = file.getSize();
+
+    int rowCount = -1, colCount = -1;
+    size_t bodyStart = parseTextHeader(data, size, rowCount, colCount);
+    if (bodyStart == 0) {
+        throw std::runtime_error("Invalid header in file at " + path);
+    }
+
+    // The rows of a new BitBoard are all 0, so only the alive cells have to be set.
+    BitBoard board(rowCount, colCount);
+    parseTextRows(path, data, size, bodyStart, rowCount, numberOfThreads, [&](int row, const char* line, size_t length) {
+        int n = (int)std::min((size_t)colCount, length);
+        uint64_t* words = board.getRow(row);
+        int newlines = 0;
+        for (int col = 0; col < n; col += 64) {
+            int end = std::min(col + 64, n);
+            uint64_t word = 0;
+            for (int c = col; c < end; c++) {
+                word |= (uint64_t)((line[c] | 0x20) == 'x') << (c - col);
+                newlines += (line[c] == '\n');
+            }
+            words[col >> 6] = word;
+        }
+        return newlines == 0;
+    });
+    return board;
+}
+
+// About saving text files:
+// Board::toString() builds the whole file in memory, which doubles the memory needed for big boards.
+// Instead, rows are converted into a buffer of about CHUNK_SIZE bytes, and the buffer is written
+// with one big write. There are two buffers: while the writer thread writes one of them, the
+// next rows are converted into the other one.
+
+static const size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+/// Writes buffers to a file, optionally on a second thread.
+class ChunkedFileWriter
+{
+public:
+    ChunkedFileWriter(FILE* file, size_t bufferSize, bool useThread) : m_file(file) {
+        m_buffers[0].resize(bufferSize);
+        m_buffers[1].resize(bufferSize);
+        if (useThread) {
+            m_thread = std::thread([this] { writerLoop(); });
+        }
+    }
+
+    ~ChunkedFileWriter() {
+        finish();
+    }
+
+    /// The buffer that can be filled now.
+    inline char* getBuffer() { return &m_buffers[m_current][0]; }
+
+    /// Writes the first `length` bytes of the buffer. Afterwards, getBuffer() returns the other buffer.
+    void submit(size_t length) {
+        if (!m_thread.joinable()) {
+            write(m_current, length);
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        // The writer must be done with the previous buffer before we can fill it again.
+        m_condition.wait(lock, [this] { return m_pending < 0; });
+        m_pending = m_current;
+        m_pendingLength = length;
+        m_current = 1 - m_current;
+        m_condition.notify_all();
+    }
+
+    /// Waits until everything is written.
+    /// @return false if a write failed.
+    bool finish() {
+        if (m_thread.joinable()) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_finished = true;
+                m_condition.notify_all();
+            }
+            m_thread.join();
+        }
+        return m_ok;
+    }
+
+private:
+    void write(int buffer, size_t length) {
+        if (fwrite(&m_buffers[buffer][0], 1, length, m_file) != length) {
+            m_ok = false;
+        }
+    }
+
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_condition.wait(lock, [this] { return m_pending >= 0 || m_finished; });
+            if (m_pending < 0) {
+                return;
+            }
+            int buffer = m_pending;
+            size_t length = m_pendingLength;
+            lock.unlock();
+            write(buffer, length);
+            lock.lock();
+            m_pending = -1;
+            m_condition.notify_all();
+        }
+    }
+
+    FILE* m_file;
+    std::vector<char> m_buffers[2];
+    int m_current = 0;
+    bool m_ok = true;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    int m_pending = -1;
+    size_t m_pendingLength = 0;
+    bool m_finished = false;
+};
+
+template <typename ConvertRow>
+void BoardIO::writeTextRows(const std::string& path, int rowCount, int colCount, bool useWriterThread, ConvertRow convertRow)
+{
+    FILE* f = fopen(path.c_str(), "w");
+    if (f == NULL) {
+        throw std::runtime_error("fopen(w) failed for file at " + path);
+    }
+    // Our buffers are big enough, no need to copy them into the buffer of the FILE.
+    setvbuf(f, NULL, _IONBF, 0);
+
+    const size_t lineLength = (size_t)colCount + 1;
+    const size_t rowsPerChunk = std::max((size_t)1, std::min((size_t)rowCount, CHUNK_SIZE / lineLength));
+    bool ok;
+    {
+        ChunkedFileWriter writer(f, std::max((size_t)64, rowsPerChunk * lineLength), useWriterThread);
+        char* buffer = writer.getBuffer();
+        size_t length = (size_t)snprintf(buffer, 64, "%d,%d\n", colCount, rowCount);
+        writer.submit(length);
+        for (int rowBegin = 0; rowBegin < rowCount; rowBegin += (int)rowsPerChunk) {
+            int rowEnd = std::min(rowBegin + (int)rowsPerChunk, rowCount);
+            buffer = writer.getBuffer();
+            for (int row = rowBegin; row < rowEnd; row++) {
+                char* line = buffer + (row - rowBegin) * lineLength;
+                convertRow(row, line);
+                line[colCount] = '\n';
+            }
+            writer.submit((rowEnd - rowBegin) * lineLength);
+        }
+        ok = writer.finish();
+    }
+    if (fclose(f) != 0 || !ok) {
+        throw std::runtime_error("Writing failed for file at " + path);
+    }
+}
+
+void BoardIO::saveText(const Board& board, const std::string& path, bool useWriterThread)
+{
+    const int colCount = board.m_colCount;
+    writeTextRows(path, board.m_rowCount, colCount, useWriterThread, [&](int row, char* out) {
+        const char* cells = &board.m_cells[board.getIndex(row, 0)];
+        // This loop is simple enough to be vectorized by the compiler.
+        for (int col = 0; col < colCount; col++) {
+            out[col] = (char)('.' + (cells[col] & 1) * ('x' - '.'));
+        }
+    });
+}
+
+/// The 8 characters for every possible byte of a BitBoard row, lowest bit first.
+static const uint64_t* getByteToTextTable()
+{
+    static const std::vector<uint64_t> table = [] {
+        std::vector<uint64_t> t(256);
+        for (int byte = 0; byte < 256; byte++) {
+            char chars[8];
+            for (int bit = 0; bit < 8; bit++) {
+                chars[bit] = ((byte >> bit) & 1) ? 'x' : '.';
+            }
+            memcpy(&t[byte], chars, 8);
+        }
+        return t;
+    }();
+    return &table[0];
+}
+
+void BoardIO::saveText(const BitBoard& board, const std::string& path, bool useWriterThread)
+{
+    const int colCount = board.getColCount();
+    const uint64_t* table = getByteToTextTable();
+    writeTextRows(path, board.getRowCount(), colCount, useWriterThread, [&](int row, char* out) {
+        const uint64_t* words = board.getRow(row);
+        // 8 cells at a time with the table, then the rest
+        int col = 0;
+        for (; col + 8 <= colCount; col += 8) {
+            uint64_t chars = table[(words[col >> 6] >> (col & 63)) & 0xFF];
+            memcpy(out + col, &chars, 8);
+        }
+        for (; col < colCount; col++) {
+            out[col] = ((words[col >> 6] >> (col & 63)) & 1) ? 'x' : '.';
+        }
+    });
+}
+
+/// Checks the header of a binary file and returns the first row.
+static const uint64_t* getBinaryRows(const MappedFile& file, BinaryHeader& header, const std::string& path, bool verifyChecksum = true)
+{
+    const char* data = file.getData();
+    const size_t size = file.getSize();
+    if (size < sizeof(header)) {
+        throw std::runtime_error("File too small for the binary format: " + path);
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, BINARY_MAGIC, 4) != 0) {
+        throw std::runtime_error("Not a binary board file: " + path);
+    }
+    if (header.version != BINARY_VERSION) {
+        throw std::runtime_error("Unsupported version " + std::to_string(header.version) + " of binary board file: " + path);
+    }
+    if (header.rowCount < 1 || header.colCount < 1 || header.wordsPerRow != (uint32_t)((header.colCount + 63) / 64)
+        || header.headerSize < sizeof(header) || header.headerSize % sizeof(uint64_t) != 0) {
+        throw std::runtime_error("Invalid header in binary board file: " + path);
+    }
+    const size_t byteCount = (size_t)header.rowCount * header.wordsPerRow * sizeof(uint64_t);
+    if (size < header.headerSize || size - header.headerSize < byteCount) {
+        throw std::runtime_error("Unexpected end of file at " + path);
+    }
+    const char* words = data + header.headerSize;
+    if (verifyChecksum && (header.flags & BINARY_FLAG_CHECKSUM) && xxHash64(words, byteCount) != header.checksum) {
+        throw std::runtime_error("Checksum mismatch in binary board file: " + path);
+    }
+    return (const uint64_t*)words;
+}
+
+/// The bits of the last word of a row that belong to the board.
+static inline uint64_t getLastWordMask(int colCount)
+{
+    return colCount % 64 == 0 ? ~(uint64_t)0 : ((uint64_t)1 << (colCount % 64)) - 1;
+}
+
+BoardIO::BinaryFileInfo BoardIO::getBinaryFileInfo(const MappedFile& file, const std::string& path, bool verifyChecksum)
+{
+    BinaryHeader header;
+    const uint64_t* words = getBinaryRows(file, header, path, verifyChecksum);
+    BinaryFileInfo info;
+    info.rowCount = header.rowCount;
+    info.colCount = header.colCount;
+    info.wordsPerRow = (int)header.wordsPerRow;
+    info.dataOffset = (size_t)((const char*)words - file.getData());
+    info.generation = (header.flags & BINARY_FLAG_GENERATION) ? header.generation : -1;
+    info.hasRule = (header.flags & BINARY_FLAG_RULE) != 0;
+    if (info.hasRule) {
+        info.rule = Rule(header.birthMask, header.survivalMask);
+    }
+    return info;
+}
+
+void BoardIO::createBinary(const std::string& path, int rowCount, int colCount)
+{
+    BinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BINARY_MAGIC, 4);
+    header.version = BINARY_VERSION;
+    header.headerSize = sizeof(header);
+    header.rowCount = rowCount;
+    header.colCount = colCount;
+    header.wordsPerRow = (colCount + 63) / 64;
+    MappedFile::create(path, sizeof(header) + (size_t)rowCount * header.wordsPerRow * sizeof(uint64_t));
+    FILE* f = fopen(path.c_str(), "r+b");
+    if (f == NULL) {
+        throw std::runtime_error("fopen(r+b) failed for file at " + path);
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    if (fclose(f) != 0 || !ok) {
+        throw std::runtime_error("Writing failed for file at " + path);
+    }
+}
+
+void BoardIO::setBinaryChecksum(MappedFile& file, uint64_t checksum)
+{
+    BinaryHeader header;
+    memcpy(&header, file.getData(), sizeof(header));
+    header.flags |= BINARY_FLAG_CHECKSUM;
+    header.checksum = checksum;
+    memcpy(file.getWritableData(), &header, sizeof(header));
+}
+
+BitBoard BoardIO::loadBinary(const std::string& path)
+{
+    MappedFile file(path);
+    BinaryHeader header;
+    const uint64_t* words = getBinaryRows(file, header, path);
+
+    BitBoard board(header.rowCount, header.colCount);
+    if (header.flags & BINARY_FLAG_RULE) {
+        board.setRule(Rule(header.birthMask, header.survivalMask));
+    }
+    memcpy(board.getRow(0), words, (size_t)header.rowCount * header.wordsPerRow * sizeof(uint64_t));
+
+    // Don't trust the padding bits, the engines rely on them being 0.
+    const uint64_t lastWordMask = getLastWordMask(header.colCount);
+    for (int row = 0; row < header.rowCount; row++) {
+        board.getRow(row)[header.wordsPerRow - 1] &= lastWordMask;
+    }
+    return board;
+}
+
+void BoardIO::saveBinary(const BitBoard& board, const std::string& path, int64_t generation)
+{
+    const size_t byteCount = (size_t)board.getRowCount() * board.getWordsPerRow() * sizeof(uint64_t);
+    const uint64_t* words = byteCount > 0 ? board.getRow(0) : nullptr;
+
+    BinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BINARY_MAGIC, 4);
+    header.version = BINARY_VERSION;
+    header.flags = BINARY_FLAG_CHECKSUM | BINARY_FLAG_RULE;
+    header.headerSize = sizeof(header);
+    header.rowCount = board.getRowCount();
+    header.colCount = board.getColCount();
+    header.wordsPerRow = board.getWordsPerRow();
+    header.checksum = xxHash64(words, byteCount);
+    if (generation >= 0) {
+        header.flags |= BINARY_FLAG_GENERATION;
+        header.generation = generation;
+    }
+    header.birthMask = board.getRule().getBirthMask();
+    header.survivalMask = board.getRule().getSurvivalMask();
+
+    FILE* f = fopen(path.c_str(), "wb");
+    if (f == NULL) {
+        throw std::runtime_error("fopen(wb) failed for file at " + path);
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    ok = ok && (byteCount == 0 || fwrite(words, 1, byteCount, f) == byteCount);
+    if (fclose(f) != 0 || !ok) {
+        throw std::runtime_error("Writing failed for file at " + path);
+    }
+}
+
+// About verifying:
+// The file is compared with the board row by row, while it is read. So we never need
+// memory for a second board.
+
+template <typename PackRow, typename IsAlive>
+bool BoardIO::verifyRows(const std::string& path, int rowCount, int colCount, PackRow packRow, IsAlive isAlive)
+{
+    MappedFile file(path);
+    if (isBinaryFile(path)) {
+        BinaryHeader header;
+        const uint64_t* words = getBinaryRows(file, header, path);
+        if (header.rowCount != rowCount || header.colCount != colCount) {
+            return false;
+        }
+        const uint64_t lastWordMask = getLastWordMask(colCount);
+        std::vector<uint64_t> expected(header.wordsPerRow);
+        for (int row = 0; row < rowCount; row++) {
+            const uint64_t* actual = words + (size_t)row * header.wordsPerRow;
+            packRow(row, &expected[0]);
+            for (uint32_t w = 0; w < header.wordsPerRow; w++) {
+                uint64_t mask = (w == header.wordsPerRow - 1) ? lastWordMask : ~(uint64_t)0;
+                if ((actual[w] & mask) != expected[w]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    const char* data = file.getData();
+    const size_t size = file.getSize();
+    int fileRowCount = -1, fileColCount = -1;
+    size_t offset = parseTextHeader(data, size, fileRowCount, fileColCount);
+    if (offset == 0) {
+        throw std::runtime_error("Invalid header in file at " + path);
+    }
+    if (fileRowCount != rowCount || fileColCount != colCount) {
+        return false;
+    }
+    for (int row = 0; row < rowCount; row++) {
+        if (offset >= size) {
+            throw std::runtime_error("Unexpected end of file at " + path);
+        }
+        const char* line = data + offset;
+        const char* newline = (const char*)memchr(line, '\n', size - offset);
+        size_t lineLength = newline != nullptr ? (size_t)(newline - line) : size - offset;
+        offset += lineLength + 1;
+        int n = (int)std::min((size_t)colCount, lineLength);
+        for (int col = 0; col < colCount; col++) {
+            bool expected = col < n && (line[col] | 0x20) == 'x';
+            if (isAlive(row, col) != expected) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool BoardIO::verify(const Board& board, const std::string& path)
+{
+    const int colCount = board.m_colCount;
+    return verifyRows(path, board.m_rowCount, colCount,
+        [&](int row, uint64_t* words) {
+            const char* cells = &board.m_cells[board.getIndex(row, 0)];
+            std::fill(words, words + (colCount + 63) / 64, 0);
+            for (int col = 0; col < colCount; col++) {
+                words[col >> 6] |= (uint64_t)(cells[col] & 1) << (col & 63);
+            }
+        },
+        [&](int row, int col) { return board.getCell(row, col); });
+}
+
+bool BoardIO::verify(const BitBoard& board, const std::string& path)
+{
+    return verifyRows(path, board.getRowCount(), board.getColCount(),
+        [&](int row, uint64_t* words) {
+            memcpy(words, board.getRow(row), board.getWordsPerRow() * sizeof(uint64_t));
+        },
+        [&](int row, int col) { return board.getCell(row, col); });
+}
@@ -0,0 +1,108 @@
+//
+//  BoardIO.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef BoardIO_h
+#define BoardIO_h
+
+#include "gol-config.h"
+#include "Board.h"
+#include "BitBoard.h"
+#include <string>
+
+class MappedFile;
+
+/// Loading and saving boards.
+///
+/// The text format (.gol) is a line "COLS,ROWS" followed by one line per row,
+/// with one character per cell: 'x' is alive, everything else is dead.
+///
+/// The binary format (.golb) is a 64 byte header (see BinaryHeader in BoardIO.cpp),
+/// followed by the rows in the memory layout of `BitBoard` (little-endian 64-bit words,
+/// one bit per cell). The rows start at offset 64, so they are 64-byte aligned in a
+/// memory-mapped file.
+class BoardIO
+{
+public:
+    /// Loads a board in the text or in the binary format (detected by the first bytes of the file).
+    /// @throws std::runtime_error if the file can't be read or is malformed.
+    static Board load(const std::string& path);
+    /// Saves a board in the binary format if the path ends with ".golb", and in the text format otherwise.
+    /// @throws std::runtime_error if the file can't be written.
+    static void save(const Board& board, const std::string& path);
+
+    /// @return true if the file starts with the magic bytes of the binary format.
+    static bool isBinaryFile(const std::string& path);
+    /// @return true if the path ends with ".golb".
+    static bool isBinaryPath(const std::string& path);
+
+    /// Loads a board in the text format. The file is memory-mapped and the rows are
+    /// parsed in parallel, directly into the cells of the board.
+    /// @throws std::runtime_error if the file can't be read or is malformed.
+    static Board loadText(const std::string& path, int numberOfThreads = Board::getDefaultThreadCount());
+    /// Like loadText(), but parses the rows directly into a BitBoard, so there is never a Board with one byte per cell.
+    static BitBoard loadTextBits(const std::string& path, int numberOfThreads = Board::getDefaultThreadCount());
+    /// Saves a board in the text format. Rows are converted in chunks and written while the next
+    /// chunk is converted, so the whole text never has to be in memory.
+    static void saveText(const Board& board, const std::string& path, bool useWriterThread = true);
+    static void saveText(const BitBoard& board, const std::string& path, bool useWriterThread = true);
+
+    /// Loads a board in the binary format. The rows are copied as they are, without any conversion.
+    /// If the file has a checksum, it is verified.
+    /// @throws std::runtime_error if the file can't be read, is malformed or the checksum is wrong.
+    /// If the file has a rule, the board gets it.
+    static BitBoard loadBinary(const std::string& path);
+    /// Saves the board with its rule. A `generation` >= 0 is saved too (see BinaryFileInfo).
+    static void saveBinary(const BitBoard& board, const std::string& path, int64_t generation = -1);
+
+    /// Where the rows of a binary board file are. Row `r` starts at byte `dataOffset + r * wordsPerRow * 8`.
+    struct BinaryFileInfo {
+        int rowCount;
+        int colCount;
+        int wordsPerRow;
+        size_t dataOffset;
+        /// -1 if the file has no generation.
+        int64_t generation;
+        bool hasRule;
+        /// Only if hasRule is true.
+        Rule rule;
+    };
+    /// Checks the header of a memory-mapped binary board file (and the checksum, if there is one and verifyChecksum is true).
+    /// @throws std::runtime_error if the file is malformed.
+    static BinaryFileInfo getBinaryFileInfo(const MappedFile& file, const std::string& path, bool verifyChecksum = true);
+    /// Creates a binary board file with all cells dead and without a checksum, to be filled through a MappedFile.
+    static void createBinary(const std::string& path, int rowCount, int colCount);
+    /// Sets the checksum (XXH64 of all rows) in the header of a memory-mapped binary board file.
+    static void setBinaryChecksum(MappedFile& file, uint64_t checksum);
+
+    /// Compares a board with a file in the text or in the binary format. The file is compared
+    /// row by row while it is read, it is never loaded into a board.
+    /// @return true if the file has the same size and the same cells as the board.
+    /// @throws std::runtime_error if the file can't be read or is malformed.
+    static bool verify(const Board& board, const std::string& path);
+    static bool verify(const BitBoard& board, const std::string& path);
+
+private:
+    /// `packRow(row, words)` writes a row in the layout of BitBoard::getRow(), `isAlive(row, col)` returns a cell.
+    template <typename PackRow, typename IsAlive>
+    static bool verifyRows(const std::string& path, int rowCount, int colCount, PackRow packRow, IsAlive isAlive);
+    /// Converts row after row with `convertRow(row, out)` (which writes colCount characters) and writes them to a file.
+    template <typename ConvertRow>
+    static void writeTextRows(const std::string& path, int rowCount, int colCount, bool useWriterThread, ConvertRow convertRow);
+    /// Finds the rows of a text file and calls `parseRow(row, line, length)` for every row (in parallel, if the file is big).
+    /// `line` doesn't include the newline. parseRow returns false if there is a newline in the line.
+    /// @throws std::runtime_error if the rows are malformed.
+    template <typename ParseRow>
+    static void parseTextRows(const std::string& path, const char* data, size_t size, size_t bodyStart, int rowCount,
+                              int numberOfThreads, ParseRow parseRow);
+    /// Parses the rows [rowBegin, rowEnd). rowStarts has one entry more than the board has rows.
+    /// @return false if a row doesn't end where rowStarts says it does.
+    template <typename ParseRow>
+    static bool parseRows(const char* data, size_t size, const size_t* rowStarts, int rowBegin, int rowEnd, ParseRow parseRow);
+};
+
+#endif // BoardIO_h
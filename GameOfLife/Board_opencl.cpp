@@ -7,175 +7,909 @@
 //
 
 #include "Board.h"
+#include <limits.h>
 
 #if USE_OPENCL
 
+#if GOL_MAC_ONLY
+#define CL_SILENCE_DEPRECATION
 #include <OpenCL/opencl.h>
-#include "gol_kernel.cl.h"
+#else
+#define CL_TARGET_OPENCL_VERSION 120
+#include <CL/cl.h>
+#endif
+#include "Hash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
-static cl_ndrange makeRange(int size)
+#if GOL_WIN_ONLY
+#include <windows.h>
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if GOL_MAC_ONLY
+#include <mach-o/dyld.h>
+#endif
+
+// About the OpenCL runtime:
+// This file only uses the standard OpenCL 1.2 host API, so it runs on every OpenCL implementation:
+// the GPU drivers, and the CPU implementations like PoCL or Intel's CPU runtime.
+// The kernels are compiled from gol_kernel.cl when the program runs. The file is the one in the
+// environment variable GOL_OPENCL_KERNEL if it is set, otherwise the one next to the executable
+// (the Xcode and Visual Studio projects copy it there). Nothing else is tried, so an old copy in the
+// current directory or in the source tree is never loaded by mistake.
+//
+// Compiling the kernels takes a while (up to a few seconds on some drivers), so the compiled program
+// is saved in a cache directory, and loaded from there the next time. The name of the file contains
+// a hash of the kernel source, the device and the driver version, so a changed kernel or a driver
+// update never loads an old binary. The directory is GOL_OPENCL_CACHE if it is set (an empty value
+// turns the cache off), otherwise ~/.cache/GameOfLife (Linux), ~/Library/Caches/GameOfLife (macOS)
+// or %LOCALAPPDATA%\GameOfLife (Windows).
+//
+// The device, the compiled kernels and the two board buffers on the device are created once and
+// kept until the program exits. When runOpenCL() is called again (e.g. between two checkpoints),
+// the board is only uploaded again if it changed on the host since the last download, i.e. if it has
+// another version (see BitBoard::getVersion()) than the board that was downloaded.
+
+static const char KERNEL_FILE_NAME[] = "gol_kernel.cl";
+static const char KERNEL_BUILD_OPTIONS[] = "";
+/// The preferred number of rows of a tile, and the preferred number of generations per launch (at most 32,
+/// see gol_kernel.cl). They are made smaller if the device doesn't have enough local memory.
+static const int TILE_ROWS = 64;
+static const int GENERATIONS_PER_LAUNCH = 16;
+/// The preferred work-group size (in both directions). A tile is 2 words narrower than a work-group.
+static const size_t LOCAL_SIZE = 16;
+
+static std::string getErrorMessage(const char* function, cl_int error)
 {
-    return {
-        1, // The number of dimensions to use.
-        {0, 0, 0}, // The offset in each dimension.
-        {(size_t)size, 0, 0}, // The global range
-        {0, 0, 0} // The local size of each workgroup => auto-detect
-    };
+    return std::string("OpenCL: ") + function + " failed (error " + std::to_string(error) + ")";
 }
 
-void Board::runOpenCL(int numberOfGenerations, OpenCLDeviceType deviceType)
+static void check(cl_int error, const char* function)
+{
+    if(error != CL_SUCCESS) {
+        throw std::runtime_error(getErrorMessage(function, error));
+    }
+}
+
+static std::string getPlatformString(cl_platform_id platform, cl_platform_info what)
+{
+    size_t size = 0;
+    if(clGetPlatformInfo(platform, what, 0, NULL, &size) != CL_SUCCESS || size == 0) {
+        return "";
+    }
+    std::vector<char> buffer(size);
+    if(clGetPlatformInfo(platform, what, size, buffer.data(), NULL) != CL_SUCCESS) {
+        return "";
+    }
+    return std::string(buffer.data());
+}
+
+static std::string getDeviceString(cl_device_id device, cl_device_info what)
+{
+    size_t size = 0;
+    if(clGetDeviceInfo(device, what, 0, NULL, &size) != CL_SUCCESS || size == 0) {
+        return "";
+    }
+    std::vector<char> buffer(size);
+    if(clGetDeviceInfo(device, what, size, buffer.data(), NULL) != CL_SUCCESS) {
+        return "";
+    }
+    return std::string(buffer.data());
+}
+
+/// @return false if the file can't be read.
+static bool readFile(const std::string& path, std::string& contents)
+{
+    std::ifstream file(path, std::ios::binary);
+    if(!file) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    contents = buffer.str();
+    return !file.bad();
+}
+
+/// @return the directory (with a trailing separator), or "" if it can't be determined.
+static std::string getDirectory(const std::string& path)
+{
+    size_t slash = path.find_last_of(GOL_WIN_ONLY ? "/\\" : "/");
+    return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+static std::string getExecutableDirectory()
+{
+    char path[4096];
+#if GOL_WIN_ONLY
+    DWORD length = GetModuleFileNameA(NULL, path, sizeof(path));
+    if(length == 0 || length >= sizeof(path)) {
+        return "";
+    }
+    return getDirectory(std::string(path, length));
+#elif GOL_MAC_ONLY
+    uint32_t size = sizeof(path);
+    if(_NSGetExecutablePath(path, &size) != 0) {
+        return "";
+    }
+    return getDirectory(path);
+#else
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if(length <= 0) {
+        return "";
+    }
+    return getDirectory(std::string(path, length));
+#endif
+}
+
+/// Reads gol_kernel.cl (see "About the OpenCL runtime" for where it is searched for).
+/// @throws std::runtime_error if it isn't found.
+static std::string loadKernelSource(bool verbose)
+{
+    std::vector<std::string> candidates;
+    if(const char* path = getenv("GOL_OPENCL_KERNEL")) {
+        candidates.push_back(path);
+    } else {
+        std::string executableDirectory = getExecutableDirectory();
+        if(!executableDirectory.empty()) {
+            candidates.push_back(executableDirectory + KERNEL_FILE_NAME);
+        }
+    }
+    std::string source;
+    for(const std::string& path: candidates) {
+        if(readFile(path, source)) {
+            if(verbose) {
+                printf("OpenCL: Loaded the kernels from %s\n", path.c_str());
+            }
+            return source;
+        }
+    }
+    throw std::runtime_error(std::string("OpenCL: Can't find ") + KERNEL_FILE_NAME +
+                             " (put it next to the executable, or set GOL_OPENCL_KERNEL to its path)");
+}
+
+static void makeDirectory(const std::string& path)
+{
+#if GOL_WIN_ONLY
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0777);
+#endif
+}
+
+/// Creates the cache directory if necessary.
+/// @return the directory (with a trailing separator), or "" if there is no cache.
+static std::string getCacheDirectory()
+{
+    std::string directory;
+    if(const char* path = getenv("GOL_OPENCL_CACHE")) {
+        directory = path;
+        if(directory.empty()) {
+            return "";
+        }
+    } else {
+#if GOL_WIN_ONLY
+        const char* base = getenv("LOCALAPPDATA");
+        if(base == NULL || *base == 0) {
+            return "";
+        }
+        directory = std::string(base) + "\\GameOfLife";
+#elif GOL_MAC_ONLY
+        const char* home = getenv("HOME");
+        if(home == NULL || *home == 0) {
+            return "";
+        }
+        directory = std::string(home) + "/Library/Caches/GameOfLife";
+#else
+        const char* base = getenv("XDG_CACHE_HOME");
+        if(base != NULL && *base != 0) {
+            directory = std::string(base) + "/GameOfLife";
+        } else {
+            const char* home = getenv("HOME");
+            if(home == NULL || *home == 0) {
+                return "";
+            }
+            makeDirectory(std::string(home) + "/.cache");
+            directory = std::string(home) + "/.cache/GameOfLife";
+        }
+#endif
+    }
+    // If this fails, writing the file fails too, and the program just isn't cached.
+    makeDirectory(directory);
+    return directory + (GOL_WIN_ONLY ? "\\" : "/");
+}
+
+/// Everything that is kept between two calls of runOpenCL().
+struct OpenCLEnvironment
+{
+    cl_platform_id platform = NULL;
+    cl_device_id device = NULL;
+    cl_context context = NULL;
+    cl_command_queue queue = NULL;
+    cl_program program = NULL;
+    cl_kernel nextTileKernel = NULL;
+    cl_kernel packKernel = NULL;
+    cl_kernel unpackKernel = NULL;
+    cl_kernel countKernel = NULL;
+    cl_ulong maxAllocationSize = 0;
+
+    /// The size of the work-groups of gol_next_tile, and the largest tiles (see "About the tiles" in gol_kernel.cl).
+    size_t localWords = 0;
+    size_t localRows = 0;
+    int tileRows = 0;
+    int tileWords = 0;
+    /// The size of the halo, i.e. the maximum number of generations per launch.
+    int generationsPerLaunch = 0;
+
+    /// The two bit-packed boards on the device (double buffering). `current` is the one with the current generation.
+    cl_mem buffers[2] = {NULL, NULL};
+    size_t bufferSize = 0;
+    int current = 0;
+    /// A Board (one byte per cell) on the device, for gol_pack and gol_unpack. Only created for Board::runOpenCL().
+    cl_mem cellBuffer = NULL;
+    size_t cellBufferSize = 0;
+    /// The result of gol_count.
+    cl_mem populationBuffer = NULL;
+
+    /// The version (see BitBoard::getVersion()) of the Board or BitBoard that was downloaded last time,
+    /// or 0 if the device doesn't have a whole board.
+    uint64_t boardVersion = 0;
+    int rowCount = 0;
+    int colCount = 0;
+
+    /// The share of the rows that BitBoard::runHybrid() gives to the device, as it was tuned last time.
+    double hybridDeviceShare = 0.5;
+};
+
+/// @return the first device of that type on any platform, or NULL.
+static cl_device_id findDevice(cl_device_type type, cl_platform_id& platform)
+{
+    cl_uint platformCount = 0;
+    if(clGetPlatformIDs(0, NULL, &platformCount) != CL_SUCCESS || platformCount == 0) {
+        return NULL;
+    }
+    std::vector<cl_platform_id> platforms(platformCount);
+    if(clGetPlatformIDs(platformCount, platforms.data(), NULL) != CL_SUCCESS) {
+        return NULL;
+    }
+    for(cl_platform_id p: platforms) {
+        cl_device_id device = NULL;
+        cl_uint deviceCount = 0;
+        if(clGetDeviceIDs(p, type, 1, &device, &deviceCount) == CL_SUCCESS && deviceCount > 0) {
+            platform = p;
+            return device;
+        }
+    }
+    return NULL;
+}
+
+/// Tries to load the program from the cache.
+/// @return NULL if it isn't in the cache (or the cached binary doesn't work).
+static cl_program loadCachedProgram(OpenCLEnvironment& env, const std::string& path)
+{
+    std::string binary;
+    if(!readFile(path, binary) || binary.empty()) {
+        return NULL;
+    }
+    const size_t length = binary.size();
+    const unsigned char* data = (const unsigned char*)binary.data();
+    cl_int status = CL_SUCCESS;
+    cl_int error = CL_SUCCESS;
+    cl_program program = clCreateProgramWithBinary(env.context, 1, &env.device, &length, &data, &status, &error);
+    if(program == NULL || error != CL_SUCCESS || status != CL_SUCCESS) {
+        if(program != NULL) {
+            clReleaseProgram(program);
+        }
+        return NULL;
+    }
+    if(clBuildProgram(program, 1, &env.device, KERNEL_BUILD_OPTIONS, NULL, NULL) != CL_SUCCESS) {
+        clReleaseProgram(program);
+        return NULL;
+    }
+    return program;
+}
+
+/// Writes the binary of a program to the cache. Errors are ignored (the cache is optional).
+static void saveCachedProgram(OpenCLEnvironment& env, const std::string& path, bool verbose)
 {
-    // OpenCL code based on example code from Apple:
-    // https://developer.apple.com/library/content/documentation/Performance/Conceptual/OpenCL_MacProgGuide/ExampleHelloWorld/Example_HelloWorld.html#//apple_ref/doc/uid/TP40008312-CH112-SW2
-    
-    if(numberOfGenerations <= 0) {
+    size_t length = 0;
+    if(clGetProgramInfo(env.program, CL_PROGRAM_BINARY_SIZES, sizeof(length), &length, NULL) != CL_SUCCESS || length == 0) {
         return;
     }
-    
-    if(m_rowCount < 5 || m_colCount < 5) {
-        printf("Warning: Refusing to run OpenCL for a board that has less than 5 rows or less than 5 columns.\n"
-               "This board has %d rows and %d columns. Silently running single-threaded instead.\n", m_rowCount, m_colCount);
-        runSingleThreaded(numberOfGenerations);
+    std::vector<unsigned char> binary(length);
+    unsigned char* data = binary.data();
+    if(clGetProgramInfo(env.program, CL_PROGRAM_BINARIES, sizeof(data), &data, NULL) != CL_SUCCESS) {
+        return;
+    }
+    // Another process may be writing the same file, so it is written to a temporary file and renamed.
+    const std::string tmpPath = path + ".tmp" + std::to_string((long long)clock());
+    FILE* file = fopen(tmpPath.c_str(), "wb");
+    if(file == NULL) {
         return;
     }
-    
-    dispatch_queue_t queue = NULL;
-    
-    int size = (int)m_cells.size();
-    
-    char deviceName[128];
-    
-    // First, try to obtain a dispatch queue that can send work to the
-    // GPU in our system.
-    if(deviceType == DEVICE_TYPE_DONT_CARE || deviceType == DEVICE_TYPE_GPU_ONLY) {
-        queue = gcl_create_dispatch_queue(CL_DEVICE_TYPE_GPU, NULL);
-        if(queue == NULL && deviceType == DEVICE_TYPE_GPU_ONLY) {
+    bool ok = fwrite(data, 1, length, file) == length;
+    ok = (fclose(file) == 0) && ok;
+#if GOL_WIN_ONLY
+    ok = ok && MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+    ok = ok && rename(tmpPath.c_str(), path.c_str()) == 0;
+#endif
+    if(!ok) {
+        remove(tmpPath.c_str());
+    } else if(verbose) {
+        printf("OpenCL: Saved the compiled kernels to %s\n", path.c_str());
+    }
+}
+
+/// Builds the program from the source, or loads it from the cache.
+/// @throws std::runtime_error if the kernels don't compile.
+static void buildProgram(OpenCLEnvironment& env, bool verbose)
+{
+    const std::string source = loadKernelSource(verbose);
+
+    std::string cachePath;
+    const std::string cacheDirectory = getCacheDirectory();
+    if(!cacheDirectory.empty()) {
+        XxHash64 hash;
+        const std::string parts[] = {
+            source,
+            getPlatformString(env.platform, CL_PLATFORM_NAME),
+            getPlatformString(env.platform, CL_PLATFORM_VERSION),
+            getDeviceString(env.device, CL_DEVICE_NAME),
+            getDeviceString(env.device, CL_DEVICE_VERSION),
+            getDeviceString(env.device, CL_DRIVER_VERSION),
+            KERNEL_BUILD_OPTIONS
+        };
+        for(const std::string& part: parts) {
+            // With the terminating 0, so that "ab"+"c" and "a"+"bc" give different hashes.
+            hash.update(part.c_str(), part.size() + 1);
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "gol_kernel-%016llx.bin", (unsigned long long)hash.digest());
+        cachePath = cacheDirectory + name;
+        env.program = loadCachedProgram(env, cachePath);
+        if(env.program != NULL) {
+            if(verbose) {
+                printf("OpenCL: Loaded the compiled kernels from %s\n", cachePath.c_str());
+            }
+            return;
+        }
+    }
+
+    const char* sourceData = source.c_str();
+    const size_t sourceLength = source.size();
+    cl_int error = CL_SUCCESS;
+    env.program = clCreateProgramWithSource(env.context, 1, &sourceData, &sourceLength, &error);
+    check(error, "clCreateProgramWithSource");
+    error = clBuildProgram(env.program, 1, &env.device, KERNEL_BUILD_OPTIONS, NULL, NULL);
+    if(error != CL_SUCCESS) {
+        size_t logSize = 0;
+        clGetProgramBuildInfo(env.program, env.device, CL_PROGRAM_BUILD_LOG, 0, NULL, &logSize);
+        std::vector<char> log(logSize + 1, 0);
+        clGetProgramBuildInfo(env.program, env.device, CL_PROGRAM_BUILD_LOG, logSize, log.data(), NULL);
+        clReleaseProgram(env.program);
+        env.program = NULL;
+        throw std::runtime_error(getErrorMessage("clBuildProgram", error) + ":\n" + log.data());
+    }
+    if(!cachePath.empty()) {
+        saveCachedProgram(env, cachePath, verbose);
+    }
+}
+
+/// Chooses the work-group size, the tile size and the number of generations per launch for the device.
+static void chooseTileSize(OpenCLEnvironment& env, bool verbose)
+{
+    size_t maxGroupSize = 0;
+    check(clGetKernelWorkGroupInfo(env.nextTileKernel, env.device, CL_KERNEL_WORK_GROUP_SIZE, sizeof(maxGroupSize), &maxGroupSize, NULL),
+          "clGetKernelWorkGroupInfo");
+    cl_ulong localMemorySize = 0;
+    check(clGetDeviceInfo(env.device, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(localMemorySize), &localMemorySize, NULL), "clGetDeviceInfo");
+
+    env.localWords = std::max<size_t>(1, std::min(LOCAL_SIZE, maxGroupSize));
+    env.localRows = std::max<size_t>(1, std::min(LOCAL_SIZE, maxGroupSize / env.localWords));
+    // With the two halo words, every work-item calculates exactly one word of a row.
+    env.tileWords = std::max(1, (int)env.localWords - 2);
+
+    // The two copies of the tile (with the halo) should fit into half of the local memory,
+    // so that a GPU can run two work-groups at the same time on one compute unit.
+    int tileRows = TILE_ROWS;
+    int generations = GENERATIONS_PER_LAUNCH;
+    for(;;) {
+        cl_ulong tileBytes = (cl_ulong)(tileRows + 2*generations) * (env.tileWords + 2) * sizeof(cl_uint);
+        if(2 * tileBytes <= localMemorySize / 2) {
+            break;
+        }
+        if(tileRows > (int)env.localRows) {
+            tileRows /= 2;
+        } else if(generations > 1) {
+            generations /= 2;
+        } else {
+            break;
+        }
+    }
+    env.tileRows = tileRows;
+    env.generationsPerLaunch = generations;
+    if(verbose) {
+        printf("OpenCL: Tiles of %d rows x %d words, up to %d generations per launch, work-groups of %zux%zu\n",
+               env.tileRows, env.tileWords, env.generationsPerLaunch, env.localWords, env.localRows);
+    }
+}
+
+/// Finds a device, and builds the kernels for it. The environments are created once per device type
+/// and kept until the program exits.
+/// @throws std::runtime_error if there is no such device, or the kernels don't compile.
+static OpenCLEnvironment& getEnvironment(BitBoard::OpenCLDeviceType deviceType, bool verbose)
+{
+    // Never deleted: some OpenCL implementations crash if objects are released while the
+    // program exits (after the implementation itself was unloaded).
+    static OpenCLEnvironment* environments[3] = {NULL, NULL, NULL};
+    if(environments[deviceType] != NULL) {
+        return *environments[deviceType];
+    }
+
+    cl_platform_id platform = NULL;
+    cl_device_id device = NULL;
+
+    // First, try to find a GPU.
+    if(deviceType == BitBoard::DEVICE_TYPE_DONT_CARE || deviceType == BitBoard::DEVICE_TYPE_GPU_ONLY) {
+        device = findDevice(CL_DEVICE_TYPE_GPU, platform);
+        if(device == NULL && deviceType == BitBoard::DEVICE_TYPE_GPU_ONLY) {
             throw std::runtime_error("OpenCL: Cannot find GPU device");
         }
     }
-    
+
     // In the event that our system does NOT have an OpenCL-compatible GPU,
     // we can use the OpenCL CPU compute device instead.
-    if (queue == NULL) {
-        if(deviceType != DEVICE_TYPE_CPU_ONLY) {
-            printf("OpenCL: Didn't find GPU device. Falling back to GPU\n");
-        }
-        queue = gcl_create_dispatch_queue(CL_DEVICE_TYPE_CPU, NULL);
-    }
-    
-    // This is not required, but let's print out the name of the device
-    // we are using to do work.  We could use the same function,
-    // clGetDeviceInfo, to obtain all manner of information about the device.
-    cl_device_id gpu = gcl_get_device_id_with_dispatch_queue(queue);
-    clGetDeviceInfo(gpu, CL_DEVICE_NAME, 128, deviceName, NULL);
-    if(m_verbose) {
-        printf("OpenCL: Created a dispatch queue using the '%s'\n", deviceName);
-    }
-    
-    // Convert cell data to "alive/dead format":
-    cl_uchar* test_in = (cl_uchar*)malloc(sizeof(cl_uchar) * size);
-    for (int i = 0; i < size; i++) {
-        test_in[i] = m_cells[i] & 1;
-    }
-    
-    // Once the computation using CL is done, will have to read the results
-    // back into our application's memory space.  Allocate some space for that.
-    cl_uchar* test_out = (cl_uchar*)malloc(sizeof(cl_uchar) * size);
-    
-    void* gpuBuffer1  = gcl_malloc(sizeof(cl_uchar) * size, test_in,
-                               CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR);
-    void* gpuBuffer2 = gcl_malloc(sizeof(cl_uchar) * size, NULL, CL_MEM_READ_WRITE);
-    
-    int o_groupSize;
-    if(m_colCount >= 50) {
-        o_groupSize = 15;
-        int borders = (m_colCount-2) % o_groupSize;
-        for(int gSize = 16; gSize<25; gSize++) {
-            int newBorders = (m_colCount-2) % gSize;
-            if(newBorders <= borders) {
-                o_groupSize = gSize;
+    if(device == NULL) {
+        if(deviceType != BitBoard::DEVICE_TYPE_CPU_ONLY) {
+            printf("OpenCL: Didn't find GPU device. Falling back to CPU\n");
+        }
+        device = findDevice(CL_DEVICE_TYPE_CPU, platform);
+        if(device == NULL && deviceType == BitBoard::DEVICE_TYPE_DONT_CARE) {
+            // E.g. an accelerator card
+            device = findDevice(CL_DEVICE_TYPE_ALL, platform);
+        }
+        if(device == NULL) {
+            throw std::runtime_error("OpenCL: Cannot find CPU device (is an OpenCL runtime installed?)");
+        }
+    }
+
+    OpenCLEnvironment env;
+    env.platform = platform;
+    env.device = device;
+    if(verbose) {
+        printf("OpenCL: Using the '%s' (platform '%s', %s)\n", getDeviceString(device, CL_DEVICE_NAME).c_str(),
+               getPlatformString(platform, CL_PLATFORM_NAME).c_str(), getDeviceString(device, CL_DEVICE_VERSION).c_str());
+    }
+    check(clGetDeviceInfo(device, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(env.maxAllocationSize), &env.maxAllocationSize, NULL),
+          "clGetDeviceInfo");
+
+    cl_int error = CL_SUCCESS;
+    env.context = clCreateContext(NULL, 1, &device, NULL, NULL, &error);
+    check(error, "clCreateContext");
+    // An in-order queue: every kernel sees the results of the kernels before it, so no barriers
+    // are needed between the generations.
+    env.queue = clCreateCommandQueue(env.context, device, 0, &error);
+    check(error, "clCreateCommandQueue");
+
+    buildProgram(env, verbose);
+    env.nextTileKernel = clCreateKernel(env.program, "gol_next_tile", &error);
+    check(error, "clCreateKernel");
+    env.packKernel = clCreateKernel(env.program, "gol_pack", &error);
+    check(error, "clCreateKernel");
+    env.unpackKernel = clCreateKernel(env.program, "gol_unpack", &error);
+    check(error, "clCreateKernel");
+    env.countKernel = clCreateKernel(env.program, "gol_count", &error);
+    check(error, "clCreateKernel");
+    env.populationBuffer = clCreateBuffer(env.context, CL_MEM_READ_WRITE, sizeof(cl_uint), NULL, &error);
+    check(error, "clCreateBuffer");
+    chooseTileSize(env, verbose);
+
+    environments[deviceType] = new OpenCLEnvironment(env);
+    return *environments[deviceType];
+}
+
+static void setArgument(cl_kernel kernel, cl_uint index, size_t size, const void* value)
+{
+    check(clSetKernelArg(kernel, index, size, value), "clSetKernelArg");
+}
+
+
+/// Allocates the two bit-packed boards on the device, if they don't have the right size already.
+/// @return the number of 32-bit words per row.
+static int prepareBuffers(OpenCLEnvironment& env, int rowCount, int colCount)
+{
+    // The same as BitBoard (see gol_kernel.cl)
+    const int wordsPerRow = 2 * ((colCount + 63) / 64);
+    const size_t size = (size_t)rowCount * wordsPerRow * sizeof(cl_uint);
+    if(size > env.maxAllocationSize) {
+        throw std::runtime_error("OpenCL: The board needs " + std::to_string(size) + " bytes, but the device can only allocate " +
+                                 std::to_string(env.maxAllocationSize) + " bytes at once");
+    }
+    if(env.rowCount != rowCount || env.colCount != colCount) {
+        env.boardVersion = 0;
+        env.rowCount = rowCount;
+        env.colCount = colCount;
+    }
+    if(env.bufferSize != size) {
+        env.boardVersion = 0;
+        for(cl_mem& buffer: env.buffers) {
+            if(buffer != NULL) {
+                clReleaseMemObject(buffer);
+                buffer = NULL;
             }
         }
-    } else {
-        o_groupSize = 3;
-    }
-    if(m_verbose) {
-        printf("OpenCL: Chose kernel-groupSize=%d\n", o_groupSize);
-    }
-    
-    dispatch_sync(queue, ^{
-        int o_groupsPerCol = (m_colCount-2)/o_groupSize;
-        int o_numberOfRows = m_rowCount-2;
-        int o_workgroupSize = o_groupsPerCol * o_numberOfRows;
-        
-        // Top+bottom
-        int o2_workgroupSize = m_colCount*2;
-        
-        // Left+right
-        int o3_rightBorder = m_colCount - o_groupsPerCol*o_groupSize - 1;
-        std::vector<int> missingColumns;
-        missingColumns.push_back(0);
-        for(int i=m_colCount-o3_rightBorder; i<m_colCount; i++) {
-            missingColumns.push_back(i);
-        }
-        
-        cl_ndrange o_workgroupSize_range = makeRange(o_workgroupSize);
-        cl_ndrange o2_workgroupSize_range = makeRange(o2_workgroupSize);
-        cl_ndrange rowCount_range = makeRange(m_rowCount);
-        cl_ndrange rangeOfOne = makeRange(1);
-        
-        void (^generate)(void* gpuBuffer1, void* gpuBuffer2) = ^(void* gpuBuffer1, void* gpuBuffer2) {
-            gol_next_group_kernel(&o_workgroupSize_range,(cl_uchar*)gpuBuffer1, (cl_uchar*)gpuBuffer2, m_rowCount, m_colCount, o_groupSize);
-            gol_next_updown_kernel(&o2_workgroupSize_range,(cl_uchar*)gpuBuffer1, (cl_uchar*)gpuBuffer2, m_rowCount, m_colCount);
-            for(int c: missingColumns) {
-                gol_next_col_kernel(&rowCount_range,(cl_uchar*)gpuBuffer1, (cl_uchar*)gpuBuffer2, m_rowCount, m_colCount, c);
+        env.bufferSize = 0;
+        cl_int error = CL_SUCCESS;
+        for(cl_mem& buffer: env.buffers) {
+            buffer = clCreateBuffer(env.context, CL_MEM_READ_WRITE, size, NULL, &error);
+            check(error, "clCreateBuffer");
+        }
+        env.bufferSize = size;
+    }
+    return wordsPerRow;
+}
+
+/// Calculates the generations on env.buffers[env.current].
+static void runGenerations(OpenCLEnvironment& env, int rowCount, int colCount, int wordsPerRow, int numberOfGenerations, const Rule& rule)
+{
+    // Not more tiles than necessary on small boards
+    int tileRows = std::min(env.tileRows, rowCount);
+    int tileWords = std::min(env.tileWords, (colCount + 31) / 32);
+
+    // One work-group per tile
+    const size_t tilesPerRow = (wordsPerRow + tileWords - 1) / tileWords;
+    const size_t tilesPerCol = (rowCount + tileRows - 1) / tileRows;
+    const size_t localSize[2] = {env.localWords, env.localRows};
+    const size_t globalSize[2] = {tilesPerRow * env.localWords, tilesPerCol * env.localRows};
+
+    int birthMask = rule.getBirthMask();
+    int survivalMask = rule.getSurvivalMask();
+
+    // The arguments that are the same in every launch
+    cl_kernel kernel = env.nextTileKernel;
+    setArgument(kernel, 2, sizeof(int), &rowCount);
+    setArgument(kernel, 3, sizeof(int), &colCount);
+    setArgument(kernel, 4, sizeof(int), &wordsPerRow);
+    setArgument(kernel, 5, sizeof(int), &tileRows);
+    setArgument(kernel, 6, sizeof(int), &tileWords);
+    setArgument(kernel, 8, sizeof(int), &birthMask);
+    setArgument(kernel, 9, sizeof(int), &survivalMask);
+
+    int lastGenerations = 0;
+    for(int gIdx=0; gIdx<numberOfGenerations; ) {
+        // The last launch may calculate less generations (with a smaller halo).
+        int generations = std::min(env.generationsPerLaunch, numberOfGenerations - gIdx);
+        if(generations != lastGenerations) {
+            size_t tileBytes = (size_t)(tileRows + 2*generations) * (tileWords + 2) * sizeof(cl_uint);
+            setArgument(kernel, 7, sizeof(int), &generations);
+            setArgument(kernel, 10, tileBytes, NULL);
+            setArgument(kernel, 11, tileBytes, NULL);
+            lastGenerations = generations;
+        }
+
+        cl_mem input = env.buffers[env.current];
+        cl_mem output = env.buffers[1 - env.current];
+        setArgument(kernel, 0, sizeof(cl_mem), &input);
+        setArgument(kernel, 1, sizeof(cl_mem), &output);
+        check(clEnqueueNDRangeKernel(env.queue, kernel, 2, NULL, globalSize, localSize, 0, NULL, NULL), "clEnqueueNDRangeKernel");
+
+        env.current = 1 - env.current;
+        gIdx += generations;
+    }
+}
+
+/// Sets the arguments of gol_pack or gol_unpack and runs it on `globalSize` work-items.
+static void runConversion(OpenCLEnvironment& env, cl_kernel kernel, cl_mem input, cl_mem output, int rowCount, int colCount, int wordsPerRow,
+                          size_t globalCols)
+{
+    setArgument(kernel, 0, sizeof(cl_mem), &input);
+    setArgument(kernel, 1, sizeof(cl_mem), &output);
+    setArgument(kernel, 2, sizeof(int), &rowCount);
+    setArgument(kernel, 3, sizeof(int), &colCount);
+    setArgument(kernel, 4, sizeof(int), &wordsPerRow);
+    const size_t globalSize[2] = {globalCols, (size_t)rowCount};
+    // The local size of each workgroup => auto-detect
+    check(clEnqueueNDRangeKernel(env.queue, kernel, 2, NULL, globalSize, NULL, 0, NULL, NULL), "clEnqueueNDRangeKernel");
+}
+
+/// The words of a BitBoard are copied to the device as they are.
+/// @throws std::runtime_error if that doesn't work, because the host or the device is big-endian.
+static void checkByteOrder(const OpenCLEnvironment& env)
+{
+    // A 64-bit word is two 32-bit words on the device, the lower half first.
+    const uint16_t one = 1;
+    cl_bool littleEndianDevice = CL_FALSE;
+    check(clGetDeviceInfo(env.device, CL_DEVICE_ENDIAN_LITTLE, sizeof(littleEndianDevice), &littleEndianDevice, NULL), "clGetDeviceInfo");
+    if(*(const uint8_t*)&one != 1 || !littleEndianDevice) {
+        throw std::runtime_error("OpenCL: The bit-packed board needs a little-endian host and device");
+    }
+}
+
+void Board::runOpenCL(int numberOfGenerations, OpenCLDeviceType deviceType)
+{
+    if(numberOfGenerations <= 0 || m_cells.empty()) {
+        return;
+    }
+
+    if(m_cells.size() > INT_MAX) {
+        printf("Warning: The OpenCL kernels use 32-bit indices, but this board has %zu cells.\n"
+               "Silently running single-threaded instead.\n", m_cells.size());
+        runSingleThreaded(numberOfGenerations);
+        return;
+    }
+
+    OpenCLEnvironment& env = getEnvironment(deviceType, m_verbose);
+    const size_t size = m_cells.size();
+    const int wordsPerRow = prepareBuffers(env, m_rowCount, m_colCount);
+    if(env.cellBufferSize != size) {
+        if(env.cellBuffer != NULL) {
+            clReleaseMemObject(env.cellBuffer);
+            env.cellBuffer = NULL;
+            env.cellBufferSize = 0;
+        }
+        cl_int error = CL_SUCCESS;
+        env.cellBuffer = clCreateBuffer(env.context, CL_MEM_READ_WRITE, size, NULL, &error);
+        check(error, "clCreateBuffer");
+        env.cellBufferSize = size;
+    }
+
+    // The cells are copied as they are, and packed on the device. If the board didn't change since
+    // the last call, the device still has it.
+    const bool upload = env.boardVersion != m_version;
+    // If something fails on the way, the device has an unknown state.
+    env.boardVersion = 0;
+    if(upload) {
+        env.current = 0;
+        check(clEnqueueWriteBuffer(env.queue, env.cellBuffer, CL_FALSE, 0, size, m_cells.data(), 0, NULL, NULL), "clEnqueueWriteBuffer");
+        runConversion(env, env.packKernel, env.cellBuffer, env.buffers[0], m_rowCount, m_colCount, wordsPerRow, wordsPerRow);
+    } else if(m_verbose) {
+        printf("OpenCL: The board is still on the device, not uploading it again\n");
+    }
+
+    runGenerations(env, m_rowCount, m_colCount, wordsPerRow, numberOfGenerations, m_rule);
+
+    // Unpacked on the device too, with the neighbour counts, so the result goes straight into m_cells.
+    cl_mem result = env.buffers[env.current];
+    runConversion(env, env.unpackKernel, result, env.cellBuffer, m_rowCount, m_colCount, wordsPerRow, m_colCount);
+    const cl_uint zero = 0;
+    check(clEnqueueWriteBuffer(env.queue, env.populationBuffer, CL_FALSE, 0, sizeof(zero), &zero, 0, NULL, NULL), "clEnqueueWriteBuffer");
+    const int wordCount = m_rowCount * wordsPerRow;
+    setArgument(env.countKernel, 0, sizeof(cl_mem), &result);
+    setArgument(env.countKernel, 1, sizeof(int), &wordCount);
+    setArgument(env.countKernel, 2, sizeof(cl_mem), &env.populationBuffer);
+    const size_t countSize = wordCount;
+    check(clEnqueueNDRangeKernel(env.queue, env.countKernel, 1, NULL, &countSize, NULL, 0, NULL, NULL), "clEnqueueNDRangeKernel");
+
+    // The queue is in-order, so the (blocking) reads wait for all kernels.
+    cl_uint population = 0;
+    check(clEnqueueReadBuffer(env.queue, env.cellBuffer, CL_FALSE, 0, size, m_cells.data(), 0, NULL, NULL), "clEnqueueReadBuffer");
+    check(clEnqueueReadBuffer(env.queue, env.populationBuffer, CL_TRUE, 0, sizeof(population), &population, 0, NULL, NULL),
+          "clEnqueueReadBuffer");
+
+    // The generations in between stayed on the device.
+    m_stats.population = population;
+    m_stats.births = 0;
+    m_stats.deaths = 0;
+    markChanged();
+    env.boardVersion = m_version;
+}
+
+void BitBoard::runOpenCL(int numberOfGenerations, OpenCLDeviceType deviceType, bool verbose)
+{
+    if(numberOfGenerations <= 0 || m_words.empty()) {
+        return;
+    }
+
+    OpenCLEnvironment& env = getEnvironment(deviceType, verbose);
+    checkByteOrder(env);
+
+    if(m_words.size() * 2 > INT_MAX) {
+        printf("Warning: The OpenCL kernels use 32-bit indices, but this board has %zu words.\n"
+               "Silently running single-threaded instead.\n", m_words.size() * 2);
+        run(numberOfGenerations);
+        return;
+    }
+
+    const int wordsPerRow = prepareBuffers(env, m_rowCount, m_colCount);
+    const size_t size = m_words.size() * sizeof(uint64_t);
+    const bool upload = env.boardVersion != m_version;
+    // If something fails on the way, the device has an unknown state.
+    env.boardVersion = 0;
+    if(upload) {
+        env.current = 0;
+        check(clEnqueueWriteBuffer(env.queue, env.buffers[0], CL_FALSE, 0, size, m_words.data(), 0, NULL, NULL), "clEnqueueWriteBuffer");
+    } else if(verbose) {
+        printf("OpenCL: The board is still on the device, not uploading it again\n");
+    }
+
+    runGenerations(env, m_rowCount, m_colCount, wordsPerRow, numberOfGenerations, m_rule);
+
+    check(clEnqueueReadBuffer(env.queue, env.buffers[env.current], CL_TRUE, 0, size, m_words.data(), 0, NULL, NULL), "clEnqueueReadBuffer");
+
+    // The generations in between stayed on the device.
+    forgetPreviousGeneration();
+    env.boardVersion = m_version;
+}
+
+// About the hybrid mode:
+// BitBoard::runHybrid() splits the board into two bands: the rows [0, deviceRows) are calculated on the
+// OpenCL device, the other rows by CPU threads (with runBand(), like runTimeBlocked()). Both bands are
+// calculated at the same time, `timeBlock` (K) generations per step.
+//
+// The device has its band with K halo rows above and below, as a board of deviceRows + 2*K rows of its own.
+// That board wraps around in the wrong place, but the wrong cells move inwards by one row per generation,
+// so after K generations only the halo is wrong (the same idea as "About the tiles" in gol_kernel.cl).
+// Between two steps, only the halos are exchanged: the host uploads the K CPU rows above and below the
+// device's band, and downloads the first and the last K rows of the device's band, which are the halo of
+// the CPU band. The rest of the device's band stays on the device until the end.
+//
+// The split is tuned while it runs: after a step, the rows per second of the device and of the CPU threads
+// give the share of the rows that makes both finish at the same time. If that is a lot different from the
+// current split, the device's band is downloaded, and the new band is uploaded in the next step. This stops
+// after a few steps, or when the split doesn't change any more. The share is remembered for the next call.
+
+/// runHybrid() stops tuning the split after this number of steps.
+static const int HYBRID_TUNING_STEPS = 4;
+
+/// Copies rows of a BitBoard to env.buffers[env.current], starting at row `bufferRow`. Doesn't wait,
+/// so the rows must stay as they are until the queue is finished.
+static void writeRows(OpenCLEnvironment& env, int bufferRow, const uint64_t* rows, int rowCount, size_t rowBytes)
+{
+    check(clEnqueueWriteBuffer(env.queue, env.buffers[env.current], CL_FALSE, bufferRow * rowBytes, rowCount * rowBytes, rows, 0, NULL, NULL),
+          "clEnqueueWriteBuffer");
+}
+
+/// The opposite of writeRows(). Doesn't wait either.
+static void readRows(OpenCLEnvironment& env, int bufferRow, uint64_t* rows, int rowCount, size_t rowBytes)
+{
+    check(clEnqueueReadBuffer(env.queue, env.buffers[env.current], CL_FALSE, bufferRow * rowBytes, rowCount * rowBytes, rows, 0, NULL, NULL),
+          "clEnqueueReadBuffer");
+}
+
+void BitBoard::runHybrid(int numberOfGenerations, int timeBlock, int numberOfThreads, OpenCLDeviceType deviceType,
+                         HybridStats* stats, bool verbose)
+{
+    if(numberOfGenerations <= 0 || m_words.empty()) {
+        return;
+    }
+    if(m_rowCount < 2) {
+        // Nothing to split
+        runTimeBlocked(numberOfGenerations, timeBlock, numberOfThreads);
+        return;
+    }
+
+    OpenCLEnvironment& env = getEnvironment(deviceType, verbose);
+    checkByteOrder(env);
+
+    // Both bands have at least K rows, so that the halo of one band is always in the other band.
+    const int K = std::max(1, std::min(std::min(timeBlock, numberOfGenerations), m_rowCount / 2));
+    if((m_words.size() + 2 * K * (size_t)m_wordsPerRow) * 2 > INT_MAX) {
+        printf("Warning: The OpenCL kernels use 32-bit indices, but this board has %zu words.\n"
+               "Silently running on the CPU instead.\n", m_words.size() * 2);
+        runTimeBlocked(numberOfGenerations, K, numberOfThreads);
+        return;
+    }
+    numberOfThreads = std::max(1, numberOfThreads);
+    const size_t nw = m_wordsPerRow;
+    const size_t rowBytes = nw * sizeof(uint64_t);
+    const int bandRows = getBandRows(K);
+    std::vector<std::vector<uint64_t>> buffers(numberOfThreads, std::vector<uint64_t>(2 * (size_t)(bandRows + 2 * K) * nw));
+    m_next.resize(m_words.size());
+
+    // The device buffers have a band from now on, not the board.
+    env.boardVersion = 0;
+    auto getDeviceRows = [&](double share) {
+        return std::max(K, std::min(m_rowCount - K, (int)(share * m_rowCount + 0.5)));
+    };
+    int deviceRows = getDeviceRows(env.hybridDeviceShare);
+    int wordsPerRow = 0;
+    bool deviceHasBand = false;
+    int tuningSteps = 0;
+    HybridStats hybridStats;
+    if(verbose) {
+        printf("Hybrid: %d of %d rows on the device\n", deviceRows, m_rowCount);
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    for(int done = 0; done < numberOfGenerations; done += K) {
+        const int generations = std::min(K, numberOfGenerations - done);
+        const int cpuRows = m_rowCount - deviceRows;
+        const Clock::time_point start = Clock::now();
+
+        // The halo of the device's band: the K rows above it (at the bottom of the board) and below it.
+        const bool isNewBand = !deviceHasBand;
+        if(isNewBand) {
+            wordsPerRow = prepareBuffers(env, deviceRows + 2 * K, m_colCount);
+            env.current = 0;
+            writeRows(env, 0, getRow(m_rowCount - K), K, rowBytes);
+            writeRows(env, K, getRow(0), deviceRows + K, rowBytes);
+            deviceHasBand = true;
+        } else {
+            writeRows(env, 0, getRow(m_rowCount - K), K, rowBytes);
+            writeRows(env, K + deviceRows, getRow(deviceRows), K, rowBytes);
+        }
+        runGenerations(env, deviceRows + 2 * K, m_colCount, wordsPerRow, generations, m_rule);
+        // The halo of the CPU band
+        readRows(env, K, &m_next[0], K, rowBytes);
+        readRows(env, deviceRows, &m_next[(deviceRows - K) * nw], K, rowBytes);
+        check(clFlush(env.queue), "clFlush");
+
+        // The CPU band. The threads only read from m_words, and only write the rows [deviceRows, m_rowCount) of m_next.
+        const int bandCount = (cpuRows + bandRows - 1) / bandRows;
+        const int threadCount = std::min(numberOfThreads, bandCount);
+        std::atomic<int> nextBand(0);
+        std::vector<Clock::time_point> finished(threadCount);
+        auto worker = [&](int i) {
+            for(int band = nextBand++; band < bandCount; band = nextBand++) {
+                int bandBegin = deviceRows + band * bandRows;
+                int bandEnd = std::min(bandBegin + bandRows, m_rowCount);
+                runBand(&m_words[0], &m_next[0], bandBegin, bandEnd, generations, &buffers[i][0], nullptr);
             }
-            
-            // We need a full memory barrier after each generation, because we implicitly swap buffers.
-            // OpenCL is unhappy if we call a function without arguments, so we give it some arguments.
-            gol_rw_barrier_kernel(&rangeOfOne, (cl_uchar*)gpuBuffer1, (cl_uchar*)gpuBuffer2);
+            finished[i] = Clock::now();
         };
-        
-        for(int gIdx=0; gIdx<numberOfGenerations-1; gIdx+=2) {
-            generate(gpuBuffer1, gpuBuffer2);
-            generate(gpuBuffer2, gpuBuffer1);
-        }
-        
-        void* resultGpuBuffer;
-        
-        if(numberOfGenerations & 1) {
-            generate(gpuBuffer1, gpuBuffer2);
-            resultGpuBuffer = gpuBuffer2;
-        } else {
-            resultGpuBuffer = gpuBuffer1;
-        }
-        
-        // Getting data out of the device's memory space is also easy;
-        // use gcl_memcpy.  In this case, gcl_memcpy takes the output
-        // computed by the kernel and copies it over to the
-        // application's memory space.
-        
-        gcl_memcpy(test_out, resultGpuBuffer, sizeof(cl_uchar) * size);
-    });
-    
-    // Don't forget to free up the CL device's memory when you're done.
-    gcl_free(gpuBuffer1);
-    gcl_free(gpuBuffer2);
-    
-    for(int rowIdx=0; rowIdx<m_rowCount; rowIdx++) {
-        for(int colIdx=0; colIdx<m_colCount; colIdx++) {
-            int idx = getIndex(rowIdx, colIdx);
-            cl_uchar val = test_out[idx];
-            setCell(rowIdx, colIdx, (val != 0));
-        }
-    }
-    
-    // And the same goes for system memory, as usual.
-    free(test_in);
-    free(test_out);
-    
-    // Finally, release your queue just as you would any GCD queue.
-    dispatch_release(queue);
+        // Some implementations run the kernels while they are enqueued, so the CPU band is timed on its own.
+        const Clock::time_point cpuStart = Clock::now();
+        std::vector<std::thread> threads;
+        for(int i = 0; i < threadCount; i++) {
+            threads.push_back(std::thread(worker, i));
+        }
+        // This thread waits for the device. The threads are joined before anything is thrown.
+        const cl_int error = clFinish(env.queue);
+        const double deviceSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        for(auto& t: threads) {
+            t.join();
+        }
+        check(error, "clFinish");
+        const double cpuSeconds = std::chrono::duration<double>(*std::max_element(finished.begin(), finished.end()) - cpuStart).count();
+        hybridStats.deviceSeconds += deviceSeconds;
+        hybridStats.cpuSeconds += cpuSeconds;
+        std::swap(m_words, m_next);
+
+        // The first step of a band uploads the whole band, so it isn't a good measurement.
+        if(!isNewBand && tuningSteps < HYBRID_TUNING_STEPS && deviceSeconds > 0 && cpuSeconds > 0) {
+            tuningSteps++;
+            const double deviceSpeed = deviceRows / deviceSeconds;
+            const double cpuSpeed = cpuRows / cpuSeconds;
+            env.hybridDeviceShare = deviceSpeed / (deviceSpeed + cpuSpeed);
+            const int newDeviceRows = getDeviceRows(env.hybridDeviceShare);
+            if(abs(newDeviceRows - deviceRows) <= std::max(K, m_rowCount / 64)) {
+                // Good enough
+                tuningSteps = HYBRID_TUNING_STEPS;
+            } else if(done + generations < numberOfGenerations) {
+                readRows(env, K, &m_words[0], deviceRows, rowBytes);
+                check(clFinish(env.queue), "clFinish");
+                deviceRows = newDeviceRows;
+                deviceHasBand = false;
+                hybridStats.resplitCount++;
+                if(verbose) {
+                    printf("Hybrid: %d of %d rows on the device (device: %.0f row-generations/s, CPU: %.0f row-generations/s)\n", deviceRows, m_rowCount,
+                           deviceSpeed * generations, cpuSpeed * generations);
+                }
+            }
+        }
+    }
+
+    // The rest of the device's band
+    readRows(env, K, &m_words[0], deviceRows, rowBytes);
+    check(clFinish(env.queue), "clFinish");
+    forgetPreviousGeneration();
+    hybridStats.deviceRows = deviceRows;
+    if(stats != nullptr) {
+        *stats = hybridStats;
+    }
 }
 
 #endif // USE_OPENCL
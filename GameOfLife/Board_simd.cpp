@@ -0,0 +1,321 @@
+//
+//  Board_simd.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "Board.h"
+
+#if USE_X86_SIMD
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// Visual C++ lets us use all intrinsics without any compiler flags.
+#define GOL_TARGET(x)
+#else
+// GCC and clang want to know which functions may use which instruction set.
+#define GOL_TARGET(x) __attribute__((target(x)))
+#endif
+
+// About the SIMD kernels:
+// They do exactly the same as Board::nextGenerationRowScalar(), but for 16/32/64 cells at once.
+// For each cell they calculate a "delta":
+//   +2 if the cell is born, -2 if the cell dies, 0 otherwise.
+// The delta is added to the 3 cells above, the 2 cells left and right, and the 3 cells below.
+// The cell itself gets +1 if it is born and -1 if it dies, which sets/clears the 'alive' bit.
+// This is what setCell_unsafe() and clearCell_unsafe() do, but with 9 vector read-modify-writes
+// per 16/32/64 cells instead of 9 scalar read-modify-writes per cell. Most chunks of cells don't
+// change at all, and these are skipped after the compare. For the chunks that do change, the
+// births and deaths are counted with a popcount of the compare masks.
+//
+// The neighbours of a chunk starting at column c are in the columns c-1 .. c+width, so
+// the kernels stop before the last column of the row. Wrap-around is left to the scalar code.
+//
+// The kernels are templates over the rule (see Rule.h). A cell with n neighbours is born if
+// its value is 2n and the rule says so; it survives if its value is 2n+1 and the rule says so.
+// The Match* structs compare with these values for n = N..8, by recursion instead of a loop:
+// then only the comparisons for the counts of a StaticRule are left after compiling. (A loop
+// isn't unrolled reliably, and a lambda wouldn't get the GOL_TARGET of the kernel.)
+
+template <class R, int N>
+struct MatchSSE2
+{
+    GOL_TARGET("sse2") static inline __m128i born(const R& rule, __m128i v) {
+        __m128i rest = MatchSSE2<R, N + 1>::born(rule, v);
+        return rule.isBorn(N) ? _mm_or_si128(rest, _mm_cmpeq_epi8(v, _mm_set1_epi8(2 * N))) : rest;
+    }
+    GOL_TARGET("sse2") static inline __m128i survives(const R& rule, __m128i v) {
+        __m128i rest = MatchSSE2<R, N + 1>::survives(rule, v);
+        return rule.survives(N) ? _mm_or_si128(rest, _mm_cmpeq_epi8(v, _mm_set1_epi8(2 * N + 1))) : rest;
+    }
+};
+
+template <class R>
+struct MatchSSE2<R, 9>
+{
+    GOL_TARGET("sse2") static inline __m128i born(const R&, __m128i) { return _mm_setzero_si128(); }
+    GOL_TARGET("sse2") static inline __m128i survives(const R&, __m128i) { return _mm_setzero_si128(); }
+};
+
+template <class R, int N>
+struct MatchAVX2
+{
+    GOL_TARGET("avx2") static inline __m256i born(const R& rule, __m256i v) {
+        __m256i rest = MatchAVX2<R, N + 1>::born(rule, v);
+        return rule.isBorn(N) ? _mm256_or_si256(rest, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(2 * N))) : rest;
+    }
+    GOL_TARGET("avx2") static inline __m256i survives(const R& rule, __m256i v) {
+        __m256i rest = MatchAVX2<R, N + 1>::survives(rule, v);
+        return rule.survives(N) ? _mm256_or_si256(rest, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(2 * N + 1))) : rest;
+    }
+};
+
+template <class R>
+struct MatchAVX2<R, 9>
+{
+    GOL_TARGET("avx2") static inline __m256i born(const R&, __m256i) { return _mm256_setzero_si256(); }
+    GOL_TARGET("avx2") static inline __m256i survives(const R&, __m256i) { return _mm256_setzero_si256(); }
+};
+
+template <class R, int N>
+struct MatchAVX512
+{
+    GOL_TARGET("avx512f,avx512bw") static inline __mmask64 born(const R& rule, __m512i v) {
+        __mmask64 rest = MatchAVX512<R, N + 1>::born(rule, v);
+        return rule.isBorn(N) ? (rest | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(2 * N))) : rest;
+    }
+    GOL_TARGET("avx512f,avx512bw") static inline __mmask64 survives(const R& rule, __m512i v) {
+        __mmask64 rest = MatchAVX512<R, N + 1>::survives(rule, v);
+        return rule.survives(N) ? (rest | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(2 * N + 1))) : rest;
+    }
+};
+
+template <class R>
+struct MatchAVX512<R, 9>
+{
+    GOL_TARGET("avx512f,avx512bw") static inline __mmask64 born(const R&, __m512i) { return 0; }
+    GOL_TARGET("avx512f,avx512bw") static inline __mmask64 survives(const R&, __m512i) { return 0; }
+};
+
+template <class R>
+GOL_TARGET("sse2")
+static int nextGenerationRowSSE2(const R& rule, const char* oldRow, char* row, int colCount, GenerationStats& counts)
+{
+    char* above = row - colCount;
+    char* below = row + colCount;
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i two = _mm_set1_epi8(2);
+
+    int col = 1;
+    for (; col + 16 < colCount; col += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(oldRow + col));
+        __m128i born = MatchSSE2<R, 0>::born(rule, v);
+        __m128i alive = _mm_cmpeq_epi8(_mm_and_si128(v, one), one);
+        __m128i survives = MatchSSE2<R, 0>::survives(rule, v);
+        __m128i dies = _mm_andnot_si128(survives, alive);
+        if (_mm_movemask_epi8(_mm_or_si128(born, dies)) == 0) {
+            continue;
+        }
+        counts.births += BitBoard::popCount((unsigned)_mm_movemask_epi8(born));
+        counts.deaths += BitBoard::popCount((unsigned)_mm_movemask_epi8(dies));
+        __m128i delta = _mm_sub_epi8(_mm_and_si128(born, two), _mm_and_si128(dies, two));
+        __m128i center = _mm_sub_epi8(_mm_and_si128(born, one), _mm_and_si128(dies, one));
+
+        char* targets[8] = {
+            above + col - 1, above + col, above + col + 1,
+            row + col - 1, row + col + 1,
+            below + col - 1, below + col, below + col + 1
+        };
+        for (char* t : targets) {
+            _mm_storeu_si128((__m128i*)t, _mm_add_epi8(_mm_loadu_si128((const __m128i*)t), delta));
+        }
+        char* t = row + col;
+        _mm_storeu_si128((__m128i*)t, _mm_add_epi8(_mm_loadu_si128((const __m128i*)t), center));
+    }
+    return col;
+}
+
+template <class R>
+GOL_TARGET("avx2")
+static int nextGenerationRowAVX2(const R& rule, const char* oldRow, char* row, int colCount, GenerationStats& counts)
+{
+    char* above = row - colCount;
+    char* below = row + colCount;
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i two = _mm256_set1_epi8(2);
+
+    int col = 1;
+    for (; col + 32 < colCount; col += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(oldRow + col));
+        __m256i born = MatchAVX2<R, 0>::born(rule, v);
+        __m256i alive = _mm256_cmpeq_epi8(_mm256_and_si256(v, one), one);
+        __m256i survives = MatchAVX2<R, 0>::survives(rule, v);
+        __m256i dies = _mm256_andnot_si256(survives, alive);
+        __m256i changes = _mm256_or_si256(born, dies);
+        if (_mm256_testz_si256(changes, changes)) {
+            continue;
+        }
+        counts.births += BitBoard::popCount((unsigned)_mm256_movemask_epi8(born));
+        counts.deaths += BitBoard::popCount((unsigned)_mm256_movemask_epi8(dies));
+        __m256i delta = _mm256_sub_epi8(_mm256_and_si256(born, two), _mm256_and_si256(dies, two));
+        __m256i center = _mm256_sub_epi8(_mm256_and_si256(born, one), _mm256_and_si256(dies, one));
+
+        char* targets[8] = {
+            above + col - 1, above + col, above + col + 1,
+            row + col - 1, row + col + 1,
+            below + col - 1, below + col, below + col + 1
+        };
+        for (char* t : targets) {
+            _mm256_storeu_si256((__m256i*)t, _mm256_add_epi8(_mm256_loadu_si256((const __m256i*)t), delta));
+        }
+        char* t = row + col;
+        _mm256_storeu_si256((__m256i*)t, _mm256_add_epi8(_mm256_loadu_si256((const __m256i*)t), center));
+    }
+    return col;
+}
+
+template <class R>
+GOL_TARGET("avx512f,avx512bw")
+static int nextGenerationRowAVX512(const R& rule, const char* oldRow, char* row, int colCount, GenerationStats& counts)
+{
+    char* above = row - colCount;
+    char* below = row + colCount;
+    const __m512i one = _mm512_set1_epi8(1);
+    const __m512i two = _mm512_set1_epi8(2);
+    const __m512i minusOne = _mm512_set1_epi8(-1);
+    const __m512i minusTwo = _mm512_set1_epi8(-2);
+
+    int col = 1;
+    for (; col + 64 < colCount; col += 64) {
+        __m512i v = _mm512_loadu_si512((const void*)(oldRow + col));
+        __mmask64 born = MatchAVX512<R, 0>::born(rule, v);
+        __mmask64 alive = _mm512_test_epi8_mask(v, one);
+        __mmask64 survives = MatchAVX512<R, 0>::survives(rule, v);
+        __mmask64 dies = alive & ~survives;
+        if ((born | dies) == 0) {
+            continue;
+        }
+        counts.births += BitBoard::popCount(born);
+        counts.deaths += BitBoard::popCount(dies);
+        __m512i delta = _mm512_mask_mov_epi8(_mm512_maskz_mov_epi8(born, two), dies, minusTwo);
+        __m512i center = _mm512_mask_mov_epi8(_mm512_maskz_mov_epi8(born, one), dies, minusOne);
+
+        char* targets[8] = {
+            above + col - 1, above + col, above + col + 1,
+            row + col - 1, row + col + 1,
+            below + col - 1, below + col, below + col + 1
+        };
+        for (char* t : targets) {
+            _mm512_storeu_si512((void*)t, _mm512_add_epi8(_mm512_loadu_si512((const void*)t), delta));
+        }
+        char* t = row + col;
+        _mm512_storeu_si512((void*)t, _mm512_add_epi8(_mm512_loadu_si512((const void*)t), center));
+    }
+    return col;
+}
+
+static bool cpuSupports(Board::SimdKernel kernel)
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool avxState = (xcr0 & 0x6) == 0x6;
+    bool avx512State = (xcr0 & 0xE6) == 0xE6;
+    int ebx7 = 0;
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        ebx7 = info[1];
+    }
+    switch (kernel) {
+        case Board::SIMD_KERNEL_SCALAR: return true;
+        case Board::SIMD_KERNEL_SSE2: return sse2;
+        case Board::SIMD_KERNEL_AVX2: return avxState && (ebx7 & (1 << 5)) != 0;
+        case Board::SIMD_KERNEL_AVX512: return avx512State && (ebx7 & (1 << 16)) != 0 && (ebx7 & (1 << 30)) != 0;
+    }
+    return false;
+#else
+    __builtin_cpu_init();
+    switch (kernel) {
+        case Board::SIMD_KERNEL_SCALAR: return true;
+        case Board::SIMD_KERNEL_SSE2: return __builtin_cpu_supports("sse2");
+        case Board::SIMD_KERNEL_AVX2: return __builtin_cpu_supports("avx2");
+        case Board::SIMD_KERNEL_AVX512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    }
+    return false;
+#endif
+}
+
+#else // USE_X86_SIMD
+
+static bool cpuSupports(Board::SimdKernel kernel)
+{
+    return kernel == Board::SIMD_KERNEL_SCALAR;
+}
+
+#endif // USE_X86_SIMD
+
+static Board::SimdKernel detectSimdKernel()
+{
+    const Board::SimdKernel preferred[] = { Board::SIMD_KERNEL_AVX512, Board::SIMD_KERNEL_AVX2, Board::SIMD_KERNEL_SSE2 };
+    for (Board::SimdKernel kernel : preferred) {
+        if (cpuSupports(kernel)) {
+            return kernel;
+        }
+    }
+    return Board::SIMD_KERNEL_SCALAR;
+}
+
+static Board::SimdKernel s_simdKernel = detectSimdKernel();
+
+Board::SimdKernel Board::getSimdKernel()
+{
+    return s_simdKernel;
+}
+
+bool Board::setSimdKernel(SimdKernel kernel)
+{
+    if (!isSimdKernelSupported(kernel)) {
+        return false;
+    }
+    s_simdKernel = kernel;
+    return true;
+}
+
+bool Board::isSimdKernelSupported(SimdKernel kernel)
+{
+    return cpuSupports(kernel);
+}
+
+const char* Board::getSimdKernelName(SimdKernel kernel)
+{
+    switch (kernel) {
+        case SIMD_KERNEL_SCALAR: return "scalar";
+        case SIMD_KERNEL_SSE2: return "SSE2";
+        case SIMD_KERNEL_AVX2: return "AVX2";
+        case SIMD_KERNEL_AVX512: return "AVX-512BW";
+    }
+    return "unknown";
+}
+
+int Board::nextGenerationRowSimd(SimdKernel kernel, const Rule& rule, const char* oldRow, char* row, int colCount,
+                                 GenerationStats& counts)
+{
+    return withStaticRule(rule, [&](const auto& r) {
+        switch (kernel) {
+#if USE_X86_SIMD
+            case SIMD_KERNEL_SSE2: return nextGenerationRowSSE2(r, oldRow, row, colCount, counts);
+            case SIMD_KERNEL_AVX2: return nextGenerationRowAVX2(r, oldRow, row, colCount, counts);
+            case SIMD_KERNEL_AVX512: return nextGenerationRowAVX512(r, oldRow, row, colCount, counts);
+#endif
+            default: return 1;
+        }
+    });
+}
@@ -0,0 +1,107 @@
+//
+//  Board_threads.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "Board.h"
+#include "Barrier.h"
+#include "ThreadPool.h"
+#include <thread>
+#include <string.h>
+
+// About the partitioning:
+// Like runOpenMP(), every thread gets a slice of rows. Calculating a row modifies the
+// neighbour counts of the row above and the row below, so the first and the last row
+// of a slice touch the neighbouring slices. runOpenMP() calculates these edge rows
+// serially after every generation. Here, every generation has three phases instead:
+//
+//   1. every thread calculates the inner rows of its slice (only touches its own slice)
+//   2. every thread calculates the first row of its slice
+//   3. every thread calculates the last row of its slice
+//
+// with a barrier after each phase. A slice has at least 3 rows, so the rows that are
+// written in phase 2 (or phase 3) by different threads never overlap.
+// Before phase 1, every thread saves the old state of its first and last row, because
+// these are modified by the neighbouring threads. (See Board::nextGeneration(int, int, std::vector<char>&))
+
+int Board::getDefaultThreadCount()
+{
+    unsigned int n = std::thread::hardware_concurrency();
+    return n > 0 ? (int)n : 4;
+}
+
+void Board::runThreaded(int numberOfGenerations, int numberOfThreads)
+{
+    if (numberOfGenerations <= 0) {
+        return;
+    }
+
+    if (m_rowCount < 3) {
+        printf("Warning: Refusing to run multi-threaded for a board that has less than 3 rows.\n"
+            "This board has %d rows and %d columns. Silently running single-threaded instead.\n", m_rowCount, m_colCount);
+        runSingleThreaded(numberOfGenerations);
+        return;
+    }
+
+    if (numberOfThreads > m_rowCount / 3) {
+        int newNumberOfThreads = m_rowCount / 3;
+        printf("Warning: Refusing to run with %d threads when having just %d rows. Will use %d threads instead.\n", numberOfThreads, m_rowCount, newNumberOfThreads);
+        numberOfThreads = newNumberOfThreads;
+    }
+
+    if (m_verbose) {
+        printf("Threads: Running %d threads with the %s kernel\n", numberOfThreads, getSimdKernelName(getSimdKernel()));
+    }
+
+    std::vector<int> slicesBegin;
+    for (int i = 0; i <= numberOfThreads; i++) {
+        slicesBegin.push_back((int)((long long)m_rowCount * i / numberOfThreads));
+    }
+
+    Barrier barrier(numberOfThreads);
+    // Every thread counts the births and deaths of its slice: in all generations (for the population)
+    // and in the last generation. They are added up when all threads are done.
+    std::vector<GenerationStats> totalCounts(numberOfThreads);
+    std::vector<GenerationStats> lastCounts(numberOfThreads);
+
+    auto worker = [&](int i) {
+        int rowBegin = slicesBegin[i];
+        int rowEnd = slicesBegin[i + 1];
+        std::vector<char> oldFirstRow(m_colCount);
+        std::vector<char> oldLastRow(m_colCount);
+        std::vector<char> rowBuffer;
+        GenerationStats total;
+        GenerationStats counts;
+        for (int gIdx = 0; gIdx < numberOfGenerations; gIdx++) {
+            // Nobody else writes to this slice until the first barrier.
+            memcpy(&oldFirstRow[0], &m_cells[getIndex(rowBegin, 0)], m_colCount);
+            memcpy(&oldLastRow[0], &m_cells[getIndex(rowEnd - 1, 0)], m_colCount);
+
+            counts = GenerationStats();
+            nextGeneration(rowBegin + 1, rowEnd - 1, rowBuffer, counts);
+            barrier.wait();
+            nextGenerationRow(&oldFirstRow[0], rowBegin, counts);
+            barrier.wait();
+            nextGenerationRow(&oldLastRow[0], rowEnd - 1, counts);
+            barrier.wait();
+            total.births += counts.births;
+            total.deaths += counts.deaths;
+        }
+        totalCounts[i] = total;
+        lastCounts[i] = counts;
+    };
+
+    m_threadPool.run(numberOfThreads, worker);
+    GenerationStats counts;
+    for (int i = 0; i < numberOfThreads; i++) {
+        m_stats.population += totalCounts[i].births - totalCounts[i].deaths;
+        counts.births += lastCounts[i].births;
+        counts.deaths += lastCounts[i].deaths;
+    }
+    m_stats.births = counts.births;
+    m_stats.deaths = counts.deaths;
+    markChanged();
+}
@@ -0,0 +1,181 @@
+//
+//  Board_tiles.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "Board.h"
+#include <algorithm>
+#include <utility>
+#include <stdint.h>
+#include <string.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// About the tiles:
+// The board is divided into tiles of TILE_SIZE*TILE_SIZE cells. A cell can only change in
+// this generation if the cell itself or one of its neighbours changed in the previous
+// generation. So a tile only has to be looked at if a cell in the tile changed in the
+// previous generation, or if a cell at the border of one of its 8 neighbour tiles changed.
+// On boards that have settled down to still lifes and empty space, this skips almost all
+// of the board.
+//
+// Each generation has two passes:
+//   1. Look at the active tiles and write down which cells change. (Nothing is modified.)
+//   2. Set/clear all these cells and mark their tiles (and the neighbour tiles, if the cell
+//      is at the border) as active for the next generation.
+// Because nothing is modified in pass 1, we don't need a copy of the old state of the cells.
+
+static const int TILE_SIZE = 64;
+
+/// Does a cell with this value (see the memory layout in Board.h) change in the next generation?
+template <class R>
+static inline bool cellChanges(const R& rule, char val)
+{
+    int neighbours = val >> 1;
+    return (val & 1) ? !rule.survives(neighbours) : rule.isBorn(neighbours);
+}
+
+/// 0x80 in every byte of x that is zero, 0x00 in all other bytes.
+static inline uint64_t zeroBytes(uint64_t x)
+{
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    return ~(((x & low7) + low7) | x | low7);
+}
+
+/// Looks at 8 cells at once. Returns 0x80 in every byte where the cell will change, 0x00 otherwise.
+/// (Assumes a little-endian CPU, so byte i of the result is the cell at cells[i].)
+template <class R>
+static inline uint64_t changeMask8(const R& rule, const char* cells)
+{
+    const uint64_t ones = 0x0101010101010101ULL;
+    uint64_t w;
+    memcpy(&w, cells, 8);
+    // A dead cell with n neighbours has the value 2n, a living one 2n+1.
+    uint64_t born = 0;
+    uint64_t survives = 0;
+    forEachBirthCount(rule, [&](int n) { born |= zeroBytes(w ^ (ones * (2 * n))); });
+    forEachSurvivalCount(rule, [&](int n) { survives |= zeroBytes(w ^ (ones * (2 * n + 1))); });
+    uint64_t alive = (w & ones) << 7;
+    return born | (alive & ~survives);
+}
+
+static inline int countTrailingZeros(uint64_t x)
+{
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return (int)idx;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+void Board::runTiles(int numberOfGenerations)
+{
+    if (numberOfGenerations <= 0 || m_cells.empty()) {
+        return;
+    }
+
+    const int tileRowCount = (m_rowCount + TILE_SIZE - 1) / TILE_SIZE;
+    const int tileColCount = (m_colCount + TILE_SIZE - 1) / TILE_SIZE;
+    const int tileCount = tileRowCount * tileColCount;
+
+    // In the first generation, we don't know what changed before, so everything is active.
+    std::vector<char> tileActive(tileCount, 1);
+    std::vector<std::pair<int, int>> changedCells; // (row, col)
+
+    for (int gIdx = 0; gIdx < numberOfGenerations; gIdx++) {
+        // Pass 1
+        changedCells.clear();
+        int activeTileCount = 0;
+        withStaticRule(m_rule, [&](const auto& rule) {
+            for (int tRow = 0; tRow < tileRowCount; tRow++) {
+                int rowBegin = tRow * TILE_SIZE;
+                int rowEnd = std::min(rowBegin + TILE_SIZE, m_rowCount);
+                for (int tCol = 0; tCol < tileColCount; tCol++) {
+                    if (!tileActive[tRow * tileColCount + tCol]) {
+                        continue;
+                    }
+                    activeTileCount++;
+                    int colBegin = tCol * TILE_SIZE;
+                    int colEnd = std::min(colBegin + TILE_SIZE, m_colCount);
+                    for (int row = rowBegin; row < rowEnd; row++) {
+                        const char* cells = &m_cells[getIndex(row, 0)];
+                        int col = colBegin;
+                        if (colEnd - colBegin == TILE_SIZE) {
+                            // Most rows of a tile don't change at all, so check the whole row first.
+                            uint64_t any = 0;
+                            for (int i = 0; i < TILE_SIZE; i += 8) {
+                                any |= changeMask8(rule, cells + col + i);
+                            }
+                            if (any == 0) {
+                                continue;
+                            }
+                        }
+                        for (; col + 8 <= colEnd; col += 8) {
+                            uint64_t mask = changeMask8(rule, cells + col);
+                            while (mask != 0) {
+                                changedCells.push_back(std::make_pair(row, col + countTrailingZeros(mask) / 8));
+                                mask &= mask - 1;
+                            }
+                        }
+                        for (; col < colEnd; col++) {
+                            if (cellChanges(rule, cells[col])) {
+                                changedCells.push_back(std::make_pair(row, col));
+                            }
+                        }
+                    }
+                }
+            }
+        });
+
+        if (m_verbose) {
+            printf("Tiles: generation %d: processed %d of %d tiles (%.1f%%)\n",
+                gIdx + 1, activeTileCount, tileCount, 100.0 * activeTileCount / tileCount);
+        }
+
+        // Pass 2
+        // The tiles for the next generation: the tiles of all changed cells and of their neighbours.
+        // Most changes are not at the border of a tile, so most of the time that's just one tile.
+        std::fill(tileActive.begin(), tileActive.end(), 0);
+        GenerationStats counts;
+        for (const auto& cell : changedCells) {
+            int row = cell.first;
+            int col = cell.second;
+            if (getCell(row, col)) {
+                clearCell_unsafe(row, col);
+                counts.deaths++;
+            } else {
+                setCell_unsafe(row, col);
+                counts.births++;
+            }
+            int rowInTile = row % TILE_SIZE;
+            int colInTile = col % TILE_SIZE;
+            if (rowInTile != 0 && rowInTile != TILE_SIZE - 1 && row != m_rowCount - 1
+                && colInTile != 0 && colInTile != TILE_SIZE - 1 && col != m_colCount - 1) {
+                tileActive[(row / TILE_SIZE) * tileColCount + col / TILE_SIZE] = 1;
+                continue;
+            }
+            int tRows[3] = {
+                (row == 0 ? m_rowCount - 1 : row - 1) / TILE_SIZE,
+                row / TILE_SIZE,
+                (row == m_rowCount - 1 ? 0 : row + 1) / TILE_SIZE
+            };
+            int tCols[3] = {
+                (col == 0 ? m_colCount - 1 : col - 1) / TILE_SIZE,
+                col / TILE_SIZE,
+                (col == m_colCount - 1 ? 0 : col + 1) / TILE_SIZE
+            };
+            for (int tRow : tRows) {
+                for (int tCol : tCols) {
+                    tileActive[tRow * tileColCount + tCol] = 1;
+                }
+            }
+        }
+        finishGeneration(counts);
+    }
+}
@@ -0,0 +1,246 @@
+//
+//  Checkpoint.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "Checkpoint.h"
+#include "BoardIO.h"
+#include "MappedFile.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if GOL_WIN_ONLY
+#include <windows.h>
+#include <direct.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// About crash consistency:
+// A checkpoint is written to "NAME.tmp" first, flushed to the disk, and then renamed to NAME.
+// The rename replaces the directory entry atomically, so NAME is either missing or complete,
+// even if the computer crashes in the middle. The old checkpoints are only deleted after the new
+// one is on the disk. If a file is broken anyway (e.g. the disk lied about the flush),
+// the checksum catches it and findLatest() takes the one before.
+
+static const char CHECKPOINT_PREFIX[] = "checkpoint-";
+static const char CHECKPOINT_SUFFIX[] = ".golb";
+
+static std::string getCheckpointName(int64_t generation) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s%012lld%s", CHECKPOINT_PREFIX, (long long)generation, CHECKPOINT_SUFFIX);
+    return buf;
+}
+
+/// @return the generation, or -1 if the name isn't the name of a checkpoint.
+static int64_t parseCheckpointName(const char* name) {
+    const size_t prefixLength = sizeof(CHECKPOINT_PREFIX) - 1;
+    if (strncmp(name, CHECKPOINT_PREFIX, prefixLength) != 0 || name[prefixLength] < '0' || name[prefixLength] > '9') {
+        return -1;
+    }
+    char* end = nullptr;
+    long long generation = strtoll(name + prefixLength, &end, 10);
+    if (strcmp(end, CHECKPOINT_SUFFIX) != 0) {
+        return -1;
+    }
+    return generation;
+}
+
+/// The checkpoints in a directory, sorted by generation (newest first).
+static std::vector<std::pair<int64_t, std::string>> listCheckpoints(const std::string& directory) {
+    std::vector<std::pair<int64_t, std::string>> checkpoints;
+    auto addFile = [&](const char* name) {
+        int64_t generation = parseCheckpointName(name);
+        if (generation >= 0) {
+            checkpoints.push_back(std::make_pair(generation, directory + "/" + name));
+        }
+    };
+#if GOL_WIN_ONLY
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA((directory + "\\*").c_str(), &data);
+    if (find != INVALID_HANDLE_VALUE) {
+        do {
+            addFile(data.cFileName);
+        } while (FindNextFileA(find, &data));
+        FindClose(find);
+    }
+#else
+    DIR* dir = opendir(directory.c_str());
+    if (dir != NULL) {
+        while (struct dirent* entry = readdir(dir)) {
+            addFile(entry->d_name);
+        }
+        closedir(dir);
+    }
+#endif
+    std::sort(checkpoints.begin(), checkpoints.end(), [](const std::pair<int64_t, std::string>& a, const std::pair<int64_t, std::string>& b) {
+        return a.first > b.first;
+    });
+    return checkpoints;
+}
+
+/// Waits until the file is on the disk.
+static void syncFile(const std::string& path) {
+#if GOL_WIN_ONLY
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("CreateFile failed for file at " + path);
+    }
+    bool ok = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("open failed for file at " + path);
+    }
+    bool ok = fsync(fd) == 0;
+    close(fd);
+#endif
+    if (!ok) {
+        throw std::runtime_error("Flushing failed for file at " + path);
+    }
+}
+
+/// Renames `from` to `to` (replacing `to`), and waits until the new name is on the disk.
+static void replaceFile(const std::string& from, const std::string& to, const std::string& directory) {
+#if GOL_WIN_ONLY
+    if (!MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        throw std::runtime_error("MoveFileEx failed for file at " + from);
+    }
+#else
+    if (rename(from.c_str(), to.c_str()) != 0) {
+        throw std::runtime_error("rename failed for file at " + from);
+    }
+    // The rename is only on the disk when the directory is.
+    int fd = open(directory.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+}
+
+Checkpointer::Checkpointer(const std::string& directory, int numberToKeep) {
+    m_directory = directory;
+    m_numberToKeep = std::max(1, numberToKeep);
+#if GOL_WIN_ONLY
+    bool ok = _mkdir(directory.c_str()) == 0;
+#else
+    bool ok = mkdir(directory.c_str(), 0777) == 0;
+#endif
+    if (!ok && errno != EEXIST) {
+        throw std::runtime_error("Can't create the directory " + directory);
+    }
+}
+
+Checkpointer::~Checkpointer() {
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+}
+
+std::string Checkpointer::save(const BitBoard& board, int64_t generation) {
+    std::string previousError = finishWriting();
+    m_snapshot.copyFrom(board);
+    startWriting(generation);
+    return previousError;
+}
+
+std::string Checkpointer::save(const Board& board, int64_t generation) {
+    std::string previousError = finishWriting();
+    m_snapshot.copyFrom(board);
+    startWriting(generation);
+    return previousError;
+}
+
+void Checkpointer::startWriting(int64_t generation) {
+    m_writer = std::thread([this, generation]() {
+        try {
+            write(generation);
+        }
+        catch (...) {
+            m_error = std::current_exception();
+            m_errorGeneration = generation;
+        }
+    });
+}
+
+std::string Checkpointer::finishWriting() {
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+    if (!m_error) {
+        return "";
+    }
+    std::string message = "The checkpoint at generation " + std::to_string(m_errorGeneration) + " failed: ";
+    try {
+        std::rethrow_exception(m_error);
+    }
+    catch (const std::exception& e) {
+        message += e.what();
+    }
+    catch (...) {
+        message += "unknown error";
+    }
+    m_error = nullptr;
+    return message;
+}
+
+void Checkpointer::wait() {
+    std::string error = finishWriting();
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+}
+
+void Checkpointer::write(int64_t generation) {
+    const std::string path = m_directory + "/" + getCheckpointName(generation);
+    const std::string tmpPath = path + ".tmp";
+    BoardIO::saveBinary(m_snapshot, tmpPath, generation);
+    syncFile(tmpPath);
+    replaceFile(tmpPath, path, m_directory);
+    deleteOldCheckpoints(generation);
+}
+
+void Checkpointer::deleteOldCheckpoints(int64_t generation) {
+    // Checkpoints after `generation` are left over from an earlier run (they were broken, or
+    // the run wasn't resumed), they would be taken instead of ours by findLatest().
+    int kept = 0;
+    for (const auto& checkpoint : listCheckpoints(m_directory)) {
+        if (checkpoint.first <= generation && kept < m_numberToKeep) {
+            kept++;
+        } else {
+            remove(checkpoint.second.c_str());
+        }
+    }
+}
+
+bool Checkpointer::findLatest(const std::string& directory, std::string& path, int64_t& generation) {
+    for (const auto& checkpoint : listCheckpoints(directory)) {
+        try {
+            MappedFile file(checkpoint.second);
+            BoardIO::BinaryFileInfo info = BoardIO::getBinaryFileInfo(file, checkpoint.second);
+            if (info.generation == checkpoint.first) {
+                path = checkpoint.second;
+                generation = checkpoint.first;
+                return true;
+            }
+        }
+        catch (const std::exception&) {
+            // Broken, try the one before.
+        }
+    }
+    return false;
+}
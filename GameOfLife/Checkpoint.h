@@ -0,0 +1,76 @@
+//
+//  Checkpoint.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef Checkpoint_h
+#define Checkpoint_h
+
+#include "gol-config.h"
+#include "BitBoard.h"
+#include "Board.h"
+#include <stdint.h>
+#include <exception>
+#include <string>
+#include <thread>
+
+/// Writes checkpoints of a long run into a directory, so that it can be resumed after a crash.
+/// A checkpoint is a binary board file (.golb) with the generation and the rule in the header,
+/// named "checkpoint-GENERATION.golb".
+///
+/// save() only copies the board; the file is written by a background thread while the
+/// calculation goes on. Only one checkpoint is written at a time, so save() waits if the
+/// previous one isn't finished yet. A failed checkpoint doesn't stop the next one.
+class Checkpointer
+{
+public:
+    /// Creates the directory if it doesn't exist.
+    /// @param numberToKeep How many of the newest checkpoints are kept, the older ones are deleted.
+    /// @throws std::runtime_error if the directory can't be created.
+    explicit Checkpointer(const std::string& directory, int numberToKeep = DEFAULT_NUMBER_TO_KEEP);
+    /// Waits until the last checkpoint is written. Errors are ignored, call wait() to get them.
+    ~Checkpointer();
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    /// Waits for the previous checkpoint, and starts writing a checkpoint of `board` at `generation`.
+    /// @return The error of the previous checkpoint, or "" if it was written.
+    std::string save(const BitBoard& board, int64_t generation);
+    std::string save(const Board& board, int64_t generation);
+    /// Waits until the last checkpoint is written.
+    /// @throws std::runtime_error if writing it failed.
+    void wait();
+
+    /// Finds the newest checkpoint in a directory whose header and checksum are valid.
+    /// Checkpoints that are broken (e.g. because the computer crashed while writing them) are skipped.
+    /// @return false if there is no valid checkpoint (or no directory).
+    static bool findLatest(const std::string& directory, std::string& path, int64_t& generation);
+
+    static const int DEFAULT_NUMBER_TO_KEEP = 2;
+
+private:
+    /// Writes m_snapshot (on the background thread).
+    void write(int64_t generation);
+    /// Starts write() on the background thread.
+    void startWriting(int64_t generation);
+    /// Waits for the background thread.
+    /// @return The error of the checkpoint it wrote, or "".
+    std::string finishWriting();
+    /// Deletes all checkpoints except the newest m_numberToKeep ones up to `generation`.
+    void deleteOldCheckpoints(int64_t generation);
+
+    std::string m_directory;
+    int m_numberToKeep;
+    /// The copy of the board that is written, so the original board can go on.
+    BitBoard m_snapshot;
+    std::thread m_writer;
+    /// The error of the last write(), if it failed.
+    std::exception_ptr m_error;
+    int64_t m_errorGeneration = 0;
+};
+
+#endif // Checkpoint_h
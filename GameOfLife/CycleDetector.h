@@ -0,0 +1,110 @@
+//
+//  CycleDetector.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef CycleDetector_h
+#define CycleDetector_h
+
+#include "gol-config.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+
+// About cycle detection:
+// Most boards end up as still lifes and oscillators after a few thousand generations.
+// Then the board at generation g is the same as at generation g - p, and it will repeat
+// every p generations from then on. So we remember the hashes of the last generations,
+// and when a hash comes again, we run p more generations and compare the boards, to be
+// sure that it wasn't a hash collision. If the board is the same, all generations that
+// are a multiple of p are skipped. The result is exactly the same as without skipping.
+//
+// Hashing the board costs about as much as a generation, and the engines are faster with
+// many generations per run, so only every `checkInterval`-th generation is hashed. Then the
+// hashes find a multiple of the period; the period itself is the smallest divisor of it
+// after which the board is the same again.
+
+/// What runWithCycleDetection() found.
+struct CycleInfo {
+    bool found = false;
+    /// The first hashed generation in the cycle. The transient phase isn't longer than this, and the cycle
+    /// starts less than `checkInterval` generations earlier.
+    int64_t transientUpperBound = 0;
+    /// 1 for a still life.
+    int64_t period = 0;
+    int64_t skippedGenerations = 0;
+};
+
+/// Runs `numberOfGenerations` generations of `board` with `run(board, n)`, which must calculate
+/// n generations. Stops early when the board repeats. `BoardType` is Board or BitBoard.
+/// @param maxPeriod Only cycles up to this period are found. (Needs 32 bytes per hashed generation.)
+/// @param checkInterval The board is hashed every `checkInterval` generations.
+template <class BoardType>
+CycleInfo runWithCycleDetection(BoardType& board, int64_t numberOfGenerations,
+                                const std::function<void(BoardType&, int)>& run, int64_t maxPeriod = 65536,
+                                int checkInterval = 16)
+{
+    CycleInfo info;
+    std::unordered_map<uint64_t, int64_t> generationOfHash;
+    // The hashes with their generations, the oldest first.
+    std::deque<std::pair<uint64_t, int64_t>> recentHashes;
+    int64_t generation = 0;
+    uint64_t hash = board.getHash();
+    generationOfHash[hash] = 0;
+    recentHashes.push_back(std::make_pair(hash, generation));
+
+    while (generation < numberOfGenerations) {
+        const int64_t steps = std::min((int64_t)std::max(1, checkInterval), numberOfGenerations - generation);
+        run(board, (int)steps);
+        generation += steps;
+        while (!recentHashes.empty() && recentHashes.front().second < generation - maxPeriod) {
+            auto oldest = generationOfHash.find(recentHashes.front().first);
+            if (oldest != generationOfHash.end() && oldest->second == recentHashes.front().second) {
+                generationOfHash.erase(oldest);
+            }
+            recentHashes.pop_front();
+        }
+        hash = board.getHash();
+        auto it = generationOfHash.find(hash);
+        if (it != generationOfHash.end()) {
+            // The board repeats after `multiple` generations, so the period is a divisor of it.
+            const int64_t multiple = generation - it->second;
+            if (generation + multiple <= numberOfGenerations) {
+                const BoardType start = board;
+                int64_t period = 0;
+                bool isSame = false;
+                for (int64_t d = 1; d <= multiple && !isSame; d++) {
+                    if (multiple % d == 0) {
+                        run(board, (int)(d - period));
+                        period = d;
+                        isSame = board == start;
+                    }
+                }
+                generation += period;
+                if (isSame) {
+                    int64_t remaining = (numberOfGenerations - generation) % period;
+                    run(board, (int)remaining);
+                    info.found = true;
+                    info.transientUpperBound = it->second;
+                    info.period = period;
+                    info.skippedGenerations = numberOfGenerations - generation - remaining;
+                    return info;
+                }
+                // A hash collision. Very unlikely, but let's just go on.
+                hash = board.getHash();
+            }
+        }
+        generationOfHash[hash] = generation;
+        recentHashes.push_back(std::make_pair(hash, generation));
+    }
+    return info;
+}
+
+#endif // CycleDetector_h
@@ -0,0 +1,144 @@
+//
+//  Hash.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "Hash.h"
+#include <string.h>
+#include <algorithm>
+
+static const uint64_t PRIME1 = 11400714785074694791ULL;
+static const uint64_t PRIME2 = 14029467366897019727ULL;
+static const uint64_t PRIME3 = 1609587929392839161ULL;
+static const uint64_t PRIME4 = 9650029242287828579ULL;
+static const uint64_t PRIME5 = 2870177450012600261ULL;
+
+static inline uint64_t rotateLeft(uint64_t x, int bits) {
+    return (x << bits) | (x >> (64 - bits));
+}
+
+// The file formats are little-endian, and so are all CPUs that we run on.
+static inline uint64_t read64(const unsigned char* p) {
+    uint64_t x;
+    memcpy(&x, p, 8);
+    return x;
+}
+
+static inline uint32_t read32(const unsigned char* p) {
+    uint32_t x;
+    memcpy(&x, p, 4);
+    return x;
+}
+
+static inline uint64_t round64(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    acc = rotateLeft(acc, 31);
+    return acc * PRIME1;
+}
+
+static inline uint64_t mergeRound(uint64_t acc, uint64_t val) {
+    acc ^= round64(0, val);
+    return acc * PRIME1 + PRIME4;
+}
+
+/// Hashes the last bytes (less than 32) and mixes the result.
+static uint64_t finish(uint64_t h, const unsigned char* p, const unsigned char* end) {
+    while (p + 8 <= end) {
+        h ^= round64(0, read64(p));
+        h = rotateLeft(h, 27) * PRIME1 + PRIME4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * PRIME1;
+        h = rotateLeft(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * PRIME5;
+        h = rotateLeft(h, 11) * PRIME1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+static inline uint64_t mergeAccumulators(const uint64_t v[4]) {
+    uint64_t h = rotateLeft(v[0], 1) + rotateLeft(v[1], 7) + rotateLeft(v[2], 12) + rotateLeft(v[3], 18);
+    for (int i = 0; i < 4; i++) {
+        h = mergeRound(h, v[i]);
+    }
+    return h;
+}
+
+/// Hashes as many 32 byte stripes as possible, returns the end of the last stripe.
+static inline const unsigned char* hashStripes(uint64_t v[4], const unsigned char* p, const unsigned char* end) {
+    while (p + 32 <= end) {
+        v[0] = round64(v[0], read64(p));
+        v[1] = round64(v[1], read64(p + 8));
+        v[2] = round64(v[2], read64(p + 16));
+        v[3] = round64(v[3], read64(p + 24));
+        p += 32;
+    }
+    return p;
+}
+
+static inline void initAccumulators(uint64_t v[4], uint64_t seed) {
+    v[0] = seed + PRIME1 + PRIME2;
+    v[1] = seed + PRIME2;
+    v[2] = seed;
+    v[3] = seed - PRIME1;
+}
+
+uint64_t xxHash64(const void* data, size_t length, uint64_t seed) {
+    const unsigned char* p = (const unsigned char*)data;
+    const unsigned char* end = p + length;
+    uint64_t h;
+    if (length >= 32) {
+        uint64_t v[4];
+        initAccumulators(v, seed);
+        p = hashStripes(v, p, end);
+        h = mergeAccumulators(v);
+    } else {
+        h = seed + PRIME5;
+    }
+    h += (uint64_t)length;
+    return finish(h, p, end);
+}
+
+XxHash64::XxHash64(uint64_t seed) : m_seed(seed) {
+    initAccumulators(m_v, seed);
+}
+
+void XxHash64::update(const void* data, size_t length) {
+    const unsigned char* p = (const unsigned char*)data;
+    const unsigned char* end = p + length;
+    m_totalLength += length;
+    if (m_bufferLength > 0) {
+        size_t n = std::min(length, sizeof(m_buffer) - m_bufferLength);
+        memcpy(m_buffer + m_bufferLength, p, n);
+        m_bufferLength += n;
+        p += n;
+        if (m_bufferLength < sizeof(m_buffer)) {
+            return;
+        }
+        hashStripes(m_v, m_buffer, m_buffer + sizeof(m_buffer));
+        m_bufferLength = 0;
+    }
+    p = hashStripes(m_v, p, end);
+    memcpy(m_buffer, p, end - p);
+    m_bufferLength = end - p;
+}
+
+uint64_t XxHash64::digest() const {
+    uint64_t h = m_totalLength >= 32 ? mergeAccumulators(m_v) : m_seed + PRIME5;
+    h += m_totalLength;
+    return finish(h, m_buffer, m_buffer + m_bufferLength);
+}
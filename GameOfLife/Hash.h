@@ -0,0 +1,37 @@
+//
+//  Hash.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef Hash_h
+#define Hash_h
+
+#include "gol-config.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/// The XXH64 hash function (https://github.com/Cyan4973/xxHash). Fast (several GB/s) and
+/// good enough to detect corrupted files, but not a cryptographic hash.
+uint64_t xxHash64(const void* data, size_t length, uint64_t seed = 0);
+
+/// XXH64 for data that comes in pieces. Gives the same result as xxHash64() for the
+/// concatenation of all pieces.
+class XxHash64
+{
+public:
+    explicit XxHash64(uint64_t seed = 0);
+    void update(const void* data, size_t length);
+    uint64_t digest() const;
+
+private:
+    uint64_t m_seed;
+    uint64_t m_v[4];
+    uint64_t m_totalLength = 0;
+    unsigned char m_buffer[32];
+    size_t m_bufferLength = 0;
+};
+
+#endif // Hash_h
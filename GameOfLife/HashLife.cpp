@@ -0,0 +1,381 @@
+//
+//  HashLife.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "HashLife.h"
+#include <stdio.h>
+#include <algorithm>
+#include <stdexcept>
+
+// About the wrap-around:
+// HashLife works on an infinite plane. A torus of R*C cells behaves exactly like the infinite
+// plane that is tiled with copies of the torus. To advance the torus by 2^k generations, we build
+// a node of that tiled plane that is big enough: a node of 2^n*2^n cells advances its center
+// (2^(n-1)*2^(n-1) cells) by up to 2^(n-2) generations, so the center must be at least as big as
+// the torus. Then we cut the torus out of the center again.
+// The tiled plane is very regular, so building it is cheap: a node only depends on its level and
+// on the position of its top-left cell modulo R and C. These nodes are memoized in m_torusNodes.
+
+static const uint32_t INVALID_NODE = 0xFFFFFFFF;
+
+static inline int64_t positiveModulo(int64_t a, int64_t b) {
+    int64_t m = a % b;
+    return m < 0 ? m + b : m;
+}
+
+size_t HashLife::NodeKeyHash::operator()(const NodeKey& k) const {
+    uint64_t h = ((uint64_t)k.nw << 32 | k.ne) * 0x9E3779B97F4A7C15ULL;
+    h ^= ((uint64_t)k.sw << 32 | k.se) * 0xC2B2AE3D27D4EB4FULL;
+    h ^= h >> 29;
+    return (size_t)h;
+}
+
+HashLife::HashLife(const BitBoard& board, Topology topology, size_t maxNodes) {
+    m_topology = topology;
+    m_maxNodes = maxNodes;
+    m_rowCount = board.getRowCount();
+    m_colCount = board.getColCount();
+    m_rule = board.getRule();
+    if (m_rule.isBorn(0)) {
+        // advance() knows that an empty node stays empty, that's not true with B0.
+        throw std::runtime_error("HashLife: rules with B0 (like " + m_rule.toString() + ") are not supported");
+    }
+    reset();
+    if (m_topology == TOPOLOGY_TORUS) {
+        m_board = board;
+    } else {
+        int level = 3;
+        while (((int64_t)1 << level) < std::max(m_rowCount, m_colCount)) {
+            level++;
+        }
+        m_root = buildPlane(board, level, 0, 0);
+    }
+}
+
+void HashLife::reset() {
+    m_nodes.clear();
+    m_nodeIds.clear();
+    m_emptyNodes.clear();
+    m_results.clear();
+    m_torusNodes.clear();
+    Node dead = { 0, 0, 0, 0, 0, 0 };
+    Node alive = { 0, 0, 0, 0, 0, 1 };
+    m_nodes.push_back(dead);
+    m_nodes.push_back(alive);
+}
+
+HashLife::NodeId HashLife::join(NodeId nw, NodeId ne, NodeId sw, NodeId se) {
+    NodeKey key = { nw, ne, sw, se };
+    auto it = m_nodeIds.find(key);
+    if (it != m_nodeIds.end()) {
+        return it->second;
+    }
+    Node node;
+    node.nw = nw;
+    node.ne = ne;
+    node.sw = sw;
+    node.se = se;
+    node.level = m_nodes[nw].level + 1;
+    node.population = addPopulation(addPopulation(m_nodes[nw].population, m_nodes[ne].population),
+                                    addPopulation(m_nodes[sw].population, m_nodes[se].population));
+    NodeId id = (NodeId)m_nodes.size();
+    if (id == INVALID_NODE) {
+        throw std::runtime_error("HashLife: too many nodes");
+    }
+    m_nodes.push_back(node);
+    m_nodeIds.insert(std::make_pair(key, id));
+    return id;
+}
+
+HashLife::NodeId HashLife::emptyNode(int level) {
+    while ((int)m_emptyNodes.size() <= level) {
+        if (m_emptyNodes.empty()) {
+            m_emptyNodes.push_back(0);
+        } else {
+            NodeId e = m_emptyNodes.back();
+            m_emptyNodes.push_back(join(e, e, e, e));
+        }
+    }
+    return m_emptyNodes[level];
+}
+
+HashLife::NodeId HashLife::centre(NodeId node) {
+    // Copies, not references: join() may reallocate m_nodes.
+    Node n = m_nodes[node];
+    return join(m_nodes[n.nw].se, m_nodes[n.ne].sw, m_nodes[n.sw].ne, m_nodes[n.se].nw);
+}
+
+HashLife::NodeId HashLife::advanceLevel2(NodeId node) {
+    // 4*4 cells => the inner 2*2 cells, one generation later
+    Node n = m_nodes[node];
+    const NodeId quadrants[4] = { n.nw, n.ne, n.sw, n.se };
+    int cells[4][4];
+    for (int q = 0; q < 4; q++) {
+        const Node& quadrant = m_nodes[quadrants[q]];
+        int row = (q / 2) * 2;
+        int col = (q % 2) * 2;
+        cells[row][col] = (int)quadrant.nw;
+        cells[row][col + 1] = (int)quadrant.ne;
+        cells[row + 1][col] = (int)quadrant.sw;
+        cells[row + 1][col + 1] = (int)quadrant.se;
+    }
+    NodeId next[4];
+    for (int i = 0; i < 4; i++) {
+        int row = 1 + i / 2;
+        int col = 1 + i % 2;
+        int neighbours = 0;
+        for (int dRow = -1; dRow <= 1; dRow++) {
+            for (int dCol = -1; dCol <= 1; dCol++) {
+                if (dRow != 0 || dCol != 0) {
+                    neighbours += cells[row + dRow][col + dCol];
+                }
+            }
+        }
+        bool alive = cells[row][col] ? m_rule.survives(neighbours) : m_rule.isBorn(neighbours);
+        next[i] = alive ? 1 : 0;
+    }
+    return join(next[0], next[1], next[2], next[3]);
+}
+
+HashLife::NodeId HashLife::advance(NodeId node, int j) {
+    Node n = m_nodes[node];
+    if (n.population == 0) {
+        return emptyNode(n.level - 1);
+    }
+    if (n.level == 2) {
+        return advanceLevel2(node);
+    }
+    uint64_t key = (uint64_t)node << 6 | (uint64_t)j;
+    auto it = m_results.find(key);
+    if (it != m_results.end()) {
+        return it->second;
+    }
+
+    Node nw = m_nodes[n.nw];
+    Node ne = m_nodes[n.ne];
+    Node sw = m_nodes[n.sw];
+    Node se = m_nodes[n.se];
+
+    // Nine overlapping sub-nodes of half the size:
+    //   n00 n01 n02
+    //   n10 n11 n12
+    //   n20 n21 n22
+    NodeId sub[9];
+    sub[0] = n.nw;
+    sub[1] = join(nw.ne, ne.nw, nw.se, ne.sw);
+    sub[2] = n.ne;
+    sub[3] = join(nw.sw, nw.se, sw.nw, sw.ne);
+    sub[4] = join(nw.se, ne.sw, sw.ne, se.nw);
+    sub[5] = join(ne.sw, ne.se, se.nw, se.ne);
+    sub[6] = n.sw;
+    sub[7] = join(sw.ne, se.nw, sw.se, se.sw);
+    sub[8] = n.se;
+
+    // If j is as big as possible, both halves advance in time: 2^(j-1) + 2^(j-1) generations.
+    // Otherwise, the first half just takes the centers and the second half advances 2^j generations.
+    bool fullStep = (j == n.level - 2);
+    NodeId r[9];
+    for (int i = 0; i < 9; i++) {
+        r[i] = fullStep ? advance(sub[i], j - 1) : centre(sub[i]);
+    }
+    int j2 = fullStep ? j - 1 : j;
+    NodeId c00 = join(r[0], r[1], r[3], r[4]);
+    NodeId c01 = join(r[1], r[2], r[4], r[5]);
+    NodeId c10 = join(r[3], r[4], r[6], r[7]);
+    NodeId c11 = join(r[4], r[5], r[7], r[8]);
+    NodeId a00 = advance(c00, j2);
+    NodeId a01 = advance(c01, j2);
+    NodeId a10 = advance(c10, j2);
+    NodeId a11 = advance(c11, j2);
+    NodeId result = join(a00, a01, a10, a11);
+    m_results.insert(std::make_pair(key, result));
+    return result;
+}
+
+HashLife::NodeId HashLife::buildTorus(const BitBoard& board, int level, int64_t row, int64_t col) {
+    if (level == 0) {
+        return board.getCell((int)row, (int)col) ? 1 : 0;
+    }
+    // Small nodes are cheaper to build again than to look up.
+    const bool memoize = level >= 3;
+    uint64_t key = (((uint64_t)row * (uint64_t)m_colCount + (uint64_t)col) << 6) | (uint64_t)level;
+    if (memoize) {
+        auto it = m_torusNodes.find(key);
+        if (it != m_torusNodes.end()) {
+            return it->second;
+        }
+    }
+    int64_t half = (int64_t)1 << (level - 1);
+    int64_t row2 = (row + half % m_rowCount) % m_rowCount;
+    int64_t col2 = (col + half % m_colCount) % m_colCount;
+    NodeId nw = buildTorus(board, level - 1, row, col);
+    NodeId ne = buildTorus(board, level - 1, row, col2);
+    NodeId sw = buildTorus(board, level - 1, row2, col);
+    NodeId se = buildTorus(board, level - 1, row2, col2);
+    NodeId id = join(nw, ne, sw, se);
+    if (memoize) {
+        m_torusNodes.insert(std::make_pair(key, id));
+    }
+    return id;
+}
+
+HashLife::NodeId HashLife::buildPlane(const BitBoard& board, int level, int64_t row, int64_t col) {
+    int64_t size = (int64_t)1 << level;
+    if (row >= m_rowCount || col >= m_colCount || row + size <= 0 || col + size <= 0) {
+        return emptyNode(level);
+    }
+    if (level == 0) {
+        return board.getCell((int)row, (int)col) ? 1 : 0;
+    }
+    int64_t half = size / 2;
+    NodeId nw = buildPlane(board, level - 1, row, col);
+    NodeId ne = buildPlane(board, level - 1, row, col + half);
+    NodeId sw = buildPlane(board, level - 1, row + half, col);
+    NodeId se = buildPlane(board, level - 1, row + half, col + half);
+    return join(nw, ne, sw, se);
+}
+
+void HashLife::extract(NodeId node, int64_t row, int64_t col, BitBoard& board) const {
+    const Node& n = m_nodes[node];
+    int64_t size = (int64_t)1 << n.level;
+    if (n.population == 0 || row >= m_rowCount || col >= m_colCount || row + size <= 0 || col + size <= 0) {
+        return;
+    }
+    if (n.level == 0) {
+        board.setCell((int)row, (int)col, true);
+        return;
+    }
+    int64_t half = size / 2;
+    extract(n.nw, row, col, board);
+    extract(n.ne, row, col + half, board);
+    extract(n.sw, row + half, col, board);
+    extract(n.se, row + half, col + half, board);
+}
+
+void HashLife::run(int64_t numberOfGenerations) {
+    if (numberOfGenerations <= 0 || m_rowCount == 0 || m_colCount == 0) {
+        return;
+    }
+    if (numberOfGenerations >= ((int64_t)1 << 60)) {
+        throw std::runtime_error("HashLife: can't run more than 2^60 generations");
+    }
+    for (int k = 0; k < 60; k++) {
+        if ((numberOfGenerations >> k) & 1) {
+            if (m_topology == TOPOLOGY_TORUS) {
+                runTorusStep(k);
+            } else {
+                runPlaneStep(k);
+            }
+            m_generation += (int64_t)1 << k;
+            collectGarbageIfNeeded();
+        }
+    }
+    if (m_verbose) {
+        printf("HashLife: generation %lld, %zu nodes, %zu memoized results, %d garbage collections\n",
+            (long long)m_generation, m_nodes.size(), m_results.size(), m_gcCount);
+    }
+}
+
+void HashLife::runTorusStep(int k) {
+    int level = 2;
+    while (((int64_t)1 << (level - 1)) < std::max(m_rowCount, m_colCount)) {
+        level++;
+    }
+    level = std::max(level, k + 2);
+    int64_t quarter = (int64_t)1 << (level - 2);
+
+    m_torusNodes.clear();
+    NodeId root = buildTorus(m_board, level, positiveModulo(-quarter, m_rowCount), positiveModulo(-quarter, m_colCount));
+    m_torusNodes.clear();
+
+    NodeId result = advance(root, k);
+    m_board = BitBoard(m_rowCount, m_colCount);
+    m_board.setRule(m_rule);
+    extract(result, 0, 0, m_board);
+}
+
+HashLife::NodeId HashLife::expand(NodeId node) {
+    Node n = m_nodes[node];
+    NodeId e = emptyNode(n.level - 1);
+    NodeId nw = join(e, e, e, n.nw);
+    NodeId ne = join(e, e, n.ne, e);
+    NodeId sw = join(e, n.sw, e, e);
+    NodeId se = join(n.se, e, e, e);
+    return join(nw, ne, sw, se);
+}
+
+void HashLife::runPlaneStep(int k) {
+    // The pattern can grow by 2^k cells in every direction, and only the center of the root
+    // survives advance(). So the root must be big enough, and the pattern must be in the
+    // inner quarter of the root (the center of the center).
+    for (;;) {
+        const Node& n = m_nodes[m_root];
+        if (n.level >= k + 2 && n.level >= 3) {
+            uint64_t innerPopulation = addPopulation(
+                addPopulation(m_nodes[m_nodes[m_nodes[n.nw].se].se].population, m_nodes[m_nodes[m_nodes[n.ne].sw].sw].population),
+                addPopulation(m_nodes[m_nodes[m_nodes[n.sw].ne].ne].population, m_nodes[m_nodes[m_nodes[n.se].nw].nw].population));
+            // A saturated population doesn't say if there are cells outside of the inner quarter.
+            if (innerPopulation == n.population && n.population != POPULATION_SATURATED) {
+                break;
+            }
+        }
+        int64_t quarter = (int64_t)1 << (n.level - 1);
+        m_root = expand(m_root);
+        m_originRow -= quarter;
+        m_originCol -= quarter;
+    }
+    int level = m_nodes[m_root].level;
+    m_root = advance(m_root, k);
+    m_originRow += (int64_t)1 << (level - 2);
+    m_originCol += (int64_t)1 << (level - 2);
+}
+
+void HashLife::copyTo(BitBoard& board) const {
+    if (m_topology == TOPOLOGY_TORUS) {
+        board = m_board;
+        return;
+    }
+    board = BitBoard(m_rowCount, m_colCount);
+    board.setRule(m_rule);
+    extract(m_root, m_originRow, m_originCol, board);
+}
+
+HashLife::NodeId HashLife::copyNode(const std::vector<Node>& oldNodes, NodeId node, std::vector<NodeId>& remap) {
+    if (node < 2) {
+        return node;
+    }
+    if (remap[node] != INVALID_NODE) {
+        return remap[node];
+    }
+    const Node& n = oldNodes[node];
+    NodeId nw = copyNode(oldNodes, n.nw, remap);
+    NodeId ne = copyNode(oldNodes, n.ne, remap);
+    NodeId sw = copyNode(oldNodes, n.sw, remap);
+    NodeId se = copyNode(oldNodes, n.se, remap);
+    NodeId id = join(nw, ne, sw, se);
+    remap[node] = id;
+    return id;
+}
+
+void HashLife::collectGarbageIfNeeded() {
+    if (m_nodes.size() <= m_maxNodes) {
+        return;
+    }
+    size_t before = m_nodes.size();
+    std::vector<Node> oldNodes;
+    oldNodes.swap(m_nodes);
+    reset();
+    // Only the plane needs its nodes between steps. The torus is kept in m_board.
+    if (m_topology == TOPOLOGY_PLANE) {
+        std::vector<NodeId> remap(oldNodes.size(), INVALID_NODE);
+        m_root = copyNode(oldNodes, m_root, remap);
+    }
+    m_gcCount++;
+    if (m_verbose) {
+        printf("HashLife: garbage collection: %zu nodes => %zu nodes\n", before, m_nodes.size());
+    }
+}
@@ -0,0 +1,131 @@
+//
+//  HashLife.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef HashLife_h
+#define HashLife_h
+
+#include "gol-config.h"
+#include "BitBoard.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+
+/// Bill Gosper's HashLife algorithm. The board is stored as a quadtree where equal
+/// subtrees are shared ("canonicalized"), and the future of every subtree is memoized.
+/// This makes it possible to calculate 2^k generations at once, for very large k, as
+/// long as the pattern is regular enough.
+/// @see https://en.wikipedia.org/wiki/Hashlife
+class HashLife
+{
+public:
+    enum Topology {
+        /// Wrap-around board, exactly like `Board` and `BitBoard`.
+        TOPOLOGY_TORUS,
+        /// Infinite plane. The board is placed at the origin, and everything that
+        /// moves out of the board is lost when converting back with copyTo().
+        TOPOLOGY_PLANE
+    };
+
+    /// Uses the rule of `board`.
+    /// @param maxNodes The node cache is garbage-collected when it grows beyond this size.
+    /// @throws std::runtime_error if the rule has B0 (a dead cell with no neighbours is born).
+    HashLife(const BitBoard& board, Topology topology, size_t maxNodes = DEFAULT_MAX_NODES);
+
+    void run(int64_t numberOfGenerations);
+
+    /// Copies the cells in the rectangle of the original board into `board`.
+    void copyTo(BitBoard& board) const;
+
+    inline int64_t getGeneration() const { return m_generation; }
+    inline size_t getNodeCount() const { return m_nodes.size(); }
+    inline int getGarbageCollectionCount() const { return m_gcCount; }
+
+    bool isVerbose() const { return m_verbose; };
+    void setVerbose(bool v) { m_verbose = v; };
+
+    static const size_t DEFAULT_MAX_NODES = 8 * 1024 * 1024;
+
+private:
+    typedef uint32_t NodeId;
+
+    /// A square of 2^level * 2^level cells. Level 0 nodes are single cells
+    /// (NodeId 0 is the dead cell, NodeId 1 is the alive cell).
+    struct Node {
+        NodeId nw, ne, sw, se;
+        int level;
+        /// The number of alive cells, but at most POPULATION_SATURATED. (A torus that is tiled into a node
+        /// of a high level has more alive cells than fit into 64 bits.) Only compared to 0 and to each other.
+        uint64_t population;
+    };
+    static const uint64_t POPULATION_SATURATED = UINT64_MAX;
+    /// a + b, but at most POPULATION_SATURATED.
+    static inline uint64_t addPopulation(uint64_t a, uint64_t b) {
+        return a > POPULATION_SATURATED - b ? POPULATION_SATURATED : a + b;
+    }
+
+    struct NodeKey {
+        NodeId nw, ne, sw, se;
+        bool operator==(const NodeKey& other) const {
+            return nw == other.nw && ne == other.ne && sw == other.sw && se == other.se;
+        }
+    };
+    struct NodeKeyHash {
+        size_t operator()(const NodeKey& k) const;
+    };
+
+    void reset();
+    /// Returns the canonical node with these four children.
+    NodeId join(NodeId nw, NodeId ne, NodeId sw, NodeId se);
+    NodeId emptyNode(int level);
+    /// The center of a node, one level smaller.
+    NodeId centre(NodeId node);
+    /// Advances a node of level L by 2^j generations (0 <= j <= L-2).
+    /// Returns the center of the node (level L-1).
+    NodeId advance(NodeId node, int j);
+    NodeId advanceLevel2(NodeId node);
+
+    /// Builds a node of 2^level cells whose top-left cell is (row, col) of the torus.
+    NodeId buildTorus(const BitBoard& board, int level, int64_t row, int64_t col);
+    /// Builds a node of 2^level cells whose top-left cell is (row, col) of the plane.
+    NodeId buildPlane(const BitBoard& board, int level, int64_t row, int64_t col);
+    void extract(NodeId node, int64_t row, int64_t col, BitBoard& board) const;
+
+    void runTorusStep(int k);
+    void runPlaneStep(int k);
+    NodeId expand(NodeId node);
+    void collectGarbageIfNeeded();
+    /// Copies a node from an old node store (before garbage collection) into this one.
+    NodeId copyNode(const std::vector<Node>& oldNodes, NodeId node, std::vector<NodeId>& remap);
+
+    Topology m_topology;
+    size_t m_maxNodes;
+    bool m_verbose = false;
+    int m_rowCount;
+    int m_colCount;
+    Rule m_rule;
+    int64_t m_generation = 0;
+    int m_gcCount = 0;
+
+    std::vector<Node> m_nodes;
+    std::unordered_map<NodeKey, NodeId, NodeKeyHash> m_nodeIds;
+    std::vector<NodeId> m_emptyNodes;
+    /// Memoized results of advance(), key is (node << 6 | j)
+    std::unordered_map<uint64_t, NodeId> m_results;
+    /// Memoized nodes of buildTorus(), see there.
+    std::unordered_map<uint64_t, NodeId> m_torusNodes;
+
+    // TOPOLOGY_TORUS: the board, between steps.
+    BitBoard m_board;
+    // TOPOLOGY_PLANE: the universe. Its top-left cell is at (m_originRow, m_originCol).
+    NodeId m_root = 0;
+    int64_t m_originRow = 0;
+    int64_t m_originCol = 0;
+};
+
+#endif // HashLife_h
@@ -0,0 +1,177 @@
+//
+//  MappedFile.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "MappedFile.h"
+#include <stdexcept>
+#if GOL_WIN_ONLY
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if GOL_WIN_ONLY
+
+MappedFile::MappedFile(const std::string& path, Access access) : m_access(access) {
+    const bool writable = (access == READ_WRITE);
+    HANDLE file = CreateFileA(path.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+        FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("CreateFile failed for file at " + path);
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw std::runtime_error("GetFileSizeEx failed for file at " + path);
+    }
+    m_file = file;
+    m_size = (size_t)size.QuadPart;
+    if (m_size == 0) {
+        // Empty files can't be mapped.
+        return;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        CloseHandle(file);
+        throw std::runtime_error("CreateFileMapping failed for file at " + path);
+    }
+    m_mapping = mapping;
+    m_data = (char*)MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    if (m_data == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("MapViewOfFile failed for file at " + path);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping != nullptr) {
+        CloseHandle((HANDLE)m_mapping);
+    }
+    if (m_file != nullptr) {
+        CloseHandle((HANDLE)m_file);
+    }
+}
+
+void MappedFile::create(const std::string& path, size_t size) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("CreateFile failed for file at " + path);
+    }
+    LARGE_INTEGER distance;
+    distance.QuadPart = (LONGLONG)size;
+    bool ok = SetFilePointerEx(file, distance, NULL, FILE_BEGIN) && SetEndOfFile(file);
+    CloseHandle(file);
+    if (!ok) {
+        throw std::runtime_error("SetEndOfFile failed for file at " + path);
+    }
+}
+
+void MappedFile::release(size_t offset, size_t length) {
+    if (m_data == nullptr || length == 0) {
+        return;
+    }
+    // Unlocking pages that aren't locked removes them from the working set.
+    VirtualUnlock(m_data + offset, length);
+}
+
+void MappedFile::flush(size_t offset, size_t length) {
+    if (m_data == nullptr || length == 0 || m_access != READ_WRITE) {
+        return;
+    }
+    FlushViewOfFile(m_data + offset, length);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path, Access access) : m_access(access) {
+    const bool writable = (access == READ_WRITE);
+    int fd = open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("open failed for file at " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("fstat failed for file at " + path);
+    }
+    m_size = (size_t)st.st_size;
+    if (m_size == 0) {
+        // Empty files can't be mapped.
+        close(fd);
+        return;
+    }
+    void* data = mmap(nullptr, m_size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+        writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after closing the file.
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("mmap failed for file at " + path);
+    }
+    madvise(data, m_size, MADV_SEQUENTIAL);
+    m_data = (char*)data;
+}
+
+MappedFile::~MappedFile() {
+    if (m_data != nullptr) {
+        munmap(m_data, m_size);
+    }
+}
+
+void MappedFile::create(const std::string& path, size_t size) {
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("open failed for file at " + path);
+    }
+    bool ok = ftruncate(fd, (off_t)size) == 0;
+    close(fd);
+    if (!ok) {
+        throw std::runtime_error("ftruncate failed for file at " + path);
+    }
+}
+
+/// Shrinks [offset, offset+length) to whole pages.
+static bool getPageRange(size_t& offset, size_t& length) {
+    static const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t begin = (offset + pageSize - 1) / pageSize * pageSize;
+    size_t end = (offset + length) / pageSize * pageSize;
+    if (end <= begin) {
+        return false;
+    }
+    offset = begin;
+    length = end - begin;
+    return true;
+}
+
+void MappedFile::release(size_t offset, size_t length) {
+    if (m_data == nullptr || !getPageRange(offset, length)) {
+        return;
+    }
+    if (m_access == READ_WRITE) {
+        // Changed pages stay in the page cache of the file and are written back later.
+        msync(m_data + offset, length, MS_ASYNC);
+    }
+    madvise(m_data + offset, length, MADV_DONTNEED);
+}
+
+void MappedFile::flush(size_t offset, size_t length) {
+    if (m_data == nullptr || m_access != READ_WRITE || length == 0) {
+        return;
+    }
+    // msync() needs a page-aligned address, so round down.
+    static const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t begin = offset / pageSize * pageSize;
+    msync(m_data + begin, offset + length - begin, MS_ASYNC);
+}
+
+#endif
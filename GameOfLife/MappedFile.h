@@ -0,0 +1,60 @@
+//
+//  MappedFile.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef MappedFile_h
+#define MappedFile_h
+
+#include "gol-config.h"
+#include <stddef.h>
+#include <string>
+
+/// A memory mapping of a whole file (mmap on POSIX, MapViewOfFile on Windows).
+/// The file is unmapped when the object is destroyed.
+class MappedFile
+{
+public:
+    enum Access {
+        READ_ONLY,
+        /// Changes are written back to the file.
+        READ_WRITE
+    };
+
+    /// @throws std::runtime_error if the file can't be opened or mapped.
+    explicit MappedFile(const std::string& path, Access access = READ_ONLY);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// Creates a file of `size` bytes (filled with zeros), or truncates an existing file to that size.
+    /// @throws std::runtime_error if the file can't be created.
+    static void create(const std::string& path, size_t size);
+
+    inline const char* getData() const { return m_data; }
+    /// Only for READ_WRITE mappings.
+    inline char* getWritableData() { return m_data; }
+    inline size_t getSize() const { return m_size; }
+
+    /// Tells the OS that the bytes [offset, offset+length) are not needed in memory for now.
+    /// They are read again from the file when they are accessed the next time, changes are not lost.
+    /// (Only whole pages inside of the range are released.)
+    void release(size_t offset, size_t length);
+    /// Starts writing the changes in [offset, offset+length) to the file, without waiting.
+    void flush(size_t offset, size_t length);
+
+private:
+    char* m_data = nullptr;
+    size_t m_size = 0;
+    Access m_access;
+#if GOL_WIN_ONLY
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
+
+#endif // MappedFile_h
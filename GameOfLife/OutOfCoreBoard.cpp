@@ -0,0 +1,139 @@
+//
+//  OutOfCoreBoard.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "OutOfCoreBoard.h"
+#include "BitBoard.h"
+#include "Hash.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+OutOfCoreBoard::OutOfCoreBoard(const std::string& inputPath, const std::string& outputPath,
+                               int numberOfThreads, size_t bandBytes) {
+    m_outputPath = outputPath;
+    m_scratchPaths[0] = outputPath + ".tmp0";
+    m_scratchPaths[1] = outputPath + ".tmp1";
+    m_input.reset(new MappedFile(inputPath));
+    m_info = BoardIO::getBinaryFileInfo(*m_input, inputPath);
+    m_numberOfThreads = std::max(1, numberOfThreads);
+    size_t rowBytes = (size_t)m_info.wordsPerRow * sizeof(uint64_t);
+    m_bandRows = (int)std::max((size_t)1, std::min((size_t)m_info.rowCount, bandBytes / rowBytes));
+}
+
+OutOfCoreBoard::~OutOfCoreBoard() {
+    if (!m_finished) {
+        for (int i = 0; i < 2; i++) {
+            if (m_scratch[i]) {
+                m_scratch[i].reset();
+                remove(m_scratchPaths[i].c_str());
+            }
+        }
+    }
+}
+
+MappedFile& OutOfCoreBoard::getScratchFile(int i) {
+    if (!m_scratch[i]) {
+        BoardIO::createBinary(m_scratchPaths[i], m_info.rowCount, m_info.colCount);
+        m_scratch[i].reset(new MappedFile(m_scratchPaths[i], MappedFile::READ_WRITE));
+    }
+    return *m_scratch[i];
+}
+
+MappedFile& OutOfCoreBoard::getCurrentFile() {
+    return m_current < 0 ? *m_input : *m_scratch[m_current];
+}
+
+void OutOfCoreBoard::run(int numberOfGenerations) {
+    const int rowCount = m_info.rowCount;
+    const int colCount = m_info.colCount;
+    const size_t wordsPerRow = m_info.wordsPerRow;
+
+    for (int gIdx = 0; gIdx < numberOfGenerations; gIdx++) {
+        int next = (m_current == 0) ? 1 : 0;
+        MappedFile& srcFile = getCurrentFile();
+        MappedFile& dstFile = getScratchFile(next);
+        const uint64_t* src = (const uint64_t*)(srcFile.getData() + m_info.dataOffset);
+        uint64_t* dst = (uint64_t*)(dstFile.getWritableData() + m_info.dataOffset);
+
+        for (int bandBegin = 0; bandBegin < rowCount; bandBegin += m_bandRows) {
+            int bandEnd = std::min(bandBegin + m_bandRows, rowCount);
+            auto worker = [&](int i) {
+                int rowBegin = bandBegin + (int)((long long)(bandEnd - bandBegin) * i / m_numberOfThreads);
+                int rowEnd = bandBegin + (int)((long long)(bandEnd - bandBegin) * (i + 1) / m_numberOfThreads);
+                for (int row = rowBegin; row < rowEnd; row++) {
+                    int rowAbove = (row == 0) ? rowCount - 1 : row - 1;
+                    int rowBelow = (row == rowCount - 1) ? 0 : row + 1;
+                    BitBoard::nextGenerationRow(src + rowAbove * wordsPerRow, src + row * wordsPerRow,
+                                                src + rowBelow * wordsPerRow, dst + row * wordsPerRow, colCount, m_rule);
+                }
+            };
+            std::vector<std::thread> threads;
+            for (int i = 1; i < m_numberOfThreads; i++) {
+                threads.push_back(std::thread(worker, i));
+            }
+            worker(0);
+            for (auto& t : threads) {
+                t.join();
+            }
+
+            // The band is done. The rows of the old generation are needed again for the next band
+            // (only the last one), and for the wrap-around (row 0 and the last row).
+            dstFile.release(getRowOffset(bandBegin), getRowOffset(bandEnd) - getRowOffset(bandBegin));
+            int releaseBegin = std::max(bandBegin - 1, 1);
+            int releaseEnd = bandEnd - 1;
+            if (releaseEnd > releaseBegin) {
+                srcFile.release(getRowOffset(releaseBegin), getRowOffset(releaseEnd) - getRowOffset(releaseBegin));
+            }
+        }
+        m_current = next;
+        if (m_verbose) {
+            printf("OutOfCore: generation %d done (%d bands of %d rows)\n",
+                gIdx + 1, (rowCount + m_bandRows - 1) / m_bandRows, m_bandRows);
+        }
+    }
+}
+
+uint64_t OutOfCoreBoard::finish() {
+    if (m_current < 0) {
+        // No generations: the result is the input.
+        MappedFile& dstFile = getScratchFile(0);
+        memcpy(dstFile.getWritableData() + m_info.dataOffset, m_input->getData() + m_info.dataOffset,
+               getRowOffset(m_info.rowCount) - m_info.dataOffset);
+        m_current = 0;
+    }
+    m_input.reset();
+
+    // The checksum of the file and the hash of the board, in one pass.
+    MappedFile& file = *m_scratch[m_current];
+    XxHash64 checksum;
+    XxHash64 hash;
+    int32_t size[2] = { m_info.rowCount, m_info.colCount };
+    hash.update(size, sizeof(size));
+    for (int bandBegin = 0; bandBegin < m_info.rowCount; bandBegin += m_bandRows) {
+        int bandEnd = std::min(bandBegin + m_bandRows, m_info.rowCount);
+        size_t offset = getRowOffset(bandBegin);
+        size_t length = getRowOffset(bandEnd) - offset;
+        checksum.update(file.getData() + offset, length);
+        hash.update(file.getData() + offset, length);
+        file.release(offset, length);
+    }
+    BoardIO::setBinaryChecksum(file, checksum.digest());
+
+    m_scratch[0].reset();
+    m_scratch[1].reset();
+    remove(m_outputPath.c_str());
+    if (rename(m_scratchPaths[m_current].c_str(), m_outputPath.c_str()) != 0) {
+        throw std::runtime_error("rename failed for file at " + m_outputPath);
+    }
+    remove(m_scratchPaths[1 - m_current].c_str());
+    m_finished = true;
+    return hash.digest();
+}
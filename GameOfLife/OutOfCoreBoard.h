@@ -0,0 +1,82 @@
+//
+//  OutOfCoreBoard.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef OutOfCoreBoard_h
+#define OutOfCoreBoard_h
+
+#include "gol-config.h"
+#include "BoardIO.h"
+#include "MappedFile.h"
+#include "Rule.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+/// Runs a board that doesn't fit into memory. The board is a file in the binary format
+/// (see BoardIO.h), and it is calculated like a `BitBoard`, but the rows stay in
+/// memory-mapped files: one file for the current generation, one for the next.
+/// A generation is calculated in bands of rows. After every band, the OS is told that
+/// the band isn't needed in memory any more. So the memory that is needed is about two
+/// bands, no matter how big the board is.
+class OutOfCoreBoard
+{
+public:
+    /// @param inputPath A board in the binary format. It is not modified.
+    /// @param outputPath Where the result is saved by finish(), in the binary format.
+    ///                   While running, the scratch files outputPath + ".tmp0" and ".tmp1" are used.
+    /// @param bandBytes The size of a band of rows.
+    /// @throws std::runtime_error if the input file can't be read or is malformed.
+    OutOfCoreBoard(const std::string& inputPath, const std::string& outputPath,
+                   int numberOfThreads, size_t bandBytes = DEFAULT_BAND_BYTES);
+    /// Removes the scratch files, if finish() wasn't called.
+    ~OutOfCoreBoard();
+
+    OutOfCoreBoard(const OutOfCoreBoard&) = delete;
+    OutOfCoreBoard& operator=(const OutOfCoreBoard&) = delete;
+
+    inline int getRowCount() const { return m_info.rowCount; }
+    inline int getColCount() const { return m_info.colCount; }
+
+    void run(int numberOfGenerations);
+
+    /// Writes the checksum and moves the result to the output path.
+    /// @return The hash of the result, the same as BitBoard::getHash() would return.
+    uint64_t finish();
+
+    inline const Rule& getRule() const { return m_rule; }
+    inline void setRule(const Rule& rule) { m_rule = rule; }
+
+    bool isVerbose() const { return m_verbose; };
+    void setVerbose(bool v) { m_verbose = v; };
+
+    static const size_t DEFAULT_BAND_BYTES = 64 * 1024 * 1024;
+
+private:
+    /// The scratch file for the next generation, created if needed.
+    MappedFile& getScratchFile(int i);
+    MappedFile& getCurrentFile();
+    inline size_t getRowOffset(int row) const {
+        return m_info.dataOffset + (size_t)row * m_info.wordsPerRow * sizeof(uint64_t);
+    }
+
+    std::string m_outputPath;
+    std::string m_scratchPaths[2];
+    std::unique_ptr<MappedFile> m_input;
+    std::unique_ptr<MappedFile> m_scratch[2];
+    /// -1: the current generation is in m_input, otherwise in m_scratch[m_current]
+    int m_current = -1;
+    BoardIO::BinaryFileInfo m_info;
+    int m_numberOfThreads;
+    int m_bandRows;
+    Rule m_rule;
+    bool m_finished = false;
+    bool m_verbose = false;
+};
+
+#endif // OutOfCoreBoard_h
@@ -0,0 +1,357 @@
+//
+//  ProcessRunner.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "ProcessRunner.h"
+
+#if USE_PROCESSES
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// About the blocks:
+// Every process keeps its block of r x c cells in a BitBoard of (r+2) x (c+2) cells: the block is at (1, 1),
+// and the rows 0 and r+1 and the columns 0 and c+1 are the halo. A generation of that BitBoard wraps around
+// in the wrong place, but only the halo gets wrong, and it is replaced before the next generation:
+//
+//   1. The columns: the first column of the block goes to the left neighbour, the last one to the right
+//      neighbour (packed into words, one bit per row). They become the right and left halo columns there.
+//   2. The rows: the first and the last row, with the halo columns that just arrived, go to the neighbours
+//      above and below. Because the halo columns are included, the corners arrive too.
+//
+// The neighbours of the blocks at the border of the grid are on the other side (the board is a torus).
+// If the grid is only 1 or 2 blocks wide, a process is its own neighbour, or both neighbours are the same
+// process; that works because the messages arrive in order, and the receives are in the matching order.
+
+// About the commands:
+// After the blocks are sent, the other processes wait for a command from rank 0: a number of generations
+// to calculate (all processes calculate them together), COMMAND_GATHER (send the block to rank 0), or
+// COMMAND_STOP.
+
+static const int64_t COMMAND_STOP = 0;
+static const int64_t COMMAND_GATHER = -1;
+
+/// The first row (or column) of block `i` of `count` blocks along a side of `size` rows (or columns).
+static inline int getBlockBegin(int size, int count, int i) {
+    return (int)((int64_t)size * i / count);
+}
+
+/// The processes that talk to each other: every block with its neighbours on the right and below (the corners
+/// of the halo come with the rows, so the diagonal neighbours aren't needed), and rank 0 with everybody.
+static std::vector<Transport::Link> getLinks(int gridRows, int gridCols) {
+    std::vector<Transport::Link> links;
+    for (int rank = 0; rank < gridRows * gridCols; rank++) {
+        const int gridRow = rank / gridCols;
+        const int gridCol = rank % gridCols;
+        links.push_back({rank, gridRow * gridCols + (gridCol + 1) % gridCols});
+        links.push_back({rank, ((gridRow + 1) % gridRows) * gridCols + gridCol});
+        links.push_back({0, rank});
+    }
+    return links;
+}
+
+static inline size_t getWordsPerRow(int colCount) {
+    return ((size_t)colCount + 63) / 64;
+}
+
+ProcessRunner::ProcessRunner(int numberOfProcesses, Transport::Type transportType)
+    : m_numberOfProcesses(numberOfProcesses), m_transportType(transportType) {
+}
+
+ProcessRunner::~ProcessRunner() {
+    if (isStarted()) {
+        try {
+            stop();
+        }
+        catch (const std::exception&) {
+            // Only stop() reports the errors.
+        }
+    }
+}
+
+ProcessRunner::Block ProcessRunner::getBlock(int rank) const {
+    const int i = rank / m_gridCols;
+    const int j = rank % m_gridCols;
+    Block block;
+    block.row = getBlockBegin(m_rowCount, m_gridRows, i);
+    block.col = getBlockBegin(m_colCount, m_gridCols, j);
+    block.rowCount = getBlockBegin(m_rowCount, m_gridRows, i + 1) - block.row;
+    block.colCount = getBlockBegin(m_colCount, m_gridCols, j + 1) - block.col;
+    return block;
+}
+
+void ProcessRunner::chooseGrid(int rowCount, int colCount, int numberOfProcesses, int& gridRows, int& gridCols) {
+    gridRows = 1;
+    gridCols = 1;
+    for (int n = std::max(1, numberOfProcesses); n > 1; n--) {
+        bool found = false;
+        int64_t bestCost = 0;
+        for (int p = 1; p <= n; p++) {
+            const int q = n / p;
+            if (n % p != 0 || p > rowCount || q > colCount) {
+                continue;
+            }
+            // Every border between two rows of blocks is a whole row of the board, and so on.
+            const int64_t cost = (int64_t)p * colCount + (int64_t)q * rowCount;
+            if (!found || cost < bestCost) {
+                found = true;
+                bestCost = cost;
+                gridRows = p;
+                gridCols = q;
+            }
+        }
+        if (found) {
+            return;
+        }
+    }
+}
+
+void ProcessRunner::run(BitBoard& board, int numberOfGenerations) {
+    if (numberOfGenerations <= 0 || board.getRowCount() == 0 || board.getColCount() == 0) {
+        return;
+    }
+    start(board);
+    run(numberOfGenerations);
+    gather(board);
+    stop();
+}
+
+void ProcessRunner::start(const BitBoard& board) {
+    if (isStarted()) {
+        throw std::runtime_error("The processes are already running");
+    }
+    m_rowCount = board.getRowCount();
+    m_colCount = board.getColCount();
+    chooseGrid(m_rowCount, m_colCount, m_numberOfProcesses, m_gridRows, m_gridCols);
+    const int processCount = m_gridRows * m_gridCols;
+    if (m_verbose) {
+        printf("Processes: %d (blocks of %d x %d), transport: %s\n", processCount,
+               (m_colCount + m_gridCols - 1) / m_gridCols, (m_rowCount + m_gridRows - 1) / m_gridRows,
+               Transport::getTypeName(m_transportType));
+    }
+    m_transport = Transport::create(m_transportType, processCount, getLinks(m_gridRows, m_gridCols));
+    m_children.clear();
+    m_childRunning.clear();
+    m_failure.clear();
+
+    // The children get a copy of the buffers of stdio, so they must be empty (or the output appears twice).
+    fflush(stdout);
+    fflush(stderr);
+    const pid_t parent = getpid();
+    for (int rank = 1; rank < processCount; rank++) {
+        const pid_t pid = fork();
+        if (pid < 0) {
+            const int error = errno;
+            killChildren();
+            throw std::runtime_error(std::string("fork failed: ") + strerror(error));
+        }
+        if (pid == 0) {
+            // The child never returns: no destructors and no atexit() handlers of the parent's objects.
+            int status = 0;
+            try {
+                m_transport->attach(rank);
+                m_transport->setAbortCheck([parent]() {
+                    if (getppid() != parent) {
+                        throw std::runtime_error("The first process is gone");
+                    }
+                });
+                const Block block = getBlock(rank);
+                m_local = BitBoard(block.rowCount + 2, block.colCount + 2);
+                m_local.setRule(board.getRule());
+                runChild();
+            }
+            catch (const std::exception& e) {
+                fprintf(stderr, "Error: Process %d: %s\n", rank, e.what());
+                status = 1;
+            }
+            _exit(status);
+        }
+        m_children.push_back(pid);
+        m_childRunning.push_back(true);
+    }
+
+    // A process that died can't send anything any more, so rank 0 looks for dead processes while it waits.
+    m_transport->attach(0);
+    m_transport->setAbortCheck([this]() { checkChildren(false); });
+    try {
+        // The blocks are sent one at a time, so rank 0 only needs the memory of one block more.
+        for (int i = 1; i < processCount; i++) {
+            const Block other = getBlock(i);
+            std::vector<uint64_t> words(other.rowCount * getWordsPerRow(other.colCount));
+            board.getRegion(other.row, other.col, other.rowCount, other.colCount, words.data(), getWordsPerRow(other.colCount));
+            m_transport->exchange({{i, words.data(), words.size() * sizeof(uint64_t)}}, {});
+        }
+        const Block block = getBlock(0);
+        std::vector<uint64_t> words(block.rowCount * getWordsPerRow(block.colCount));
+        board.getRegion(block.row, block.col, block.rowCount, block.colCount, words.data(), getWordsPerRow(block.colCount));
+        m_local = BitBoard(block.rowCount + 2, block.colCount + 2);
+        m_local.setRule(board.getRule());
+        m_local.setRegion(1, 1, block.rowCount, block.colCount, words.data(), getWordsPerRow(block.colCount));
+    }
+    catch (...) {
+        killChildren();
+        throw;
+    }
+}
+
+void ProcessRunner::run(int numberOfGenerations) {
+    if (numberOfGenerations <= 0) {
+        return;
+    }
+    try {
+        sendCommand(numberOfGenerations);
+        runGenerations(numberOfGenerations);
+    }
+    catch (...) {
+        killChildren();
+        throw;
+    }
+}
+
+void ProcessRunner::gather(BitBoard& board) {
+    if (board.getRowCount() != m_rowCount || board.getColCount() != m_colCount) {
+        throw std::runtime_error("ProcessRunner::gather(): the board has the wrong size");
+    }
+    try {
+        sendCommand(COMMAND_GATHER);
+        // One block at a time again.
+        for (int i = 0; i < m_gridRows * m_gridCols; i++) {
+            const Block block = getBlock(i);
+            std::vector<uint64_t> words(block.rowCount * getWordsPerRow(block.colCount));
+            if (i == 0) {
+                m_local.getRegion(1, 1, block.rowCount, block.colCount, words.data(), getWordsPerRow(block.colCount));
+            } else {
+                m_transport->exchange({}, {{i, words.data(), words.size() * sizeof(uint64_t)}});
+            }
+            board.setRegion(block.row, block.col, block.rowCount, block.colCount, words.data(), getWordsPerRow(block.colCount));
+        }
+    }
+    catch (...) {
+        killChildren();
+        throw;
+    }
+}
+
+void ProcessRunner::stop() {
+    if (!isStarted()) {
+        return;
+    }
+    try {
+        sendCommand(COMMAND_STOP);
+        checkChildren(true);
+    }
+    catch (...) {
+        killChildren();
+        throw;
+    }
+    m_transport.reset();
+}
+
+void ProcessRunner::sendCommand(int64_t command) {
+    if (!isStarted()) {
+        throw std::runtime_error("The processes aren't running");
+    }
+    std::vector<Transport::Message> sends;
+    for (int i = 1; i < m_gridRows * m_gridCols; i++) {
+        sends.push_back({i, &command, sizeof(command)});
+    }
+    m_transport->exchange(sends, {});
+}
+
+void ProcessRunner::checkChildren(bool wait) {
+    for (size_t i = 0; i < m_children.size(); i++) {
+        int status = 0;
+        if (m_childRunning[i] && waitpid(m_children[i], &status, wait ? 0 : WNOHANG) == m_children[i]) {
+            m_childRunning[i] = false;
+            if ((!WIFEXITED(status) || WEXITSTATUS(status) != 0) && m_failure.empty()) {
+                m_failure = "Process " + std::to_string(i + 1) + (WIFSIGNALED(status) ? " was killed by signal " + std::to_string(WTERMSIG(status))
+                                                                                      : " failed");
+            }
+        }
+    }
+    if (!m_failure.empty()) {
+        throw std::runtime_error(m_failure);
+    }
+}
+
+void ProcessRunner::killChildren() {
+    for (size_t i = 0; i < m_children.size(); i++) {
+        if (m_childRunning[i]) {
+            kill(m_children[i], SIGKILL);
+            waitpid(m_children[i], nullptr, 0);
+            m_childRunning[i] = false;
+        }
+    }
+    m_transport.reset();
+}
+
+void ProcessRunner::runChild() {
+    const Block block = getBlock(m_transport->getRank());
+    std::vector<uint64_t> words(block.rowCount * getWordsPerRow(block.colCount));
+    m_transport->exchange({}, {{0, words.data(), words.size() * sizeof(uint64_t)}});
+    m_local.setRegion(1, 1, block.rowCount, block.colCount, words.data(), getWordsPerRow(block.colCount));
+    for (;;) {
+        int64_t command = COMMAND_STOP;
+        m_transport->exchange({}, {{0, &command, sizeof(command)}});
+        if (command == COMMAND_STOP) {
+            return;
+        }
+        if (command == COMMAND_GATHER) {
+            m_local.getRegion(1, 1, block.rowCount, block.colCount, words.data(), getWordsPerRow(block.colCount));
+            m_transport->exchange({{0, words.data(), words.size() * sizeof(uint64_t)}}, {});
+        } else {
+            runGenerations((int)command);
+        }
+    }
+}
+
+void ProcessRunner::runGenerations(int numberOfGenerations) {
+    Transport& transport = *m_transport;
+    const int rank = transport.getRank();
+    const int r = m_local.getRowCount() - 2;
+    const int c = m_local.getColCount() - 2;
+    const int gridRow = rank / m_gridCols;
+    const int gridCol = rank % m_gridCols;
+    const int up = ((gridRow + m_gridRows - 1) % m_gridRows) * m_gridCols + gridCol;
+    const int down = ((gridRow + 1) % m_gridRows) * m_gridCols + gridCol;
+    const int left = gridRow * m_gridCols + (gridCol + m_gridCols - 1) % m_gridCols;
+    const int right = gridRow * m_gridCols + (gridCol + 1) % m_gridCols;
+
+    // The columns, one bit per row
+    const size_t columnBytes = ((size_t)r + 63) / 64 * sizeof(uint64_t);
+    std::vector<uint64_t> firstColumn(columnBytes / sizeof(uint64_t)), lastColumn(firstColumn.size());
+    std::vector<uint64_t> leftHalo(firstColumn.size()), rightHalo(firstColumn.size());
+    const size_t rowBytes = m_local.getWordsPerRow() * sizeof(uint64_t);
+
+    for (int g = 0; g < numberOfGenerations; g++) {
+        for (int i = 0; i < r; i++) {
+            const uint64_t bit = (uint64_t)1 << (i & 63);
+            firstColumn[i >> 6] = (firstColumn[i >> 6] & ~bit) | (m_local.getCell(i + 1, 1) ? bit : 0);
+            lastColumn[i >> 6] = (lastColumn[i >> 6] & ~bit) | (m_local.getCell(i + 1, c) ? bit : 0);
+        }
+        transport.exchange({{left, firstColumn.data(), columnBytes}, {right, lastColumn.data(), columnBytes}},
+                           {{right, rightHalo.data(), columnBytes}, {left, leftHalo.data(), columnBytes}});
+        for (int i = 0; i < r; i++) {
+            m_local.setCell(i + 1, 0, (leftHalo[i >> 6] >> (i & 63)) & 1);
+            m_local.setCell(i + 1, c + 1, (rightHalo[i >> 6] >> (i & 63)) & 1);
+        }
+        transport.exchange({{up, m_local.getRow(1), rowBytes}, {down, m_local.getRow(r), rowBytes}},
+                           {{down, m_local.getRow(r + 1), rowBytes}, {up, m_local.getRow(0), rowBytes}});
+        m_local.nextGeneration();
+    }
+}
+
+#endif // USE_PROCESSES
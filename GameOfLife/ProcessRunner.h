@@ -0,0 +1,112 @@
+//
+//  ProcessRunner.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef ProcessRunner_h
+#define ProcessRunner_h
+
+#include "gol-config.h"
+
+#if USE_PROCESSES
+
+#include "BitBoard.h"
+#include "Transport.h"
+#include <sys/types.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Runs a board on several worker processes. The torus is cut into a grid of blocks, and every process
+/// calculates one block, with a border of one cell (the halo) that it gets from the processes of the
+/// neighbouring blocks after every generation. So a process only needs the memory of its block.
+///
+/// The calling process is the first worker (rank 0); the others are started with fork() by start(), and
+/// they keep their blocks until stop(), so a long run can be gathered every few generations (for --stats
+/// and checkpoints) without starting the processes again. Everything goes through the Transport: rank 0
+/// sends the blocks and the commands to the other processes, the halos are exchanged, and rank 0 gathers
+/// the blocks into the board. Only the size and the rule of the board come from the fork(); the cells could
+/// come from there too, but then a transport to another machine would need a different protocol.
+class ProcessRunner
+{
+public:
+    ProcessRunner(int numberOfProcesses, Transport::Type transportType);
+    /// Stops the processes, if they are still running.
+    ~ProcessRunner();
+
+    ProcessRunner(const ProcessRunner&) = delete;
+    ProcessRunner& operator=(const ProcessRunner&) = delete;
+
+    /// start(), run(), gather() and stop() at once.
+    /// @throws std::runtime_error if a process can't be started, or fails.
+    void run(BitBoard& board, int numberOfGenerations);
+
+    /// Starts the processes and sends them the blocks of `board`.
+    /// @throws std::runtime_error if a process can't be started, or fails.
+    void start(const BitBoard& board);
+    /// Calculates the generations on the running processes. The births and deaths aren't
+    /// counted (see BitBoard::getStats()).
+    /// @throws std::runtime_error if a process fails.
+    void run(int numberOfGenerations);
+    /// Copies the blocks of the running processes into `board`, which must have the size of the started board.
+    /// @throws std::runtime_error if a process fails.
+    void gather(BitBoard& board);
+    /// Ends the processes and waits for them.
+    /// @throws std::runtime_error if a process failed.
+    void stop();
+    inline bool isStarted() const { return m_transport != nullptr; }
+
+    /// Chooses the grid of blocks for a board: gridRows x gridCols blocks, at most `numberOfProcesses` of them,
+    /// and every block has at least one row and one column. Of all grids with the most blocks, the one with
+    /// the shortest halos is taken.
+    static void chooseGrid(int rowCount, int colCount, int numberOfProcesses, int& gridRows, int& gridCols);
+
+    bool isVerbose() const { return m_verbose; };
+    void setVerbose(bool v) { m_verbose = v; };
+
+private:
+    /// The rows [row, row+rowCount) and columns [col, col+colCount) of the board that one process calculates.
+    struct Block {
+        int row;
+        int col;
+        int rowCount;
+        int colCount;
+    };
+    /// Block `rank` of the grid; the blocks are numbered row by row.
+    Block getBlock(int rank) const;
+
+    /// What the other processes do after the fork(): they follow the commands of rank 0 until stop().
+    void runChild();
+    /// The generations of this process's block, with the halo exchange.
+    void runGenerations(int numberOfGenerations);
+    /// Sends `command` to all other processes (only in rank 0).
+    void sendCommand(int64_t command);
+    /// Looks for processes that died, and throws if one did (only in rank 0).
+    void checkChildren(bool wait);
+    /// Kills the other processes after an error, and forgets the transport.
+    void killChildren();
+
+    int m_numberOfProcesses;
+    Transport::Type m_transportType;
+    bool m_verbose = false;
+
+    // While the processes run:
+    std::unique_ptr<Transport> m_transport;
+    int m_gridRows = 0;
+    int m_gridCols = 0;
+    int m_rowCount = 0;
+    int m_colCount = 0;
+    /// The block of this process with its halo (see "About the blocks" in ProcessRunner.cpp).
+    BitBoard m_local;
+    /// Only in rank 0: the other processes, in the order of their ranks.
+    std::vector<pid_t> m_children;
+    std::vector<bool> m_childRunning;
+    std::string m_failure;
+};
+
+#endif // USE_PROCESSES
+
+#endif // ProcessRunner_h
@@ -0,0 +1,67 @@
+//
+//  Rule.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "Rule.h"
+#include <ctype.h>
+#include <stdexcept>
+
+/// Parses the digits of one half of a rule, like "36".
+static bool parseCounts(const std::string& digits, uint16_t& mask)
+{
+    mask = 0;
+    for (char c : digits) {
+        if (c < '0' || c > '8' || (mask & (1 << (c - '0')))) {
+            return false;
+        }
+        mask |= 1 << (c - '0');
+    }
+    return true;
+}
+
+Rule Rule::parse(const std::string& str)
+{
+    size_t slash = str.find('/');
+    if (slash != std::string::npos) {
+        std::string first = str.substr(0, slash);
+        std::string second = str.substr(slash + 1);
+        uint16_t birth = 0;
+        uint16_t survival = 0;
+        bool ok;
+        char firstLetter = first.empty() ? 0 : (char)toupper((unsigned char)first[0]);
+        char secondLetter = second.empty() ? 0 : (char)toupper((unsigned char)second[0]);
+        if (firstLetter == 'B' && secondLetter == 'S') {
+            ok = parseCounts(first.substr(1), birth) && parseCounts(second.substr(1), survival);
+        } else if (firstLetter == 'S' && secondLetter == 'B') {
+            ok = parseCounts(first.substr(1), survival) && parseCounts(second.substr(1), birth);
+        } else {
+            // The old notation: survival/birth, without letters
+            ok = parseCounts(first, survival) && parseCounts(second, birth);
+        }
+        if (ok) {
+            return Rule(birth, survival);
+        }
+    }
+    throw std::runtime_error("Invalid rule '" + str + "' (expected something like B3/S23)");
+}
+
+std::string Rule::toString() const
+{
+    std::string str = "B";
+    for (int n = 0; n <= 8; n++) {
+        if (isBorn(n)) {
+            str += (char)('0' + n);
+        }
+    }
+    str += "/S";
+    for (int n = 0; n <= 8; n++) {
+        if (survives(n)) {
+            str += (char)('0' + n);
+        }
+    }
+    return str;
+}
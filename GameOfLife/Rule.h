@@ -0,0 +1,127 @@
+//
+//  Rule.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef Rule_h
+#define Rule_h
+
+#include "gol-config.h"
+#include <stdint.h>
+#include <string>
+
+/// A "life-like" rule: whether a cell is alive in the next generation only depends on
+/// whether it is alive now and on the number of alive cells among its 8 neighbours.
+/// In B/S notation, "B3/S23" (Conway's Game of Life) means: a dead cell with 3 neighbours
+/// is born, a living cell with 2 or 3 neighbours survives, all other cells are dead.
+class GOL_API Rule
+{
+public:
+    /// Conway's Game of Life, B3/S23.
+    constexpr Rule() : m_birth(1 << 3), m_survival((1 << 2) | (1 << 3)) {}
+    /// Bit n of `birth`/`survival` is set if a cell with n neighbours is born/survives.
+    constexpr Rule(uint16_t birth, uint16_t survival) : m_birth(birth & 0x1FF), m_survival(survival & 0x1FF) {}
+
+    /// Parses a rule in B/S notation, like "B36/S23" (or "b36/s23", "S23/B36", or the old "23/36"
+    /// notation, which is survival/birth).
+    /// @throws std::runtime_error if it isn't a valid rule.
+    static Rule parse(const std::string& str);
+    /// The rule in B/S notation, like "B36/S23".
+    std::string toString() const;
+
+    constexpr bool isBorn(int neighbours) const { return (m_birth >> neighbours) & 1; }
+    constexpr bool survives(int neighbours) const { return (m_survival >> neighbours) & 1; }
+    constexpr uint16_t getBirthMask() const { return m_birth; }
+    constexpr uint16_t getSurvivalMask() const { return m_survival; }
+
+    friend constexpr bool operator==(const Rule& r1, const Rule& r2) {
+        return r1.m_birth == r2.m_birth && r1.m_survival == r2.m_survival;
+    }
+    friend constexpr bool operator!=(const Rule& r1, const Rule& r2) {
+        return !(r1 == r2);
+    }
+
+private:
+    uint16_t m_birth;
+    uint16_t m_survival;
+};
+
+// About the rules in the kernels:
+// The kernels are templates over the rule. They get a StaticRule for the common rules, so
+// the compiler knows the rule and throws away everything that isn't needed for it (like
+// the comparisons with neighbour counts that don't matter). For all other rules, they get
+// a `Rule`, which does the same with the bits of the rule at runtime. withStaticRule()
+// picks the right one, once per row or per generation, not once per cell.
+
+/// A rule that is known at compile time. Has the same methods as `Rule`.
+template <uint16_t Birth, uint16_t Survival>
+struct StaticRule
+{
+    static constexpr bool isBorn(int neighbours) { return (Birth >> neighbours) & 1; }
+    static constexpr bool survives(int neighbours) { return (Survival >> neighbours) & 1; }
+    static constexpr uint16_t getBirthMask() { return Birth; }
+    static constexpr uint16_t getSurvivalMask() { return Survival; }
+    static constexpr Rule toRule() { return Rule(Birth, Survival); }
+};
+
+/// B3/S23
+typedef StaticRule<(1 << 3), (1 << 2) | (1 << 3)> LifeRule;
+/// B36/S23
+typedef StaticRule<(1 << 3) | (1 << 6), (1 << 2) | (1 << 3)> HighLifeRule;
+/// B3678/S34678
+typedef StaticRule<(1 << 3) | (1 << 6) | (1 << 7) | (1 << 8), (1 << 3) | (1 << 4) | (1 << 6) | (1 << 7) | (1 << 8)> DayAndNightRule;
+/// B2/S
+typedef StaticRule<(1 << 2), 0> SeedsRule;
+
+/// Calls f(StaticRule) if `rule` is one of the common rules, and f(rule) otherwise.
+template <class F>
+inline auto withStaticRule(const Rule& rule, F&& f) -> decltype(f(rule))
+{
+    if (rule == LifeRule::toRule()) {
+        return f(LifeRule());
+    } else if (rule == HighLifeRule::toRule()) {
+        return f(HighLifeRule());
+    } else if (rule == DayAndNightRule::toRule()) {
+        return f(DayAndNightRule());
+    } else if (rule == SeedsRule::toRule()) {
+        return f(SeedsRule());
+    } else {
+        return f(rule);
+    }
+}
+
+/// Calls f(n) for every neighbour count n where a dead cell is born.
+/// (Written out, so that nothing is left of it for a StaticRule but the calls that are needed.)
+template <class R, class F>
+inline void forEachBirthCount(const R& rule, F&& f)
+{
+    if (rule.isBorn(0)) f(0);
+    if (rule.isBorn(1)) f(1);
+    if (rule.isBorn(2)) f(2);
+    if (rule.isBorn(3)) f(3);
+    if (rule.isBorn(4)) f(4);
+    if (rule.isBorn(5)) f(5);
+    if (rule.isBorn(6)) f(6);
+    if (rule.isBorn(7)) f(7);
+    if (rule.isBorn(8)) f(8);
+}
+
+/// Calls f(n) for every neighbour count n where a living cell survives.
+template <class R, class F>
+inline void forEachSurvivalCount(const R& rule, F&& f)
+{
+    if (rule.survives(0)) f(0);
+    if (rule.survives(1)) f(1);
+    if (rule.survives(2)) f(2);
+    if (rule.survives(3)) f(3);
+    if (rule.survives(4)) f(4);
+    if (rule.survives(5)) f(5);
+    if (rule.survives(6)) f(6);
+    if (rule.survives(7)) f(7);
+    if (rule.survives(8)) f(8);
+}
+
+#endif // Rule_h
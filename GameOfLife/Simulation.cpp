@@ -0,0 +1,271 @@
+//
+//  Simulation.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "Simulation.h"
+#include "BitBoard.h"
+#include "Board.h"
+#include "BoardIO.h"
+#include "HashLife.h"
+#include <limits.h>
+#include <string.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+struct Simulation::Impl {
+    BitBoard board;
+    int64_t generation = 0;
+    Engine engine = ENGINE_BITS;
+    int threadCount = Board::getDefaultThreadCount();
+    std::shared_future<void> pending;
+    /// The thread of the last stepAsync(). It is joined by the next stepAsync() and by the destructor.
+    std::thread worker;
+    /// `running` is true while the step() of stepAsync() runs (but not the completion).
+    std::mutex mutex;
+    std::condition_variable stepDone;
+    bool running = false;
+    /// One row of a rectangle, for importCells() and exportCells().
+    std::vector<uint64_t> rowBuffer;
+};
+
+Simulation::Simulation(int rowCount, int colCount) : m_impl(new Impl) {
+    if (rowCount <= 0 || colCount <= 0) {
+        throw std::runtime_error("Invalid board size " + std::to_string(colCount) + "x" + std::to_string(rowCount));
+    }
+    m_impl->board = BitBoard(rowCount, colCount);
+}
+
+Simulation::Simulation(const std::string& path) : m_impl(new Impl) {
+    if (BoardIO::isBinaryFile(path)) {
+        m_impl->board = BoardIO::loadBinary(path);
+    } else {
+        m_impl->board = BoardIO::loadTextBits(path);
+    }
+}
+
+Simulation::~Simulation() {
+    wait();
+    if (m_impl->worker.joinable()) {
+        m_impl->worker.join();
+    }
+}
+
+int Simulation::getRowCount() const { return m_impl->board.getRowCount(); }
+int Simulation::getColCount() const { return m_impl->board.getColCount(); }
+int64_t Simulation::getGeneration() const { return m_impl->generation; }
+uint64_t Simulation::getPopulation() const { return m_impl->board.getPopulation(); }
+uint64_t Simulation::getHash() const { return m_impl->board.getHash(); }
+
+const Rule& Simulation::getRule() const { return m_impl->board.getRule(); }
+void Simulation::setRule(const Rule& rule) { m_impl->board.setRule(rule); }
+Simulation::Engine Simulation::getEngine() const { return m_impl->engine; }
+void Simulation::setEngine(Engine engine) { m_impl->engine = engine; }
+int Simulation::getThreadCount() const { return m_impl->threadCount; }
+void Simulation::setThreadCount(int threadCount) { m_impl->threadCount = std::max(1, threadCount); }
+
+bool Simulation::getCell(int row, int col) const {
+    return m_impl->board.getCell(row, col);
+}
+
+void Simulation::setCell(int row, int col, bool isAlive) {
+    m_impl->board.setCell(row, col, isAlive);
+}
+
+void Simulation::clear() {
+    BitBoard& board = m_impl->board;
+    for (int row = 0; row < board.getRowCount(); row++) {
+        memset(board.getRow(row), 0, board.getWordsPerRow() * sizeof(uint64_t));
+    }
+    board.markChanged();
+}
+
+static void checkRegion(const BitBoard& board, int row, int col, int rowCount, int colCount) {
+    if (row < 0 || col < 0 || rowCount < 0 || colCount < 0
+        || row > board.getRowCount() - rowCount || col > board.getColCount() - colCount) {
+        throw std::runtime_error("The rectangle of " + std::to_string(colCount) + "x" + std::to_string(rowCount) + " cells at ("
+            + std::to_string(col) + "," + std::to_string(row) + ") isn't inside the board");
+    }
+}
+
+// About the byte <-> bit conversion:
+// 8 cells are converted at once, with a few multiplications instead of a loop over the bits.
+
+/// Packs 8 cells, one byte each (0 = dead), into the low 8 bits.
+static inline uint64_t packBytes(const uint8_t* cells) {
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    uint64_t x;
+    memcpy(&x, cells, 8);
+    // 1 in every byte that isn't 0
+    x = ((((x & low7) + low7) | x) >> 7) & 0x0101010101010101ULL;
+    // Moves bit 8*i to bit 56 + i
+    return (x * 0x0102040810204080ULL) >> 56;
+}
+
+/// The opposite of packBytes().
+static inline void unpackBytes(uint64_t bits, uint8_t* cells) {
+    // Byte i gets bit i of `bits`
+    uint64_t x = ((bits & 0xFF) * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+    x = (((x + 0x7F7F7F7F7F7F7F7FULL) | x) >> 7) & 0x0101010101010101ULL;
+    memcpy(cells, &x, 8);
+}
+
+void Simulation::importCells(int row, int col, int rowCount, int colCount, const uint8_t* cells, size_t stride) {
+    checkRegion(m_impl->board, row, col, rowCount, colCount);
+    std::vector<uint64_t>& words = m_impl->rowBuffer;
+    words.assign((colCount + 63) / 64, 0);
+    for (int r = 0; r < rowCount; r++) {
+        const uint8_t* in = cells + r * stride;
+        int c = 0;
+        for (; c + 8 <= colCount; c += 8) {
+            words[c >> 6] |= packBytes(in + c) << (c & 63);
+        }
+        for (; c < colCount; c++) {
+            words[c >> 6] |= (uint64_t)(in[c] != 0) << (c & 63);
+        }
+        m_impl->board.setRegion(row + r, col, 1, colCount, &words[0], words.size());
+        std::fill(words.begin(), words.end(), 0);
+    }
+}
+
+void Simulation::exportCells(int row, int col, int rowCount, int colCount, uint8_t* cells, size_t stride) const {
+    checkRegion(m_impl->board, row, col, rowCount, colCount);
+    std::vector<uint64_t>& words = m_impl->rowBuffer;
+    words.assign((colCount + 63) / 64, 0);
+    for (int r = 0; r < rowCount; r++) {
+        m_impl->board.getRegion(row + r, col, 1, colCount, &words[0], words.size());
+        uint8_t* out = cells + r * stride;
+        int c = 0;
+        for (; c + 8 <= colCount; c += 8) {
+            unpackBytes(words[c >> 6] >> (c & 63), out + c);
+        }
+        for (; c < colCount; c++) {
+            out[c] = (uint8_t)((words[c >> 6] >> (c & 63)) & 1);
+        }
+    }
+}
+
+void Simulation::importBits(int row, int col, int rowCount, int colCount, const uint64_t* words, size_t wordsPerRow) {
+    checkRegion(m_impl->board, row, col, rowCount, colCount);
+    m_impl->board.setRegion(row, col, rowCount, colCount, words, wordsPerRow);
+}
+
+void Simulation::exportBits(int row, int col, int rowCount, int colCount, uint64_t* words, size_t wordsPerRow) const {
+    checkRegion(m_impl->board, row, col, rowCount, colCount);
+    m_impl->board.getRegion(row, col, rowCount, colCount, words, wordsPerRow);
+}
+
+void Simulation::step(int64_t numberOfGenerations) {
+    if (numberOfGenerations <= 0) {
+        return;
+    }
+    BitBoard& board = m_impl->board;
+    if (m_impl->engine == ENGINE_HASHLIFE) {
+        HashLife life(board, HashLife::TOPOLOGY_TORUS);
+        life.run(numberOfGenerations);
+        life.copyTo(board);
+    } else {
+        // The other engines count the generations with an int.
+        for (int64_t done = 0; done < numberOfGenerations; ) {
+            int n = (int)std::min(numberOfGenerations - done, (int64_t)INT_MAX);
+            switch (m_impl->engine) {
+            case ENGINE_TIMEBLOCK:
+                board.runTimeBlocked(n, 8, m_impl->threadCount);
+                break;
+            case ENGINE_STEAL:
+                board.runWorkStealing(n, m_impl->threadCount);
+                break;
+            default:
+                board.run(n);
+                break;
+            }
+            done += n;
+        }
+    }
+    m_impl->generation += numberOfGenerations;
+}
+
+// About stepAsync():
+// The step is finished (isRunning() is false) before the completion is called, so the completion may
+// call wait(), step() or stepAsync() again. The future is only ready after the completion.
+// The completion runs on the worker thread, so a stepAsync() from there can't join that thread;
+// it detaches it instead, the thread doesn't touch the Simulation any more after the completion.
+
+std::shared_future<void> Simulation::stepAsync(int64_t numberOfGenerations, std::function<void(Simulation&, std::exception_ptr)> completion) {
+    std::thread previousWorker;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        if (m_impl->running) {
+            throw std::runtime_error("Simulation::stepAsync() is still running");
+        }
+        previousWorker = std::move(m_impl->worker);
+    }
+    if (previousWorker.joinable()) {
+        if (previousWorker.get_id() == std::this_thread::get_id()) {
+            previousWorker.detach();
+        } else {
+            previousWorker.join();
+        }
+    }
+
+    auto promise = std::make_shared<std::promise<void>>();
+    // The worker waits for the mutex before it is done, so m_impl->worker is set before the completion runs.
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    m_impl->running = true;
+    m_impl->pending = promise->get_future().share();
+    m_impl->worker = std::thread([this, numberOfGenerations, completion, promise]() {
+        std::exception_ptr error;
+        try {
+            step(numberOfGenerations);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_impl->mutex);
+            m_impl->running = false;
+        }
+        m_impl->stepDone.notify_all();
+        if (completion) {
+            try {
+                completion(*this, error);
+            }
+            catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value();
+        }
+    });
+    return m_impl->pending;
+}
+
+bool Simulation::isRunning() const {
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    return m_impl->running;
+}
+
+void Simulation::wait() {
+    std::unique_lock<std::mutex> lock(m_impl->mutex);
+    m_impl->stepDone.wait(lock, [this]() { return !m_impl->running; });
+}
+
+void Simulation::save(const std::string& path) const {
+    if (BoardIO::isBinaryPath(path)) {
+        BoardIO::saveBinary(m_impl->board, path);
+    } else {
+        BoardIO::saveText(m_impl->board, path);
+    }
+}
@@ -0,0 +1,112 @@
+//
+//  Simulation.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef Simulation_h
+#define Simulation_h
+
+#include "gol-config.h"
+#include "Rule.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+
+/// The API of the GameOfLife library: a board that is stepped, read and written by the program
+/// that embeds it. This (and Rule.h) is the only header that users of the library need.
+/// A Simulation may be used from any thread, but only from one thread at a time. While stepAsync()
+/// is running, only isRunning() and wait() may be called. The completion of stepAsync() runs
+/// after that, so it may use the Simulation like everybody else (but not destroy it).
+class GOL_API Simulation
+{
+public:
+    enum Engine {
+        /// Single-threaded, bit-packed. (Like --mode bits)
+        ENGINE_BITS,
+        /// Bit-packed and multi-threaded, with temporal blocking. (Like --mode timeblock)
+        ENGINE_TIMEBLOCK,
+        /// Bit-packed and multi-threaded, skips the parts of the board that can't change. (Like --mode steal)
+        ENGINE_STEAL,
+        /// HashLife on the torus, for huge generation counts of regular patterns. (Like --mode hashlife)
+        ENGINE_HASHLIFE
+    };
+
+    /// Creates a board with all cells dead.
+    Simulation(int rowCount, int colCount);
+    /// Loads a board in the text or in the binary format.
+    /// @throws std::runtime_error if the file can't be read or is malformed.
+    explicit Simulation(const std::string& path);
+    /// Waits until stepAsync() and its completion are done.
+    ~Simulation();
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    int getRowCount() const;
+    int getColCount() const;
+    /// The number of generations that were calculated since the board was created or loaded.
+    int64_t getGeneration() const;
+    /// The number of alive cells.
+    uint64_t getPopulation() const;
+    /// The same hash as --emit-hash.
+    uint64_t getHash() const;
+
+    /// (Default: B3/S23)
+    const Rule& getRule() const;
+    void setRule(const Rule& rule);
+    /// (Default: ENGINE_BITS)
+    Engine getEngine() const;
+    void setEngine(Engine engine);
+    /// For ENGINE_TIMEBLOCK and ENGINE_STEAL. (Default: the number of hardware threads)
+    int getThreadCount() const;
+    void setThreadCount(int threadCount);
+
+    bool getCell(int row, int col) const;
+    void setCell(int row, int col, bool isAlive);
+    /// Sets all cells to dead.
+    void clear();
+
+    /// Copies a rectangle of cells into the board, with its top-left cell at (row, col).
+    /// One byte per cell, 0 is dead and everything else is alive. Row r of the rectangle starts at `cells + r * stride`.
+    /// @throws std::runtime_error if the rectangle isn't inside the board.
+    void importCells(int row, int col, int rowCount, int colCount, const uint8_t* cells, size_t stride);
+    /// Copies a rectangle of cells out of the board. One byte per cell, 0 is dead and 1 is alive.
+    /// @throws std::runtime_error if the rectangle isn't inside the board.
+    void exportCells(int row, int col, int rowCount, int colCount, uint8_t* cells, size_t stride) const;
+    /// Like importCells(), but bit-packed: bit i of word w is the cell in column w*64 + i of the rectangle
+    /// (like in the binary file format). Row r of the rectangle starts at `words + r * wordsPerRow`.
+    void importBits(int row, int col, int rowCount, int colCount, const uint64_t* words, size_t wordsPerRow);
+    /// Like exportCells(), but bit-packed. Bits beyond the last column of the rectangle are 0.
+    void exportBits(int row, int col, int rowCount, int colCount, uint64_t* words, size_t wordsPerRow) const;
+
+    /// Calculates the next `numberOfGenerations` generations with the selected engine.
+    void step(int64_t numberOfGenerations = 1);
+    /// Like step(), but on another thread. When it is done, `completion` (if set) is called on that
+    /// thread, with the exception that step() threw (or nullptr). isRunning() is already false then.
+    /// @return A future that is ready after the completion. It has the exception of step() (or of the
+    ///         completion), if there was one.
+    /// @throws std::runtime_error if stepAsync() is still running.
+    std::shared_future<void> stepAsync(int64_t numberOfGenerations,
+                                       std::function<void(Simulation&, std::exception_ptr)> completion = nullptr);
+    /// True until the step() of stepAsync() is done, the completion may still be running.
+    bool isRunning() const;
+    /// Waits until the step() of stepAsync() is done (not for the completion; use the future for that).
+    void wait();
+
+    /// Saves the board in the binary format if the path ends with ".golb", in the text format otherwise.
+    /// @throws std::runtime_error if the file can't be written.
+    void save(const std::string& path) const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+#endif // Simulation_h
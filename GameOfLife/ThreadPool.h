@@ -0,0 +1,109 @@
+//
+//  ThreadPool.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+#include "gol-config.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Threads that are started once and then reused, so that a short run (e.g. between two lines
+/// of --stats) doesn't pay for starting and joining the threads every time.
+/// A copy of a ThreadPool doesn't share the threads, it starts its own when it needs them.
+class ThreadPool
+{
+public:
+    ThreadPool() {}
+    ThreadPool(const ThreadPool&) : ThreadPool() {}
+    ThreadPool& operator=(const ThreadPool&) { return *this; }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_start.notify_all();
+        for (std::thread& t : m_threads) {
+            t.join();
+        }
+    }
+
+    /// Calls task(i) for every i in [0, taskCount), all at the same time (so the tasks may wait for each
+    /// other, e.g. with a Barrier): task(0) on the calling thread, the others on the threads of the pool.
+    /// Returns when all tasks are done. The tasks must not throw.
+    void run(int taskCount, const std::function<void(int)>& task) {
+        if (taskCount <= 0) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while ((int)m_threads.size() < taskCount - 1) {
+            const int index = (int)m_threads.size() + 1;
+            const unsigned long round = m_round;
+            m_threads.push_back(std::thread([this, index, round]() { workerLoop(index, round); }));
+        }
+        m_task = &task;
+        m_taskCount = taskCount;
+        m_running = taskCount - 1;
+        m_round++;
+        lock.unlock();
+        m_start.notify_all();
+
+        task(0);
+
+        lock.lock();
+        m_done.wait(lock, [this] { return m_running == 0; });
+        m_task = nullptr;
+    }
+
+    /// The number of threads that were started (without the calling thread).
+    int getThreadCount() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return (int)m_threads.size();
+    }
+
+private:
+    /// The thread for task(index). `round` is the value of m_round before its first task.
+    void workerLoop(int index, unsigned long round) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_start.wait(lock, [this, round] { return m_stop || m_round != round; });
+            if (m_stop) {
+                return;
+            }
+            round = m_round;
+            if (index >= m_taskCount) {
+                continue;
+            }
+            const std::function<void(int)>* task = m_task;
+            lock.unlock();
+            (*task)(index);
+            lock.lock();
+            if (--m_running == 0) {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    std::vector<std::thread> m_threads;
+    const std::function<void(int)>* m_task = nullptr;
+    int m_taskCount = 0;
+    /// How many tasks of the current round are still running on the pool.
+    int m_running = 0;
+    /// Incremented for every run().
+    unsigned long m_round = 0;
+    bool m_stop = false;
+};
+
+#endif // ThreadPool_h
@@ -0,0 +1,433 @@
+//
+//  Transport.cpp
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#include "Transport.h"
+
+#if USE_PROCESSES
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <stdexcept>
+
+// About the exchange:
+// Every process sends its messages and receives the messages of its peers at the same time: it writes as much
+// as fits into the channel to a peer, reads what has arrived from the peers, and starts again until everything
+// is done. So the channels can be smaller than the messages, and it doesn't matter in which order the processes
+// come to the exchange. A process only waits (and calls the abort check) when nothing moved at all.
+
+namespace {
+
+/// The messages to or from one peer, and how much of them is done.
+class MessageQueue
+{
+public:
+    void add(const Transport::Message& message) {
+        if (message.size > 0) {
+            m_messages.push_back(message);
+        }
+    }
+    inline bool isDone() const { return m_index == m_messages.size(); }
+    /// The rest of the current message.
+    inline char* getData() const { return (char*)m_messages[m_index].data + m_offset; }
+    inline size_t getRemaining() const { return m_messages[m_index].size - m_offset; }
+    void advance(size_t n) {
+        m_offset += n;
+        if (m_offset == m_messages[m_index].size) {
+            m_index++;
+            m_offset = 0;
+        }
+    }
+
+private:
+    std::vector<Transport::Message> m_messages;
+    size_t m_index = 0;
+    size_t m_offset = 0;
+};
+
+/// Sorts the messages by peer.
+void sortByPeer(const std::vector<Transport::Message>& messages, std::vector<MessageQueue>& queues) {
+    for (const Transport::Message& message : messages) {
+        queues[message.peer].add(message);
+    }
+}
+
+// About the shared memory:
+// One anonymous shared mapping (created before fork(), so all processes have it at the same place) has two
+// channels for every link, channel 2*i from the first to the second process of link i and 2*i+1 back. A channel is a ring buffer with one writer and one
+// reader; `written` and `read` count the bytes that went through it, so it is empty if they are the same,
+// and full if they are CHANNEL_BYTES apart. Each counter is only changed by one side.
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The shared memory transport needs lock-free 64-bit atomics");
+
+class SharedMemoryTransport : public Transport
+{
+public:
+    static const size_t CHANNEL_BYTES = 64 * 1024;
+
+    SharedMemoryTransport(int processCount, const std::vector<Link>& links) : Transport(processCount, links) {
+        const size_t channelCount = 2 * links.size();
+        if (channelCount == 0) {
+            return;
+        }
+        m_size = channelCount * sizeof(Channel);
+        void* memory = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::runtime_error(std::string("Transport: mmap failed: ") + strerror(errno));
+        }
+        m_channels = (Channel*)memory;
+        for (size_t i = 0; i < channelCount; i++) {
+            new (&m_channels[i]) Channel();
+        }
+    }
+
+    ~SharedMemoryTransport() {
+        if (m_channels != nullptr) {
+            munmap(m_channels, m_size);
+        }
+    }
+
+    void attach(int rank) override {
+        setRank(rank);
+    }
+
+protected:
+    void exchangeWithPeers(const std::vector<Message>& sends, const std::vector<Message>& receives) override {
+        std::vector<MessageQueue> out(m_processCount), in(m_processCount);
+        sortByPeer(sends, out);
+        sortByPeer(receives, in);
+        int idleRounds = 0;
+        for (;;) {
+            bool isDone = true;
+            bool moved = false;
+            for (int peer : m_peers) {
+                MessageQueue& queue = out[peer];
+                if (queue.isDone()) {
+                    continue;
+                }
+                Channel& channel = getChannel(m_rank, peer);
+                const uint64_t written = channel.written.load(std::memory_order_relaxed);
+                const uint64_t read = channel.read.load(std::memory_order_acquire);
+                const size_t n = std::min(queue.getRemaining(), CHANNEL_BYTES - (size_t)(written - read));
+                if (n > 0) {
+                    copyToRing(channel, written, queue.getData(), n);
+                    channel.written.store(written + n, std::memory_order_release);
+                    queue.advance(n);
+                    moved = true;
+                }
+                isDone = isDone && queue.isDone();
+            }
+            for (int peer : m_peers) {
+                MessageQueue& queue = in[peer];
+                if (queue.isDone()) {
+                    continue;
+                }
+                Channel& channel = getChannel(peer, m_rank);
+                const uint64_t written = channel.written.load(std::memory_order_acquire);
+                const uint64_t read = channel.read.load(std::memory_order_relaxed);
+                const size_t n = std::min(queue.getRemaining(), (size_t)(written - read));
+                if (n > 0) {
+                    copyFromRing(channel, read, queue.getData(), n);
+                    channel.read.store(read + n, std::memory_order_release);
+                    queue.advance(n);
+                    moved = true;
+                }
+                isDone = isDone && queue.isDone();
+            }
+            if (isDone) {
+                return;
+            }
+            if (moved) {
+                idleRounds = 0;
+                continue;
+            }
+            // Spin for a while (the peer is usually almost there), then sleep a little.
+            idleRounds++;
+            if (idleRounds < 1000) {
+                sched_yield();
+            } else {
+                const struct timespec pause = {0, 50 * 1000};
+                nanosleep(&pause, nullptr);
+                if (idleRounds % 2000 == 0 && m_abortCheck) {
+                    m_abortCheck();
+                }
+            }
+        }
+    }
+
+private:
+    struct Channel {
+        // On different cache lines, because they are written by different processes.
+        alignas(64) std::atomic<uint64_t> written{0};
+        alignas(64) std::atomic<uint64_t> read{0};
+        alignas(64) char data[CHANNEL_BYTES];
+    };
+
+    /// One of them is this process.
+    inline Channel& getChannel(int from, int to) {
+        const int link = getLink(from == m_rank ? to : from);
+        return m_channels[2 * (size_t)link + (from == m_links[link].first ? 0 : 1)];
+    }
+
+    static void copyToRing(Channel& channel, uint64_t position, const char* src, size_t n) {
+        const size_t offset = (size_t)(position % CHANNEL_BYTES);
+        const size_t first = std::min(n, CHANNEL_BYTES - offset);
+        memcpy(channel.data + offset, src, first);
+        memcpy(channel.data, src + first, n - first);
+    }
+
+    static void copyFromRing(const Channel& channel, uint64_t position, char* dst, size_t n) {
+        const size_t offset = (size_t)(position % CHANNEL_BYTES);
+        const size_t first = std::min(n, CHANNEL_BYTES - offset);
+        memcpy(dst, channel.data + offset, first);
+        memcpy(dst + first, channel.data, n - first);
+    }
+
+    Channel* m_channels = nullptr;
+    size_t m_size = 0;
+};
+
+// About the sockets:
+// There is a socketpair() for every link; the first process of link i has the socket m_fds[2*i], the second
+// one m_fds[2*i+1]. After attach(), a process has closed all the sockets of the other processes, so it gets
+// an end-of-file when a peer dies. The sockets are non-blocking, and poll() waits until one of them can move data.
+// The first process has all sockets open until the others are started, that's two for every link.
+
+class SocketTransport : public Transport
+{
+public:
+    SocketTransport(int processCount, const std::vector<Link>& links) : Transport(processCount, links), m_fds(2 * links.size(), -1) {
+        for (size_t i = 0; i < links.size(); i++) {
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, &m_fds[2 * i]) != 0) {
+                const int error = errno;
+                closeAll();
+                if (error == EMFILE || error == ENFILE) {
+                    throw std::runtime_error("Transport: too many open files for " + std::to_string(processCount)
+                                             + " processes with sockets (use fewer processes, --transport shm, or raise ulimit -n)");
+                }
+                throw std::runtime_error(std::string("Transport: socketpair failed: ") + strerror(error));
+            }
+        }
+    }
+
+    ~SocketTransport() {
+        closeAll();
+    }
+
+    void attach(int rank) override {
+        setRank(rank);
+        for (size_t i = 0; i < m_fds.size(); i++) {
+            int& fd = m_fds[i];
+            if (fd < 0) {
+                continue;
+            }
+            const Link& link = m_links[i / 2];
+            if ((i % 2 == 0 ? link.first : link.second) != rank) {
+                close(fd);
+                fd = -1;
+                continue;
+            }
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+            const int on = 1;
+            setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        }
+    }
+
+protected:
+    void exchangeWithPeers(const std::vector<Message>& sends, const std::vector<Message>& receives) override {
+        std::vector<MessageQueue> out(m_processCount), in(m_processCount);
+        sortByPeer(sends, out);
+        sortByPeer(receives, in);
+        std::vector<struct pollfd> fds;
+        std::vector<int> peers;
+        for (;;) {
+            fds.clear();
+            peers.clear();
+            for (int peer : m_peers) {
+                short events = (out[peer].isDone() ? 0 : POLLOUT) | (in[peer].isDone() ? 0 : POLLIN);
+                if (events != 0) {
+                    struct pollfd fd = {getSocket(peer), events, 0};
+                    fds.push_back(fd);
+                    peers.push_back(peer);
+                }
+            }
+            if (fds.empty()) {
+                return;
+            }
+            const int ready = poll(fds.data(), fds.size(), 100);
+            if (ready < 0 && errno != EINTR) {
+                throw std::runtime_error(std::string("Transport: poll failed: ") + strerror(errno));
+            }
+            if (ready <= 0) {
+                if (m_abortCheck) {
+                    m_abortCheck();
+                }
+                continue;
+            }
+            for (size_t i = 0; i < fds.size(); i++) {
+                const int peer = peers[i];
+                if ((fds[i].revents & POLLOUT) != 0) {
+                    send(peer, out[peer]);
+                }
+                if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0 && !in[peer].isDone()) {
+                    receive(peer, in[peer]);
+                }
+            }
+        }
+    }
+
+private:
+    inline int getSocket(int peer) const {
+        const int link = getLink(peer);
+        return m_fds[2 * (size_t)link + (m_rank == m_links[link].first ? 0 : 1)];
+    }
+
+    void send(int peer, MessageQueue& queue) {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        const ssize_t n = ::send(getSocket(peer), queue.getData(), queue.getRemaining(), flags);
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            throw std::runtime_error("Transport: Can't send to process " + std::to_string(peer) + ": " + strerror(errno));
+        }
+        if (n > 0) {
+            queue.advance((size_t)n);
+        }
+    }
+
+    void receive(int peer, MessageQueue& queue) {
+        const ssize_t n = ::recv(getSocket(peer), queue.getData(), queue.getRemaining(), 0);
+        if (n == 0) {
+            throw std::runtime_error("Transport: Process " + std::to_string(peer) + " is gone");
+        }
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            throw std::runtime_error("Transport: Can't receive from process " + std::to_string(peer) + ": " + strerror(errno));
+        }
+        if (n > 0) {
+            queue.advance((size_t)n);
+        }
+    }
+
+    void closeAll() {
+        for (int& fd : m_fds) {
+            if (fd >= 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+    }
+
+    std::vector<int> m_fds;
+};
+
+} // namespace
+
+std::unique_ptr<Transport> Transport::create(Type type, int processCount, const std::vector<Link>& links) {
+    if (processCount < 1) {
+        throw std::runtime_error("Transport: invalid number of processes");
+    }
+    std::vector<Link> sortedLinks;
+    for (const Link& link : links) {
+        if (link.first < 0 || link.first >= processCount || link.second < 0 || link.second >= processCount) {
+            throw std::runtime_error("Transport: invalid link");
+        }
+        if (link.first != link.second) {
+            sortedLinks.push_back({std::min(link.first, link.second), std::max(link.first, link.second)});
+        }
+    }
+    std::sort(sortedLinks.begin(), sortedLinks.end(), [](const Link& l1, const Link& l2) {
+        return l1.first < l2.first || (l1.first == l2.first && l1.second < l2.second);
+    });
+    sortedLinks.erase(std::unique(sortedLinks.begin(), sortedLinks.end(), [](const Link& l1, const Link& l2) {
+        return l1.first == l2.first && l1.second == l2.second;
+    }), sortedLinks.end());
+    if (type == UNIX_SOCKETS) {
+        return std::unique_ptr<Transport>(new SocketTransport(processCount, sortedLinks));
+    }
+    return std::unique_ptr<Transport>(new SharedMemoryTransport(processCount, sortedLinks));
+}
+
+bool Transport::parseType(const std::string& name, Type& type) {
+    if (name == "shm") {
+        type = SHARED_MEMORY;
+    } else if (name == "socket") {
+        type = UNIX_SOCKETS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* Transport::getTypeName(Type type) {
+    return type == UNIX_SOCKETS ? "socket" : "shm";
+}
+
+void Transport::setRank(int rank) {
+    m_rank = rank;
+    m_peers.clear();
+    m_linkOfPeer.assign(m_processCount, -1);
+    for (size_t i = 0; i < m_links.size(); i++) {
+        const Link& link = m_links[i];
+        if (link.first == rank || link.second == rank) {
+            const int peer = link.first == rank ? link.second : link.first;
+            m_peers.push_back(peer);
+            m_linkOfPeer[peer] = (int)i;
+        }
+    }
+    std::sort(m_peers.begin(), m_peers.end());
+}
+
+void Transport::exchange(const std::vector<Message>& sends, const std::vector<Message>& receives) {
+    // The messages to this process are copied in order, the others go through the transport.
+    auto checkPeer = [this](const Message& message) {
+        if (message.peer < 0 || message.peer >= m_processCount || getLink(message.peer) < 0) {
+            throw std::runtime_error("Transport: no link to process " + std::to_string(message.peer));
+        }
+    };
+    std::vector<Message> peerSends, peerReceives;
+    std::vector<const Message*> selfSends;
+    for (const Message& message : sends) {
+        if (message.peer == m_rank) {
+            selfSends.push_back(&message);
+        } else {
+            checkPeer(message);
+            peerSends.push_back(message);
+        }
+    }
+    size_t selfIndex = 0;
+    for (const Message& message : receives) {
+        if (message.peer != m_rank) {
+            checkPeer(message);
+            peerReceives.push_back(message);
+            continue;
+        }
+        if (selfIndex == selfSends.size() || selfSends[selfIndex]->size != message.size) {
+            throw std::runtime_error("Transport: the messages to the process itself don't match");
+        }
+        memcpy(message.data, selfSends[selfIndex]->data, message.size);
+        selfIndex++;
+    }
+    if (!peerSends.empty() || !peerReceives.empty()) {
+        exchangeWithPeers(peerSends, peerReceives);
+    }
+}
+
+#endif // USE_PROCESSES
@@ -0,0 +1,100 @@
+//
+//  Transport.h
+//  GameOfLife
+//
+//  Created by Michael Peternell on 17.10.2026.
+//  Copyright © 2026 Michael Peternell. All rights reserved.
+//
+
+#ifndef Transport_h
+#define Transport_h
+
+#include "gol-config.h"
+
+#if USE_PROCESSES
+
+#include <stddef.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// How the worker processes of ProcessRunner send data to each other.
+/// A transport is created by the first process before the others are started, so that they all inherit it.
+/// Then every process calls attach() with its own number ("rank"), and only talks through exchange().
+/// Messages between two processes arrive in the order they were sent. Only the processes of a Link can talk
+/// to each other, so a transport for many processes doesn't need a channel for every pair of them.
+///
+/// A network transport would implement the same interface (e.g. with one TCP connection per link).
+class Transport
+{
+public:
+    enum Type {
+        /// Two ring buffers in shared memory for every link. The fastest one.
+        SHARED_MEMORY,
+        /// A Unix socket for every link.
+        UNIX_SOCKETS
+    };
+
+    /// Two processes that send messages to each other (in both directions).
+    struct Link {
+        int first;
+        int second;
+    };
+
+    /// Creates the transport for `processCount` processes (in the first process, before the others are started).
+    /// Links that are given twice, or from a process to itself, are ignored.
+    /// @throws std::runtime_error if the shared memory or the sockets can't be created.
+    static std::unique_ptr<Transport> create(Type type, int processCount, const std::vector<Link>& links);
+    /// "shm" or "socket"
+    /// @return false if there is no such transport.
+    static bool parseType(const std::string& name, Type& type);
+    static const char* getTypeName(Type type);
+
+    virtual ~Transport() {}
+
+    /// Called once in every process. Releases what only the other processes need.
+    virtual void attach(int rank) = 0;
+    inline int getRank() const { return m_rank; }
+    inline int getProcessCount() const { return m_processCount; }
+
+    /// `size` bytes to or from process `peer`. The receiver must know the size.
+    struct Message {
+        int peer;
+        void* data;
+        size_t size;
+    };
+    /// Sends all of `sends` and receives all of `receives`, all at the same time, so a process never waits
+    /// for a peer that waits for it too. The n-th message from a peer goes into the n-th of `receives` with
+    /// that peer. Messages to the process itself are copied.
+    /// @throws std::runtime_error if there is no link to a peer, a peer is gone, or the abort check throws.
+    void exchange(const std::vector<Message>& sends, const std::vector<Message>& receives);
+
+    /// Called every now and then while exchange() waits for a peer. It should throw if the peer will never
+    /// come (e.g. because its process died).
+    inline void setAbortCheck(const std::function<void()>& check) { m_abortCheck = check; }
+
+protected:
+    Transport(int processCount, const std::vector<Link>& links) : m_processCount(processCount), m_links(links) {}
+
+    /// For attach(): sets m_rank and finds the links of this process.
+    void setRank(int rank);
+    /// The index into m_links of the link to `peer`, or -1.
+    inline int getLink(int peer) const { return m_linkOfPeer[peer]; }
+
+    /// exchange() without the messages to the process itself. All peers have a link.
+    virtual void exchangeWithPeers(const std::vector<Message>& sends, const std::vector<Message>& receives) = 0;
+
+    int m_rank = -1;
+    int m_processCount;
+    /// All links, with first < second.
+    std::vector<Link> m_links;
+    /// The peers of this process, in ascending order.
+    std::vector<int> m_peers;
+    std::vector<int> m_linkOfPeer;
+    std::function<void()> m_abortCheck;
+};
+
+#endif // USE_PROCESSES
+
+#endif // Transport_h
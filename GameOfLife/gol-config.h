@@ -23,12 +23,49 @@
 #ifdef _WIN32
 #define GOL_WIN_ONLY 1
 #define GOL_MAC_ONLY 0
-#else
+#elif defined(__APPLE__)
 #define GOL_WIN_ONLY 0
 #define GOL_MAC_ONLY 1
+#else
+#define GOL_WIN_ONLY 0
+#define GOL_MAC_ONLY 0
 #endif
 
-#define USE_OPENMP GOL_WIN_ONLY
+// OpenMP is available whenever the compiler has it turned on (/openmp in Visual C++, -fopenmp in GCC).
+#ifdef _OPENMP
+#define USE_OPENMP 1
+#else
+#define USE_OPENMP 0
+#endif
+// OpenCL is always there on macOS. On Linux and Windows, compile with -DUSE_OPENCL=1 (/DUSE_OPENCL=1)
+// and link with the OpenCL ICD loader (-lOpenCL, OpenCL.lib).
+#ifndef USE_OPENCL
 #define USE_OPENCL GOL_MAC_ONLY
+#endif
+
+// The "procs" mode starts worker processes with fork() and talks to them over POSIX shared memory
+// or Unix sockets, so it isn't there on Windows.
+#define USE_PROCESSES (!GOL_WIN_ONLY)
+
+// SSE2/AVX2/AVX-512 kernels. The kernel is chosen at runtime, so one binary runs on all x86 CPUs.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define USE_X86_SIMD 1
+#else
+#define USE_X86_SIMD 0
+#endif
+
+// GOL_API marks the classes of the library API (see Simulation.h). In the shared library
+// (GOL_SHARED_LIBRARY), they are exported while building it (GOL_BUILDING_LIBRARY), and imported otherwise.
+#if defined(GOL_SHARED_LIBRARY) && defined(_WIN32)
+#if defined(GOL_BUILDING_LIBRARY)
+#define GOL_API __declspec(dllexport)
+#else
+#define GOL_API __declspec(dllimport)
+#endif
+#elif defined(GOL_SHARED_LIBRARY)
+#define GOL_API __attribute__((visibility("default")))
+#else
+#define GOL_API
+#endif
 
 #endif // GameOfLife_gol_config_h
@@ -1,163 +1,262 @@
+// For OpenCL purposes, a Game Of Life board is bit-packed: every row is an array of
+// 32-bit words ("wordsPerRow" words per row), and bit i of word w is the cell in column
+// w*32 + i. Bits beyond the last column are always 0. The cell with row = Y and column = X
+// is bit X%32 of the word with the index Y*wordsPerRow + X/32.
+// This is the same layout as BitBoard (wordsPerRow is always even, and a 64-bit word of
+// BitBoard is two 32-bit words on a little-endian device), so a BitBoard is copied as it is.
+// A Board (one byte per cell, see Board.h) is packed by gol_pack, and unpacked by gol_unpack.
 
-// For OpenCL purposes, a Game Of Life board is represented as a contiguous
-// array of booleans. (Each boolean represented by an unsigned char (8 bit))
-// Each row in the board is a contiguous memory area of size colCount. The cell
-// with row = Y and column = X has the index = Y*colCount + X.
-// Each boolean value is true if the cell is alive and false otherwise.
-
-// Each function on this file operates on "inputData" and "outputData".
-// The functions only read from "inputData" and never write to it.
-// The functions only write to "outputData" and never read to it.
+// Each kernel in this file operates on "inputData" and "outputData".
+// The kernels only read from "inputData" and never write to it.
+// The kernels only write to "outputData" and never read to it.
 // There can be no race condition during the calculation of a generation.
+// The host swaps the buffers after every launch. The kernels run on an in-order
+// queue, so a launch only starts when the one before is finished.
 
-// The input board is always represented with the arguments "inputData",
-// "rowCount" and "colCount". The output board (where results are saved to)
-// is represented by "outputData", "rowCount" and "colCount".
+// The rule is given by "birthMask" and "survivalMask": bit n is set if a dead cell
+// with n neighbours is born, or if a living cell with n neighbours survives.
+// (B3/S23, Conway's Game of Life, is birthMask = 0x008 and survivalMask = 0x00C.)
 
-// Each function in this file (except gol_rw_barrier) reads from the input board
-// and writes to the output board. For kernel methods, the index to use is always
-// derived from the global ID ( get_global_id(0) ). OpenCL-wise, a board is
-// only 1-dimensional.
+// About the tiles:
+// The board is cut into tiles of tileRows rows x tileWords words, and every work-group calculates
+// one tile. The work-group copies its tile into local memory, together with a border (the "halo")
+// of `generations` rows above and below, and one word on the left and on the right. Then it
+// calculates the generations in local memory: after the first generation, the outermost ring of
+// the halo is wrong (its neighbours outside weren't loaded), after the second generation the two
+// outermost rings, and so on. After `generations` generations, exactly the halo is wrong and the tile
+// itself is right. So the halo rows shrink by one row per generation. (The halo words are calculated
+// every time; they are wrong from the outside in, one bit per generation, so `generations` can be
+// at most 32.) At the end, the tile is written back to global memory.
+//
+// Global memory is read once and written once per launch, no matter how many generations
+// it calculates, and there is one launch for `generations` generations instead of one per generation.
+// The price is that the cells of the halo are calculated by two (or four) work-groups.
+//
+// The board is a torus: the halo of a tile at the border of the board comes from the other side.
+// The coordinates are wrapped when the tile is loaded, so the calculation itself doesn't know
+// about borders. (If the halo is larger than the board, the board just repeats.)
+// If the column count isn't a multiple of 32, the words of the tile aren't the words of the board
+// any more after the wrap-around; they are put together from the bits (see gol_load_word).
+// Tiles at the right and bottom border may stick out of the board; the cells outside are loaded
+// (wrapped, like a halo), but not written back.
+//
+// The work-group is 2-dimensional (get_local_size(0) words x get_local_size(1) rows), every
+// work-item calculates every get_local_size(0)-th word of every get_local_size(1)-th row.
+// Neighbouring work-items work on neighbouring words, so the accesses to global memory are
+// coalesced on GPUs.
 
-/// Calculates the alive state for the cell given by 'idx'.
-/// This function is comparatively slow and is only used for edge cases.
-void gol_do_slow(global uchar* inputData, global uchar* outputData, int rowCount, int colCount, size_t idx)
+/// @return the cell at column `col` (which must be inside the board) of a row.
+uint gol_get_cell(global const uint* row, int col)
 {
-    int row = idx / colCount;
-    int col = idx - (row * colCount);
-    
-    int rAbove, rBelow, cLeft, cRight;
-    if (row == 0) {
-        rAbove = (rowCount*colCount) - colCount;
-    }
-    else {
-        rAbove = -colCount;
-    }
-    if (row == (rowCount - 1)) {
-        rBelow = -(rowCount*colCount) + colCount;
-    }
-    else {
-        rBelow = +colCount;
-    }
-    if (col == 0) {
-        cLeft = colCount - 1;
+    return (row[col >> 5] >> (col & 31)) & 1;
+}
+
+/// @return the 32 cells of a row that start at column `col`. The column may be outside
+/// the board, it wraps around (and so do the cells).
+uint gol_load_word(global const uint* row, int colCount, int col)
+{
+    col %= colCount;
+    if(col < 0) {
+        col += colCount;
     }
-    else {
-        cLeft = -1;
+    int shift = col & 31;
+    if(col + 32 <= colCount) {
+        int index = col >> 5;
+        uint word = row[index] >> shift;
+        if(shift != 0) {
+            word |= row[index + 1] << (32 - shift);
+        }
+        return word;
     }
-    if (col == (colCount - 1)) {
-        cRight = -colCount + 1;
+    // The word goes across the right border (or the board is less than 32 cells wide).
+    uint word = 0;
+    for(int i = 0; i < 32; i++) {
+        word |= gol_get_cell(row, col) << i;
+        col++;
+        if(col == colCount) {
+            col = 0;
+        }
     }
-    else {
-        cRight = +1;
+    return word;
+}
+
+/// Calculates 32 cells at a time. The arguments are the cells (aC, bC, cC) of the row above, the row
+/// and the row below, and their west (*W) and east (*E) neighbours.
+/// The neighbours are added with bit-sliced full adders, like in BitBoard.cpp.
+uint gol_next_word(uint aW, uint aC, uint aE, uint bW, uint bC, uint bE, uint cW, uint cC, uint cE,
+                   int birthMask, int survivalMask)
+{
+    uint aX = aW ^ aE;
+    uint a0 = aX ^ aC;
+    uint a1 = (aW & aE) | (aX & aC);
+    uint b0 = bW ^ bE;
+    uint b1 = bW & bE;
+    uint cX = cW ^ cE;
+    uint c0 = cX ^ cC;
+    uint c1 = (cW & cE) | (cX & cC);
+
+    uint sX = a0 ^ b0;
+    uint s0 = sX ^ c0;
+    uint k = (a0 & b0) | (sX & c0);
+
+    if(birthMask == 0x008 && survivalMask == 0x00C) {
+        // Conway's Game of Life: the count is 2 or 3 exactly if one of a1, b1, c1, k is set.
+        uint x1 = a1 ^ b1;
+        uint y1 = a1 & b1;
+        uint x2 = c1 ^ k;
+        uint y2 = c1 & k;
+        uint exactlyOne = (x1 ^ x2) & ~(y1 | y2);
+        return exactlyOne & (s0 | bC);
     }
-    
-    uchar neighbours = inputData[idx+rAbove+cLeft] + inputData[idx+rAbove] + inputData[idx+rAbove+cRight]
-    + inputData[idx+cLeft] + inputData[idx+cRight]
-    + inputData[idx+rBelow+cLeft] + inputData[idx+rBelow] + inputData[idx+rBelow+cRight];
-    uchar wasAlive = inputData[idx];
-    if(wasAlive != 0) {
-        outputData[idx] = (neighbours == 2 || neighbours == 3) ? 1 : 0;
-    } else {
-        outputData[idx] = (neighbours == 3) ? 1 : 0;
+
+    // a1 + b1 + c1 + k = n1 + 2*(t1 + u1) = n1 + 2*n2 + 4*n3
+    uint tX = a1 ^ b1;
+    uint t0 = tX ^ c1;
+    uint t1 = (a1 & b1) | (tX & c1);
+    uint n1 = t0 ^ k;
+    uint u1 = t0 & k;
+    uint n2 = t1 ^ u1;
+    uint n3 = t1 & u1;
+
+    uint born = 0;
+    uint survives = 0;
+    for(int n = 0; n <= 8; n++) {
+        if(((birthMask | survivalMask) >> n) & 1) {
+            uint countIsN = ((n & 1) ? s0 : ~s0) & ((n & 2) ? n1 : ~n1) & ((n & 4) ? n2 : ~n2) & ((n & 8) ? n3 : ~n3);
+            if((birthMask >> n) & 1) {
+                born |= countIsN;
+            }
+            if((survivalMask >> n) & 1) {
+                survives |= countIsN;
+            }
+        }
     }
+    return (bC & survives) | (~bC & born);
 }
 
-/// Calculates the alive state of a group of cells.
-/// Most cell alive states are calculated with this function. It cannot calculate
-/// the alive states of cells at the borders of the board because it doesn't
-/// implement coordinate wraparound (for performance reasons.)
-/// @param groupSize Number of cells to compute with one function call.
-///        The cells are next to each other on the same row.
-kernel void gol_next_group(global uchar* inputData, global uchar* outputData, int rowCount, int colCount, int groupSize)
+/// Calculates `generations` generations of one tile.
+/// @param tileA Local memory for (tileRows + 2*generations) * (tileWords + 2) words.
+/// @param tileB The same size as tileA.
+kernel void gol_next_tile(global const uint* inputData, global uint* outputData, int rowCount, int colCount, int wordsPerRow,
+                          int tileRows, int tileWords, int generations, int birthMask, int survivalMask,
+                          local uint* tileA, local uint* tileB)
 {
-    size_t what = get_global_id(0);
-    
-    int groupsPerCol = (colCount-2)/groupSize;
-    int row = what / groupsPerCol + 1;
-    int col = (what - (row-1)*groupsPerCol) * groupSize + 1;
-    
-    // Variables a-i describe a 3*3 kernel of cell values.
-    
-    // a b c
-    // d e f
-    // g h i
-    
-    int aIdx = (row-1)*colCount + (col-1);
-    int bIdx = aIdx+1;
-    int cIdx = aIdx+2;
-    int dIdx = row*colCount + (col-1);
-    int eIdx = dIdx+1;
-    int fIdx = dIdx+2;
-    int gIdx = (row+1)*colCount + (col-1);
-    int hIdx = gIdx+1;
-    int iIdx = gIdx+2;
-    
-    uchar a = inputData[aIdx];
-    uchar b = inputData[bIdx];
-    uchar c = inputData[cIdx];
-    uchar d = inputData[dIdx];
-    uchar e = inputData[eIdx];
-    uchar f = inputData[fIdx];
-    uchar g = inputData[gIdx];
-    uchar h = inputData[hIdx];
-    uchar i = inputData[iIdx];
-    
-    int orange = 1;
-    for(;;) {
-        int neighbours = a+b+c+d+f+g+h+i;
-        outputData[eIdx] = neighbours == 3 || (neighbours == 2 && e);
-        
-        if(orange == groupSize) {
-            break;
+    const int localWord = get_local_id(0);
+    const int localRow = get_local_id(1);
+    const int localWords = get_local_size(0);
+    const int localRows = get_local_size(1);
+    const int firstRow = get_group_id(1) * tileRows;
+    const int firstWord = get_group_id(0) * tileWords;
+
+    // The size of the tile in local memory, with the halo
+    const int width = tileWords + 2;
+    const int height = tileRows + 2*generations;
+
+    for(int r = localRow; r < height; r += localRows) {
+        int row = (firstRow - generations + r) % rowCount;
+        if(row < 0) {
+            row += rowCount;
+        }
+        global const uint* inputRow = inputData + row*wordsPerRow;
+        local uint* tileRow = tileA + r*width;
+        for(int w = localWord; w < width; w += localWords) {
+            tileRow[w] = gol_load_word(inputRow, colCount, (firstWord - 1 + w) * 32);
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    local uint* from = tileA;
+    local uint* to = tileB;
+    for(int g = 1; g <= generations; g++) {
+        // The rows [g, height-g) are still right after this generation (except for the halo words).
+        for(int r = g + localRow; r < height - g; r += localRows) {
+            local const uint* a = from + (r-1)*width;
+            local const uint* b = from + r*width;
+            local const uint* c = from + (r+1)*width;
+            local uint* out = to + r*width;
+            for(int w = localWord; w < width; w += localWords) {
+                // Nothing comes in from outside of the halo words.
+                uint aW = a[w] << 1, bW = b[w] << 1, cW = c[w] << 1;
+                uint aE = a[w] >> 1, bE = b[w] >> 1, cE = c[w] >> 1;
+                if(w > 0) {
+                    aW |= a[w-1] >> 31;
+                    bW |= b[w-1] >> 31;
+                    cW |= c[w-1] >> 31;
+                }
+                if(w < width - 1) {
+                    aE |= a[w+1] << 31;
+                    bE |= b[w+1] << 31;
+                    cE |= c[w+1] << 31;
+                }
+                out[w] = gol_next_word(aW, a[w], aE, bW, b[w], bE, cW, c[w], cE, birthMask, survivalMask);
+            }
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+        local uint* swap = from;
+        from = to;
+        to = swap;
+    }
+
+    // Only the words with cells are written (the others are 0), and the bits beyond the last column are cleared.
+    const int usedWords = (colCount + 31) / 32;
+    const int lastBit = (colCount - 1) & 31;
+    const uint lastMask = (lastBit == 31) ? 0xFFFFFFFF : ((1u << (lastBit + 1)) - 1);
+    for(int r = localRow; r < tileRows && firstRow + r < rowCount; r += localRows) {
+        global uint* outputRow = outputData + (firstRow + r)*wordsPerRow;
+        local const uint* tileRow = from + (r + generations)*width + 1;
+        for(int w = localWord; w < tileWords && firstWord + w < wordsPerRow; w += localWords) {
+            int word = firstWord + w;
+            uint value = tileRow[w];
+            if(word >= usedWords) {
+                value = 0;
+            } else if(word == usedWords - 1) {
+                value &= lastMask;
+            }
+            outputRow[word] = value;
         }
-        
-        orange++;
-        
-        // Move the 3*3 kernel one step to the right
-        
-        cIdx++;
-        eIdx++;
-        fIdx++;
-        iIdx++;
-        
-        a = b;
-        b = c;
-        c = inputData[cIdx];
-        d = e;
-        e = f;
-        f = inputData[fIdx];
-        g = h;
-        h = i;
-        i = inputData[iIdx];
     }
 }
 
-/// Calculates alive state for the first and last row in a board
-kernel void gol_next_updown(global uchar* inputData, global uchar* outputData, int rowCount, int colCount)
+/// Packs a Board (one byte per cell, the lowest bit is 'alive') into words.
+/// One work-item per word: get_global_id(0) is the word, get_global_id(1) the row.
+kernel void gol_pack(global const uchar* inputData, global uint* outputData, int rowCount, int colCount, int wordsPerRow)
 {
-    size_t what = get_global_id(0);
-    int row, col;
-    if(what < colCount) {
-        gol_do_slow(inputData, outputData, rowCount, colCount, what);
-    } else {
-        gol_do_slow(inputData, outputData, rowCount, colCount, what + colCount*(rowCount-2));
+    const int w = get_global_id(0);
+    const int row = get_global_id(1);
+    const int firstCol = w * 32;
+    global const uchar* cells = inputData + (size_t)row*colCount;
+    uint word = 0;
+    for(int i = 0; i < 32 && firstCol + i < colCount; i++) {
+        word |= (uint)(cells[firstCol + i] & 1) << i;
     }
+    outputData[row*wordsPerRow + w] = word;
 }
 
-/// Calculates alive state for a particular col
-kernel void gol_next_col(global uchar* inputData, global uchar* outputData, int rowCount, int colCount, int col)
+/// Unpacks words into a Board, with the neighbour counts (bits 1-4 of every cell, see Board.h).
+/// One work-item per cell: get_global_id(0) is the column, get_global_id(1) the row.
+kernel void gol_unpack(global const uint* inputData, global uchar* outputData, int rowCount, int colCount, int wordsPerRow)
 {
-    size_t row = get_global_id(0);
-    int idx = row*colCount + col;
-    gol_do_slow(inputData, outputData, rowCount, colCount, idx);
+    const int col = get_global_id(0);
+    const int row = get_global_id(1);
+    const int colLeft = (col == 0) ? colCount - 1 : col - 1;
+    const int colRight = (col == colCount - 1) ? 0 : col + 1;
+    global const uint* above = inputData + ((row == 0) ? rowCount - 1 : row - 1)*wordsPerRow;
+    global const uint* here = inputData + row*wordsPerRow;
+    global const uint* below = inputData + ((row == rowCount - 1) ? 0 : row + 1)*wordsPerRow;
+    uint neighbours = gol_get_cell(above, colLeft) + gol_get_cell(above, col) + gol_get_cell(above, colRight)
+                    + gol_get_cell(here, colLeft) + gol_get_cell(here, colRight)
+                    + gol_get_cell(below, colLeft) + gol_get_cell(below, col) + gol_get_cell(below, colRight);
+    outputData[(size_t)row*colCount + col] = (uchar)(gol_get_cell(here, col) | (neighbours << 1));
 }
 
-/// Issue a full memory barrier. Necessary since these kernels are used with
-/// some kind of double buffering.
-/// OpenCL doesn't like kernel functions without arguments, so we will declare
-/// some dummy unused arguments.
-kernel void gol_rw_barrier(global uchar* inputData, global uchar* outputData)
+/// Adds the number of alive cells to `population`. One work-item per word.
+kernel void gol_count(global const uint* inputData, int wordCount, volatile global uint* population)
 {
-    barrier(CLK_GLOBAL_MEM_FENCE);
+    const int w = get_global_id(0);
+    if(w < wordCount) {
+        uint count = popcount(inputData[w]);
+        if(count != 0) {
+            atomic_add(population, count);
+        }
+    }
 }
@@ -9,6 +9,14 @@
 
 #include "gol-config.h"
 #include "Board.h"
+#include "BoardIO.h"
+#include "OutOfCoreBoard.h"
+#include "CycleDetector.h"
+#include "BatchRunner.h"
+#include "Benchmark.h"
+#include "Checkpoint.h"
+#include "MappedFile.h"
+#include "ProcessRunner.h"
 #include <map>
 #include <string>
 #include <vector>
@@ -20,6 +28,8 @@
 #include <memory>
 #include <cmath>
 #include <cassert>
+#include <stdexcept>
+#include <climits>
 
 using namespace std;
 using namespace std::chrono;
@@ -35,6 +45,26 @@ public:
     
 private:
     bool parseArguments(int argc, char **argv);
+    /// Runs all jobs of the --batch manifest (instead of --load etc.)
+    int runBatch();
+    /// Runs the --benchmark (instead of --load etc.)
+    int runBenchmark();
+    void printMeasurements();
+    /// Runs n generations with the engine of the selected mode.
+    void runGenerations(Board& b, int n);
+    void runGenerations(BitBoard& b, int n);
+    void addThreadStats(const vector<BitBoard::ThreadStats>& stats);
+#if USE_OPENCL
+    BitBoard::OpenCLDeviceType getOpenCLDeviceType() const;
+    void addHybridStats(const BitBoard::HybridStats& stats);
+#endif
+    /// Runs the generations with `run(b, n)` in steps, for --stats and --checkpoint-every: the statistics
+    /// are written at the start and every --stats-every generations, a checkpoint every --checkpoint-every
+    /// generations. (Counted from generation 0, also when the run was resumed.)
+    template <class BoardType>
+    void runInSteps(BoardType& b, const function<void(BoardType&, int64_t)>& run);
+    /// For --resume: sets arg_load and startGeneration to the newest checkpoint.
+    bool findCheckpoint();
     
     void fail(string reason) { sayError(reason); exit(1); };
     void sayVerbose(string message) { if (arg_verbose) { logMessage(message); } };
@@ -48,6 +78,9 @@ private:
     //
     
     void logMessage(string msg);
+    static string formatHash(uint64_t hash);
+    static bool parseHash(const string& str, uint64_t& hash);
+    static bool parseHashFile(const string& path, uint64_t& hash);
     string formatDuration(double duration);
     inline string formatDuration(duration<double> duration) { return formatDuration(duration.count()); };
     
@@ -63,18 +96,60 @@ private:
     
     // Command line arguments
     string arg_load;
+    string arg_batch;
     string arg_save;
     string arg_verify;
+    string arg_emit_hash;
+    bool has_verify_hash = false;
+    uint64_t arg_verify_hash = 0;
     string arg_mode = "seq";
     string arg_device; // for OpenCL
-    int arg_generations = -1;
-    int arg_threads = 4; // for OpenMP
+#if USE_PROCESSES
+    int arg_processes = Board::getDefaultThreadCount(); // for procs
+    Transport::Type arg_transport = Transport::SHARED_MEMORY; // for procs
+#endif
+    long long arg_generations = -1;
+    int arg_threads = Board::getDefaultThreadCount(); // for OpenMP and std::thread
+    string arg_topology = "torus"; // for HashLife
+    int arg_time_block = 8; // for timeblock
+    Rule arg_rule; // B3/S23
     bool arg_measure = false;
+    bool arg_detect_cycles = false;
+    string arg_stats;
+    long long arg_stats_every = 1;
+    long long arg_checkpoint_every = 0; // 0 = no checkpoints
+    string arg_checkpoint_dir;
+    string arg_resume;
+    string arg_benchmark;
+    int arg_benchmark_rows = 2048;
+    int arg_benchmark_cols = 2048;
+    double arg_benchmark_time = 1.0;
+    double arg_benchmark_density = Benchmark::DEFAULT_DENSITY;
+    bool has_mode_arg = false;
+    bool has_threads_arg = false;
+    bool has_processes_arg = false;
     bool arg_verbose = false;
     
     // State
+    /// The generation of the loaded board: 0, or the generation of the checkpoint with --resume.
+    long long startGeneration = 0;
     Board board;
-    Board verificationBoard;
+    /// For "bits", "timeblock", "steal", "opencl", "hybrid" and "procs" mode with a binary input file: the board is loaded and calculated without converting it to a `Board`.
+    BitBoard bitBoard;
+    bool useBitBoard = false;
+    /// For "steal" mode: what the threads did, for --measure (summed up over all runs).
+    vector<BitBoard::ThreadStats> threadStats;
+#if USE_OPENCL
+    /// For "hybrid" mode: what the device and the CPU threads did, for --measure (summed up over all runs).
+    BitBoard::HybridStats hybridStats;
+#endif
+    /// For "outofcore" mode: the board is never loaded into memory.
+    unique_ptr<OutOfCoreBoard> outOfCoreBoard;
+#if USE_PROCESSES
+    /// For "procs" mode: the processes are started by the first runGenerations() and kept
+    /// for the next ones (--stats and checkpoints), until the generations are done.
+    unique_ptr<ProcessRunner> processRunner;
+#endif
 };
 
 int Main::run(int argc, char **argv)
@@ -88,19 +163,48 @@ int Main::run(int argc, char **argv)
     //   Wir verwenden die std::chrono::high_resolution_clock.
     
     // Kommandozeilen-Optionen:
-    //   --load INPUTFILE
-    //   --save OUTPUTFILE  (optional)
-    //   --generations N    # Anzahl der Generationen die berechnet werden sollen. 0 <= N < (2^31-1)
-    //   --measure          # Am Ende Zeitmessungen anzeigen
+    //   --load INPUTFILE   # Text- oder Binärformat (.golb)
+    //   --batch MANIFEST   # Statt --load/--save/--generations: viele Boards, eine Zeile pro Board: "INPUTFILE GENERATIONS [OUTPUTFILE]"
+    //                      # Jeder Thread rechnet ein Board (seq, bits, tiles oder hashlife), --threads T = Anzahl der Threads
+    //   --save OUTPUTFILE  (optional; binary format if the name ends with .golb)
+    //   --generations N    # Anzahl der Generationen die berechnet werden sollen. 0 <= N < (2^31-1), für hashlife 0 <= N < 2^60
+    //   --measure          # Am Ende Zeitmessungen anzeigen (für steal auch pro Thread)
     //   --mode MODE        # Modus. Momentan wird nur "seq" unterstützt
     //       Modes:
     //          "seq" ... single threaded computation
+    //          "bits" ... single threaded, bit-packed computation
+    //          "tiles" ... single threaded, skips tiles that didn't change
+    //          "timeblock" ... bit-packed, calculates K generations of a band of rows at once (cache-friendly)
     //          "omp" ... Use OpenMP
+    //          "threads" ... Use std::thread
+    //          "steal" ... std::thread with work stealing, bit-packed, skips tiles that can't change
+    //          "hashlife" ... HashLife algorithm, for huge generation counts
+    //          "outofcore" ... bit-packed computation in memory-mapped files, for boards that don't fit into memory (binary format only)
     //          "ocl" ... Use OpenCL
-    //   --threads T        # Für OpenMP: Anzahl der zu benutzenden Threads. (Default: 4)
-    //   --device cpu|gpu   # Für OpenCL: Welches Device benutzen? (Default: GPU, but fallback to CPU)
+    //          "hybrid" ... OpenCL und std::thread gleichzeitig, jeder rechnet einen Teil der Zeilen (die Aufteilung wird gemessen)
+    //          "procs" ... mehrere Prozesse, jeder rechnet einen Block des Boards und tauscht die Randzeilen und -spalten aus (nicht unter Windows)
+    //   --threads T        # Für OpenMP, std::thread, steal, timeblock, hybrid und outofcore: Anzahl der zu benutzenden Threads. (Default: Anzahl der Hardware-Threads)
+    //   --time-block K     # Für timeblock: Anzahl der Generationen pro Band, für hybrid: pro Austausch der Randzeilen (Default: 8)
+    //   --processes N      # Für procs: Anzahl der Prozesse (Default: Anzahl der Hardware-Threads)
+    //   --transport shm|socket # Für procs: Shared Memory oder Unix-Sockets (Default: shm)
+    //   --topology torus|plane # Für HashLife: Wrap-around (Default) oder unendliche Ebene
+    //   --device cpu|gpu   # Für OpenCL und hybrid: Welches Device benutzen? (Default: GPU, but fallback to CPU)
+    //   --rule B3/S23      # Die Regel in B/S-Notation, z.B. B36/S23 (HighLife) (Default: B3/S23, Conway's Game of Life)
     // Zusätzliche Optionen (nicht Teil der Aufgabe, aber zum Entwickeln praktisch)
     //  --verify VERIFYFILE # Vergleicht das Ergebnis mit einem File. Nützlich zum Testen
+    //  --verify-hash HASH  # Vergleicht den Hash des Ergebnisses (16 Hex-Ziffern, oder ein File, das sie enthält)
+    //  --emit-hash FILE    # Schreibt den Hash des Ergebnisses in ein File ("-" = stdout)
+    //  --detect-cycles     # Hört auf zu rechnen, sobald sich das Board wiederholt (mit --verbose: Periode anzeigen)
+    //  --stats FILE        # Schreibt Population, Geburten und Tode als CSV, alle N Generationen
+    //  --stats-every N     # (Default: 1)
+    //  --checkpoint-every N # Alle N Generationen einen Checkpoint schreiben (im Hintergrund), in --checkpoint-dir
+    //  --checkpoint-dir DIR # (Default: das Verzeichnis von --resume)
+    //  --resume DIR        # Beim neuesten gültigen Checkpoint in DIR weitermachen (sonst bei --load anfangen)
+    //  --benchmark FILE    # Statt --load: alle Modi (und Thread-Anzahlen) mit generierten Boards messen, Ergebnis als JSON ("-" = stdout)
+    //                      # Mit --mode und --threads nur diesen Modus bzw. diese Thread-Anzahl
+    //  --benchmark-size COLS,ROWS # (Default: 2048,2048)
+    //  --benchmark-time S  # Mindestdauer pro Messung in Sekunden (Default: 1)
+    //  --benchmark-density D # Anteil der lebenden Zellen im "random"-Board (Default: 0.3)
     //  --verbose
     
     bool ok;
@@ -119,35 +223,78 @@ int Main::run(int argc, char **argv)
         board.setVerbose(true);
     }
     
+    sayVerbose("Using the rule " + arg_rule.toString() + ".");
+    if (arg_mode == "seq" || arg_mode == "openmp" || arg_mode == "threads") {
+        sayVerbose(string("Using the ") + Board::getSimdKernelName(Board::getSimdKernel()) + " kernel.");
+    }
+    
+    if (arg_batch != "") {
+        return runBatch();
+    }
+    if (arg_benchmark != "") {
+        return runBenchmark();
+    }
+    
     //
     // Kernel run time
     //
     
     timeStartKernelRunPhase = high_resolution_clock::now();
     
-    if (arg_mode == "seq") {
-        board.runSingleThreaded(arg_generations);
+    if (outOfCoreBoard) {
+        try {
+            outOfCoreBoard->run((int)arg_generations);
+        }
+        catch (const std::exception& e) {
+            fail(e.what());
+        }
     }
-#if USE_OPENMP
-    else if (arg_mode == "openmp") {
-        board.runOpenMP(arg_generations, arg_threads);
+    else if (arg_stats != "" || arg_checkpoint_every > 0) {
+        if (useBitBoard) {
+            runInSteps<BitBoard>(bitBoard, [this](BitBoard& b, int64_t n) { runGenerations(b, (int)n); });
+        } else {
+            runInSteps<Board>(board, [this](Board& b, int64_t n) {
+                if (arg_mode == "hashlife") {
+                    b.runHashLife(n, arg_topology == "plane");
+                } else {
+                    runGenerations(b, (int)n);
+                }
+            });
+        }
     }
-#endif
-#if USE_OPENCL
-    else if (arg_mode == "opencl") {
-        Board::OpenCLDeviceType dType = Board::DEVICE_TYPE_DONT_CARE;
-        if(arg_device == "gpu") {
-            dType = Board::DEVICE_TYPE_GPU_ONLY;
-        } else if(arg_device == "cpu") {
-            dType = Board::DEVICE_TYPE_CPU_ONLY;
+    else if (arg_detect_cycles) {
+        CycleInfo cycle;
+        if (useBitBoard) {
+            cycle = runWithCycleDetection<BitBoard>(bitBoard, arg_generations - startGeneration, [this](BitBoard& b, int n) { runGenerations(b, n); });
+        } else {
+            cycle = runWithCycleDetection<Board>(board, arg_generations - startGeneration, [this](Board& b, int n) { runGenerations(b, n); });
+        }
+        if (cycle.found) {
+            sayVerbose("Cycle detected: transient length at most " + to_string(cycle.transientUpperBound) + ", period " + to_string(cycle.period)
+                + ", skipped " + to_string(cycle.skippedGenerations) + " generations.");
+        } else {
+            sayVerbose("No cycle detected.");
         }
-        board.runOpenCL(arg_generations, dType);
     }
-#endif
+    else if (useBitBoard) {
+        runGenerations(bitBoard, (int)(arg_generations - startGeneration));
+    }
+    else if (arg_mode == "hashlife") {
+        board.runHashLife(arg_generations - startGeneration, arg_topology == "plane");
+    }
     else {
-        fail("Internal error: unsupported mode " + arg_mode);
+        runGenerations(board, (int)(arg_generations - startGeneration));
+    }    
+#if USE_PROCESSES
+    if (processRunner) {
+        try {
+            processRunner->stop();
+        }
+        catch (const std::exception& e) {
+            fail(e.what());
+        }
     }
-    
+#endif
     
     //
     // Finalization time
@@ -157,9 +304,26 @@ int Main::run(int argc, char **argv)
     bool verificationSuccess = true;
     bool saveSuccess = true;
     
+    // The out-of-core result is written while running, this only moves it to the output file.
+    uint64_t outOfCoreHash = 0;
+    if (outOfCoreBoard) {
+        try {
+            outOfCoreHash = outOfCoreBoard->finish();
+        }
+        catch (const std::exception& e) {
+            fail(e.what());
+        }
+    }
+    
     // Verification
     if (arg_verify != "") {
-        bool same = board == verificationBoard;
+        bool same = false;
+        try {
+            same = useBitBoard ? BoardIO::verify(bitBoard, arg_verify) : BoardIO::verify(board, arg_verify);
+        }
+        catch (const std::exception& e) {
+            fail(e.what());
+        }
         if (same) {
             sayVerbose("Verification successful!");
         }
@@ -169,9 +333,48 @@ int Main::run(int argc, char **argv)
         }
     }
     
+    // Hashes
+    if (has_verify_hash || arg_emit_hash != "") {
+        uint64_t hash = outOfCoreBoard ? outOfCoreHash : useBitBoard ? bitBoard.getHash() : board.getHash();
+        if (has_verify_hash) {
+            if (hash == arg_verify_hash) {
+                sayVerbose("Hash verification successful!");
+            }
+            else {
+                logMessage("Error: Hash verification failed: expected " + formatHash(arg_verify_hash) + ", got " + formatHash(hash));
+                verificationSuccess = false;
+            }
+        }
+        if (arg_emit_hash == "-") {
+            cout << formatHash(hash) << "\n";
+        }
+        else if (arg_emit_hash != "") {
+            FILE* f = fopen(arg_emit_hash.c_str(), "w");
+            if (f == NULL) {
+                fail("fopen(w) failed for file at " + arg_emit_hash);
+            }
+            fprintf(f, "%s\n", formatHash(hash).c_str());
+            fclose(f);
+        }
+    }
+    
     // Start of saving
-    if (arg_save != "") {
-        saveBoard(board, arg_save);
+    if (arg_save != "" && !outOfCoreBoard) {
+        if (useBitBoard) {
+            try {
+                if (BoardIO::isBinaryPath(arg_save)) {
+                    BoardIO::saveBinary(bitBoard, arg_save);
+                } else {
+                    BoardIO::saveText(bitBoard, arg_save);
+                }
+            }
+            catch (const std::exception& e) {
+                fail(e.what());
+            }
+        }
+        else {
+            saveBoard(board, arg_save);
+        }
     }
     
     //
@@ -181,18 +384,229 @@ int Main::run(int argc, char **argv)
     timeFinished = high_resolution_clock::now();
     
     if (arg_measure) {
-        duration<double> tdInitTime = duration_cast<duration<double>>(timeStartKernelRunPhase - timeStartInitPhase);
-        duration<double> tdKernelRunTime = duration_cast<duration<double>>(timeStartFinalizationPhase - timeStartKernelRunPhase);
-        duration<double> tdFinalizationTime = duration_cast<duration<double>>(timeFinished - timeStartFinalizationPhase);
-        
-        cout << formatDuration(tdInitTime) << "; " << formatDuration(tdKernelRunTime) << "; " << formatDuration(tdFinalizationTime) << ";\n";
+        printMeasurements();
     }
     
     return (verificationSuccess && saveSuccess) ? 0 : 1;
 }
 
+int Main::runBatch() {
+    vector<BatchJob> jobs;
+    try {
+        jobs = BatchRunner::parseManifest(arg_batch);
+    }
+    catch (const std::exception& e) {
+        fail(e.what());
+    }
+    for (const BatchJob& job : jobs) {
+        if (arg_mode != "hashlife" && job.generations > INT_MAX) {
+            fail(job.inputPath + ": the generation count is too big for this mode");
+        }
+    }
+    sayVerbose("Batch: " + to_string(jobs.size()) + " jobs, " + to_string(arg_threads) + " threads.");
+    
+    timeStartKernelRunPhase = high_resolution_clock::now();
+    
+    BatchRunner runner(jobs, arg_threads, [this](Board& b, int64_t n) {
+        b.setRule(arg_rule);
+        if (arg_mode == "hashlife") {
+            b.runHashLife(n, arg_topology == "plane");
+        } else {
+            runGenerations(b, (int)n);
+        }
+    });
+    vector<BatchResult> results = runner.run();
+    
+    timeStartFinalizationPhase = high_resolution_clock::now();
+    
+    size_t failedCount = 0;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (results[i].ok) {
+            sayVerbose(jobs[i].inputPath + ": " + formatHash(results[i].hash));
+        } else {
+            sayError(jobs[i].inputPath + ": " + results[i].error);
+            failedCount++;
+        }
+    }
+    double seconds = duration<double>(timeStartFinalizationPhase - timeStartKernelRunPhase).count();
+    seconds = max(seconds, 1e-9);
+    char buf[200];
+    snprintf(buf, sizeof(buf), "Batch: %zu boards (%zu failed) in %s; %.1f boards/s; %.3g cells/s;",
+        jobs.size() - failedCount, failedCount, formatDuration(seconds).c_str(),
+        (jobs.size() - failedCount) / seconds, runner.getCellGenerations() / seconds);
+    cout << buf << "\n";
+    
+    timeFinished = high_resolution_clock::now();
+    
+    if (arg_measure) {
+        printMeasurements();
+    }
+    
+    return failedCount == 0 ? 0 : 1;
+}
+
+int Main::runBenchmark() {
+    vector<BenchmarkResult> results;
+    timeStartKernelRunPhase = high_resolution_clock::now();
+    try {
+        Benchmark benchmark(arg_benchmark_rows, arg_benchmark_cols);
+        benchmark.setRule(arg_rule);
+        benchmark.setMinSeconds(arg_benchmark_time);
+        benchmark.setDensity(arg_benchmark_density);
+        if (has_mode_arg) {
+            benchmark.setModes(vector<string>(1, arg_mode));
+        }
+        if (has_threads_arg) {
+            benchmark.setThreadCounts(vector<int>(1, arg_threads));
+        }
+        results = benchmark.run([this](const BenchmarkResult& r) {
+            char buf[200];
+            snprintf(buf, sizeof(buf), "Benchmark: %s, %s, %d threads: %.3g generations/s; %.3g cells/s;",
+                r.workload.c_str(), r.mode.c_str(), r.threads, r.getGenerationsPerSecond(), r.getCellsPerSecond());
+            sayVerbose(buf);
+        });
+        timeStartFinalizationPhase = high_resolution_clock::now();
+        benchmark.writeJson(results, arg_benchmark);
+    }
+    catch (const std::exception& e) {
+        fail(e.what());
+    }
+    
+    timeFinished = high_resolution_clock::now();
+    
+    if (arg_measure) {
+        printMeasurements();
+    }
+    
+    return 0;
+}
+
+template <class BoardType>
+void Main::runInSteps(BoardType& b, const function<void(BoardType&, int64_t)>& run) {
+    FILE* f = NULL;
+    if (arg_stats != "") {
+        f = fopen(arg_stats.c_str(), "w");
+        if (f == NULL) {
+            fail("fopen(w) failed for file at " + arg_stats);
+        }
+        fprintf(f, "generation,population,births,deaths\n");
+    }
+    unique_ptr<Checkpointer> checkpointer;
+    if (arg_checkpoint_every > 0) {
+        try {
+            checkpointer.reset(new Checkpointer(arg_checkpoint_dir));
+        }
+        catch (const std::exception& e) {
+            fail(e.what());
+        }
+    }
+    // A failed checkpoint doesn't stop the run, the next one may work again.
+    auto saveCheckpoint = [&](long long generation) {
+        try {
+            string previousError = checkpointer->save(b, generation);
+            if (previousError != "") {
+                sayWarning(previousError);
+            }
+            sayVerbose("Checkpoint at generation " + to_string(generation) + ".");
+        }
+        catch (const std::exception& e) {
+            sayWarning("The checkpoint at generation " + to_string(generation) + " failed: " + e.what());
+        }
+    };
+    
+    long long generation = startGeneration;
+    for (;;) {
+        if (f != NULL && (generation % arg_stats_every == 0 || generation == startGeneration || generation == arg_generations)) {
+            GenerationStats stats = b.getStats();
+            fprintf(f, "%lld,%llu,%llu,%llu\n", generation, (unsigned long long)stats.population,
+                (unsigned long long)stats.births, (unsigned long long)stats.deaths);
+        }
+        if (checkpointer && generation % arg_checkpoint_every == 0 && generation != startGeneration) {
+            saveCheckpoint(generation);
+        }
+        if (generation >= arg_generations) {
+            break;
+        }
+        // Run until the next generation that is written somewhere.
+        long long next = arg_generations;
+        if (f != NULL) {
+            next = min(next, (generation / arg_stats_every + 1) * arg_stats_every);
+        }
+        if (checkpointer) {
+            next = min(next, (generation / arg_checkpoint_every + 1) * arg_checkpoint_every);
+        }
+        run(b, next - generation);
+        generation = next;
+    }
+    if (checkpointer) {
+        try {
+            checkpointer->wait();
+        }
+        catch (const std::exception& e) {
+            sayWarning(e.what());
+        }
+    }
+    if (f != NULL && fclose(f) != 0) {
+        fail("Can't write the file at " + arg_stats);
+    }
+}
+
+bool Main::findCheckpoint() {
+    string path;
+    int64_t generation = 0;
+    if (!Checkpointer::findLatest(arg_resume, path, generation)) {
+        if (arg_load == "") {
+            sayError("No valid checkpoint in " + arg_resume + ", and no file to --load.");
+            return false;
+        }
+        sayVerbose("No valid checkpoint in " + arg_resume + ", starting at " + arg_load + ".");
+        return true;
+    }
+    if (generation > arg_generations) {
+        sayError("The checkpoint " + path + " is at generation " + to_string(generation) + ", after --generations");
+        return false;
+    }
+    try {
+        MappedFile file(path);
+        BoardIO::BinaryFileInfo info = BoardIO::getBinaryFileInfo(file, path, false);
+        if (info.hasRule && info.rule != arg_rule) {
+            sayError("The checkpoint " + path + " was calculated with the rule " + info.rule.toString() + ", not " + arg_rule.toString());
+            return false;
+        }
+    }
+    catch (const std::exception& e) {
+        fail(e.what());
+    }
+    arg_load = path;
+    startGeneration = generation;
+    sayVerbose("Resuming at generation " + to_string(generation) + " (" + path + ").");
+    return true;
+}
+
+void Main::printMeasurements() {
+    duration<double> tdInitTime = duration_cast<duration<double>>(timeStartKernelRunPhase - timeStartInitPhase);
+    duration<double> tdKernelRunTime = duration_cast<duration<double>>(timeStartFinalizationPhase - timeStartKernelRunPhase);
+    duration<double> tdFinalizationTime = duration_cast<duration<double>>(timeFinished - timeStartFinalizationPhase);
+    
+    cout << formatDuration(tdInitTime) << "; " << formatDuration(tdKernelRunTime) << "; " << formatDuration(tdFinalizationTime) << ";\n";
+    for (size_t i = 0; i < threadStats.size(); i++) {
+        const BitBoard::ThreadStats& t = threadStats[i];
+        cout << "Thread " << i << ": busy " << formatDuration(t.busySeconds) << "; idle " << formatDuration(t.idleSeconds)
+            << "; " << t.tileCount << " tiles (" << t.stolenTileCount << " stolen);\n";
+    }
+#if USE_OPENCL
+    if (arg_mode == "hybrid") {
+        cout << "Device: " << hybridStats.deviceRows << " rows; busy " << formatDuration(hybridStats.deviceSeconds)
+            << "; CPU busy " << formatDuration(hybridStats.cpuSeconds) << "; " << hybridStats.resplitCount << " resplits;\n";
+    }
+#endif
+}
+
 bool Main::parseArguments(int argc, char **argv) {
-    bool has_threads_arg = false;
+    bool has_topology_arg = false;
+    bool has_time_block_arg = false;
+    bool has_stats_every_arg = false;
+    bool has_benchmark_options = false;
     int errorCount = 0;
     for (int i = 1; i < argc; i++) {
         string key = argv[i];
@@ -207,6 +621,11 @@ bool Main::parseArguments(int argc, char **argv) {
             myAssert(hasValue, "Missing argument after "+key);
             i++;
         }
+        else if (key == "--batch") {
+            arg_batch = val;
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+        }
         else if (key == "--save") {
             arg_save = val;
             myAssert(hasValue, "Missing argument after " + key);
@@ -217,9 +636,24 @@ bool Main::parseArguments(int argc, char **argv) {
             myAssert(hasValue, "Missing argument after " + key);
             i++;
         }
+        else if (key == "--verify-hash") {
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+            if (parseHash(val, arg_verify_hash) || parseHashFile(val, arg_verify_hash)) {
+                has_verify_hash = true;
+            } else {
+                sayError("Invalid value for --verify-hash argument (expected 16 hex digits or a file that contains them)");
+                errorCount++;
+            }
+        }
+        else if (key == "--emit-hash") {
+            arg_emit_hash = val;
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+        }
         else if (key == "--generations") {
             myAssert(hasValue, "Missing argument after " + key);
-            arg_generations = atoi(val.c_str());
+            arg_generations = atoll(val.c_str());
             i++;
             if (arg_generations < 1) {
                 sayError("Parameter --gernerations must be > 0");
@@ -230,6 +664,7 @@ bool Main::parseArguments(int argc, char **argv) {
             arg_mode = val;
             myAssert(hasValue, "Missing argument after " + key);
             i++;
+            has_mode_arg = true;
 
             // Convert arg_mode to lowercase string
             std::transform(arg_mode.begin(), arg_mode.end(), arg_mode.begin(), ::tolower);
@@ -241,7 +676,8 @@ bool Main::parseArguments(int argc, char **argv) {
                 arg_mode = "opencl";
             }
 
-            if (arg_mode == "seq") {
+            if (arg_mode == "seq" || arg_mode == "bits" || arg_mode == "tiles" || arg_mode == "threads" || arg_mode == "hashlife"
+                || arg_mode == "steal" || arg_mode == "timeblock" || arg_mode == "outofcore") {
                 // Ok
             }
 #if USE_OPENMP
@@ -250,7 +686,12 @@ bool Main::parseArguments(int argc, char **argv) {
             }
 #endif
 #if USE_OPENCL
-            else if (arg_mode == "opencl") {
+            else if (arg_mode == "opencl" || arg_mode == "hybrid") {
+                // Ok
+            }
+#endif
+#if USE_PROCESSES
+            else if (arg_mode == "procs") {
                 // Ok
             }
 #endif
@@ -266,6 +707,84 @@ bool Main::parseArguments(int argc, char **argv) {
         else if (key == "--verbose") {
             arg_verbose = true;
         }
+        else if (key == "--detect-cycles") {
+            arg_detect_cycles = true;
+        }
+        else if (key == "--stats") {
+            arg_stats = val;
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+        }
+        else if (key == "--stats-every") {
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+
+            arg_stats_every = atoll(val.c_str());
+            if (arg_stats_every < 1) {
+                sayError("Invalid value for --stats-every argument");
+                errorCount++;
+            }
+            else {
+                has_stats_every_arg = true;
+            }
+        }
+        else if (key == "--checkpoint-every") {
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+
+            arg_checkpoint_every = atoll(val.c_str());
+            if (arg_checkpoint_every < 1) {
+                sayError("Invalid value for --checkpoint-every argument");
+                errorCount++;
+            }
+        }
+        else if (key == "--checkpoint-dir") {
+            arg_checkpoint_dir = val;
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+        }
+        else if (key == "--resume") {
+            arg_resume = val;
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+        }
+        else if (key == "--benchmark") {
+            arg_benchmark = val;
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+        }
+        else if (key == "--benchmark-size") {
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+            has_benchmark_options = true;
+
+            if (sscanf(val.c_str(), "%d,%d", &arg_benchmark_cols, &arg_benchmark_rows) != 2 || arg_benchmark_cols < 1 || arg_benchmark_rows < 1) {
+                sayError("Invalid value for --benchmark-size argument (expected COLS,ROWS)");
+                errorCount++;
+            }
+        }
+        else if (key == "--benchmark-time") {
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+            has_benchmark_options = true;
+
+            arg_benchmark_time = atof(val.c_str());
+            if (!(arg_benchmark_time > 0)) {
+                sayError("Invalid value for --benchmark-time argument");
+                errorCount++;
+            }
+        }
+        else if (key == "--benchmark-density") {
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+            has_benchmark_options = true;
+
+            arg_benchmark_density = atof(val.c_str());
+            if (!(arg_benchmark_density >= 0 && arg_benchmark_density <= 1)) {
+                sayError("Invalid value for --benchmark-density argument");
+                errorCount++;
+            }
+        }
         else if (key == "--threads") {
             string tStr = val;
             myAssert(hasValue, "Missing argument after " + key);
@@ -280,6 +799,69 @@ bool Main::parseArguments(int argc, char **argv) {
                 has_threads_arg = true;
             }
         }
+#if USE_PROCESSES
+        else if (key == "--processes") {
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+
+            arg_processes = atoi(val.c_str());
+            if (arg_processes < 1) {
+                sayError("Invalid value for --processes argument");
+                errorCount++;
+            }
+            else {
+                has_processes_arg = true;
+            }
+        }
+        else if (key == "--transport") {
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+
+            if (Transport::parseType(val, arg_transport)) {
+                has_processes_arg = true;
+            } else {
+                sayError("Invalid value for --transport argument");
+                errorCount++;
+            }
+        }
+#endif
+        else if (key == "--time-block") {
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+
+            arg_time_block = atoi(val.c_str());
+            if (arg_time_block < 1) {
+                sayError("Invalid value for --time-block argument");
+                errorCount++;
+            }
+            else {
+                has_time_block_arg = true;
+            }
+        }
+        else if (key == "--rule") {
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+
+            try {
+                arg_rule = Rule::parse(val);
+            }
+            catch (const std::exception& e) {
+                sayError(e.what());
+                errorCount++;
+            }
+        }
+        else if (key == "--topology") {
+            myAssert(hasValue, "Missing argument after " + key);
+            i++;
+
+            if (val == "torus" || val == "plane") {
+                arg_topology = val;
+                has_topology_arg = true;
+            } else {
+                sayError("Invalid value for --topology argument");
+                errorCount++;
+            }
+        }
         else if (key == "--device") {
             string dStr = val;
             myAssert(hasValue, "Missing argument after " + key);
@@ -298,31 +880,128 @@ bool Main::parseArguments(int argc, char **argv) {
         }
     }
     
-    if (arg_load == "") {
+    if (arg_load == "" && arg_batch == "" && arg_resume == "" && arg_benchmark == "") {
         sayError("Please specify a file to --load.");
         return false;
     }
 
-    if (arg_mode != "openmp" && has_threads_arg) {
-        sayError("Argument --threads is only valid when using OpenMP");
+    if (arg_mode != "openmp" && arg_mode != "threads" && arg_mode != "steal" && arg_mode != "timeblock" && arg_mode != "hybrid"
+        && arg_mode != "outofcore" && arg_batch == "" && arg_benchmark == "" && has_threads_arg) {
+        sayError("Argument --threads is only valid when using OpenMP, std::thread, steal, timeblock, hybrid, outofcore, --batch or --benchmark");
         return false;
     }
     
-    if (arg_device.length() > 0 && arg_mode != "opencl") {
-        sayError("Argument --device is only valid when using OpenCL");
+    if (arg_detect_cycles && (arg_mode == "hashlife" || arg_mode == "outofcore" || arg_mode == "opencl" || arg_mode == "hybrid"
+        || arg_mode == "procs")) {
+        sayError("Argument --detect-cycles is not supported in " + arg_mode + " mode");
         return false;
     }
-
-    if (errorCount > 0) {
+    
+    if (has_stats_every_arg && arg_stats == "") {
+        sayError("Argument --stats-every is only valid with --stats");
         return false;
     }
     
-    board = loadBoard(arg_load);
+    if (arg_stats != "" && (arg_mode == "outofcore" || arg_detect_cycles)) {
+        sayError("Argument --stats is not supported in outofcore mode and with --detect-cycles");
+        return false;
+    }
     
-    sayVerbose("File successfully read (" + to_string(board.getColCount()) + "," + to_string(board.getRowCount()) + ").");
+    if (arg_checkpoint_dir == "") {
+        arg_checkpoint_dir = arg_resume;
+    }
+    if (arg_checkpoint_every > 0 && arg_checkpoint_dir == "") {
+        sayError("Argument --checkpoint-every needs a --checkpoint-dir");
+        return false;
+    }
+    if (arg_checkpoint_every == 0 && arg_checkpoint_dir != arg_resume) {
+        sayError("Argument --checkpoint-dir is only valid with --checkpoint-every");
+        return false;
+    }
     
-    if (arg_verify != "") {
-        verificationBoard = loadBoard(arg_verify);
+    if ((arg_checkpoint_every > 0 || arg_resume != "") && (arg_mode == "outofcore" || arg_detect_cycles)) {
+        sayError("Arguments --checkpoint-every and --resume are not supported in outofcore mode and with --detect-cycles");
+        return false;
+    }
+    
+    if (has_processes_arg && arg_mode != "procs") {
+        sayError("Arguments --processes and --transport are only valid when using procs");
+        return false;
+    }
+    
+    if (has_time_block_arg && arg_mode != "timeblock" && arg_mode != "hybrid") {
+        sayError("Argument --time-block is only valid when using timeblock or hybrid");
+        return false;
+    }
+    
+    if (has_topology_arg && arg_mode != "hashlife") {
+        sayError("Argument --topology is only valid when using HashLife");
+        return false;
+    }
+
+    if (arg_mode == "hashlife" ? arg_generations >= (1LL << 60) : arg_generations > INT_MAX) {
+        sayError("Parameter --generations is too big for this mode");
+        return false;
+    }
+
+    if (arg_mode == "hashlife" && arg_rule.isBorn(0)) {
+        sayError("Mode hashlife doesn't support rules with B0");
+        return false;
+    }
+
+    if (arg_device.length() > 0 && arg_mode != "opencl" && arg_mode != "hybrid") {
+        sayError("Argument --device is only valid when using OpenCL or hybrid");
+        return false;
+    }
+
+    if (arg_batch != "") {
+        if (arg_load != "" || arg_save != "" || arg_verify != "" || has_verify_hash || arg_emit_hash != "" || arg_generations != -1
+            || arg_detect_cycles || arg_stats != "" || arg_checkpoint_every > 0 || arg_resume != "") {
+            sayError("Arguments --load, --save, --generations, --verify, --verify-hash, --emit-hash, --detect-cycles, --stats,"
+                " --checkpoint-every and --resume are not valid with --batch (the jobs are in the manifest)");
+            return false;
+        }
+        if (arg_mode != "seq" && arg_mode != "bits" && arg_mode != "tiles" && arg_mode != "hashlife") {
+            sayError("Mode " + arg_mode + " is not supported with --batch (every board runs single-threaded, use seq, bits, tiles or hashlife)");
+            return false;
+        }
+    }
+
+    if (has_benchmark_options && arg_benchmark == "") {
+        sayError("Arguments --benchmark-size, --benchmark-time and --benchmark-density are only valid with --benchmark");
+        return false;
+    }
+    
+    if (arg_benchmark != "") {
+        if (arg_load != "" || arg_batch != "" || arg_save != "" || arg_verify != "" || has_verify_hash || arg_emit_hash != ""
+            || arg_generations != -1 || arg_detect_cycles || arg_stats != "" || arg_checkpoint_every > 0 || arg_resume != "") {
+            sayError("Argument --benchmark can't be combined with --load, --batch, --save, --generations, --verify, --verify-hash,"
+                " --emit-hash, --detect-cycles, --stats, --checkpoint-every and --resume");
+            return false;
+        }
+        if (arg_mode == "outofcore") {
+            sayError("Mode outofcore is not supported by --benchmark");
+            return false;
+        }
+    }
+
+    if (arg_mode == "outofcore") {
+        if (!BoardIO::isBinaryFile(arg_load) || !BoardIO::isBinaryPath(arg_save)) {
+            sayError("Mode outofcore needs a binary file to --load and a .golb file to --save");
+            return false;
+        }
+        if (arg_verify != "") {
+            sayError("Argument --verify is not supported in outofcore mode, use --verify-hash");
+            return false;
+        }
+    }
+
+    if (errorCount > 0) {
+        return false;
+    }
+    
+    if (arg_batch != "" || arg_benchmark != "") {
+        return true;
     }
     
     if (arg_generations < 1) {
@@ -330,50 +1009,212 @@ bool Main::parseArguments(int argc, char **argv) {
         return false;
     }
     
+    if (arg_resume != "" && !findCheckpoint()) {
+        return false;
+    }
+    
+    if (arg_mode == "outofcore") {
+        try {
+            outOfCoreBoard.reset(new OutOfCoreBoard(arg_load, arg_save, arg_threads));
+        }
+        catch (const std::exception& e) {
+            fail(e.what());
+        }
+        outOfCoreBoard->setVerbose(arg_verbose);
+        outOfCoreBoard->setRule(arg_rule);
+        sayVerbose("Binary file successfully mapped (" + to_string(outOfCoreBoard->getColCount()) + "," + to_string(outOfCoreBoard->getRowCount()) + ").");
+    }
+    else if (arg_mode == "bits" || arg_mode == "timeblock" || arg_mode == "steal" || arg_mode == "opencl" || arg_mode == "hybrid"
+                || arg_mode == "procs") {
+        // These modes run on a BitBoard, so load the file directly into one. (A Board would need 8 times more memory.)
+        const bool isBinary = BoardIO::isBinaryFile(arg_load);
+        try {
+            bitBoard = isBinary ? BoardIO::loadBinary(arg_load) : BoardIO::loadTextBits(arg_load);
+        }
+        catch (const std::exception& e) {
+            fail(e.what());
+        }
+        bitBoard.setRule(arg_rule);
+        useBitBoard = true;
+        sayVerbose(string(isBinary ? "Binary file" : "File") + " successfully read (" + to_string(bitBoard.getColCount()) + ","
+            + to_string(bitBoard.getRowCount()) + ").");
+    }
+    else {
+        board = loadBoard(arg_load);
+        board.setRule(arg_rule);
+        sayVerbose("File successfully read (" + to_string(board.getColCount()) + "," + to_string(board.getRowCount()) + ").");
+    }
+    
+    // The verification file is compared while reading it, after the run. But let's fail early if it isn't there.
+    if (arg_verify != "") {
+        FILE* f = fopen(arg_verify.c_str(), "rb");
+        if (f == NULL) {
+            fail("fopen(r) failed for file at " + arg_verify);
+        }
+        fclose(f);
+    }
+    
     return true;
 }
 
-Board Main::loadBoard(const std::string& path) {
-    FILE *f = fopen(path.c_str(), "r");
-    if(!f) {
-        fail("fopen(r) failed for file at "+path);
+#if USE_OPENCL
+BitBoard::OpenCLDeviceType Main::getOpenCLDeviceType() const {
+    if (arg_device == "gpu") {
+        return BitBoard::DEVICE_TYPE_GPU_ONLY;
+    } else if (arg_device == "cpu") {
+        return BitBoard::DEVICE_TYPE_CPU_ONLY;
     }
-    int rowCount=-1, colCount=-1;
-    fscanf(f, "%d,%d\n", &colCount, &rowCount);
-    if(rowCount < 1 || colCount < 1) {
-        fclose(f);
-        fail("fscanf() failed for file at "+path);
+    return BitBoard::DEVICE_TYPE_DONT_CARE;
+}
+
+void Main::addHybridStats(const BitBoard::HybridStats& stats) {
+    hybridStats.deviceRows = stats.deviceRows;
+    hybridStats.deviceSeconds += stats.deviceSeconds;
+    hybridStats.cpuSeconds += stats.cpuSeconds;
+    hybridStats.resplitCount += stats.resplitCount;
+}
+#endif
+
+void Main::addThreadStats(const vector<BitBoard::ThreadStats>& stats) {
+    threadStats.resize(stats.size());
+    for (size_t i = 0; i < stats.size(); i++) {
+        threadStats[i].busySeconds += stats[i].busySeconds;
+        threadStats[i].idleSeconds += stats[i].idleSeconds;
+        threadStats[i].tileCount += stats[i].tileCount;
+        threadStats[i].stolenTileCount += stats[i].stolenTileCount;
     }
-    char* buf = (char*)malloc(colCount+5);
-    if(buf == nullptr) {
-        fclose(f);
-        fail("malloc failed for file at "+path);
+}
+
+void Main::runGenerations(Board& b, int n) {
+    if (arg_mode == "seq") {
+        b.runSingleThreaded(n);
     }
-    Board board = Board(rowCount, colCount);
-    for(int rowIdx=0; rowIdx<rowCount; rowIdx++) {
-        char* result = fgets(buf, colCount+3, f);
-        if(result == nullptr) {
-            fclose(f);
-            fail("fgets failed for file at "+path);
+    else if (arg_mode == "bits") {
+        b.runBits(n);
+    }
+    else if (arg_mode == "tiles") {
+        b.runTiles(n);
+    }
+    else if (arg_mode == "timeblock") {
+        b.runTimeBlocked(n, arg_time_block, arg_threads);
+    }
+#if USE_OPENMP
+    else if (arg_mode == "openmp") {
+        b.runOpenMP(n, arg_threads);
+    }
+#endif
+    else if (arg_mode == "threads") {
+        b.runThreaded(n, arg_threads);
+    }
+    else if (arg_mode == "steal") {
+        vector<BitBoard::ThreadStats> stats;
+        b.runWorkStealing(n, arg_threads, &stats);
+        addThreadStats(stats);
+    }
+#if USE_PROCESSES
+    else if (arg_mode == "procs") {
+        BitBoard bits(b);
+        runGenerations(bits, n);
+        bits.copyTo(b);
+    }
+#endif
+#if USE_OPENCL
+    else if (arg_mode == "opencl") {
+        try {
+            b.runOpenCL(n, getOpenCLDeviceType());
+        }
+        catch (const std::exception& e) {
+            fail(e.what());
+        }
+    }
+    else if (arg_mode == "hybrid") {
+        BitBoard::HybridStats stats;
+        try {
+            b.runHybrid(n, arg_time_block, arg_threads, getOpenCLDeviceType(), &stats);
+        }
+        catch (const std::exception& e) {
+            fail(e.what());
         }
-        for(int colIdx=0; colIdx<colCount; colIdx++) {
-            if(buf[colIdx] == 'x' || buf[colIdx] == 'X') {
-                board.setCell(rowIdx, colIdx, true);
+        addHybridStats(stats);
+    }
+#endif
+    else {
+        fail("Internal error: unsupported mode " + arg_mode);
+    }
+}
+
+void Main::runGenerations(BitBoard& b, int n) {
+    if (arg_mode == "timeblock") {
+        b.runTimeBlocked(n, arg_time_block, arg_threads);
+    }
+    else if (arg_mode == "steal") {
+        vector<BitBoard::ThreadStats> stats;
+        b.runWorkStealing(n, arg_threads, &stats);
+        addThreadStats(stats);
+    }
+#if USE_PROCESSES
+    else if (arg_mode == "procs") {
+        if (b.getRowCount() == 0 || b.getColCount() == 0) {
+            return;
+        }
+        if (!processRunner) {
+            processRunner.reset(new ProcessRunner(arg_processes, arg_transport));
+            processRunner->setVerbose(arg_verbose);
+        }
+        try {
+            if (!processRunner->isStarted()) {
+                processRunner->start(b);
             }
+            processRunner->run(n);
+            processRunner->gather(b);
+        }
+        catch (const std::exception& e) {
+            fail(e.what());
         }
     }
-    fclose(f);
-    return board;
+#endif
+#if USE_OPENCL
+    else if (arg_mode == "opencl") {
+        try {
+            b.runOpenCL(n, getOpenCLDeviceType(), arg_verbose);
+        }
+        catch (const std::exception& e) {
+            fail(e.what());
+        }
+    }
+    else if (arg_mode == "hybrid") {
+        BitBoard::HybridStats stats;
+        try {
+            b.runHybrid(n, arg_time_block, arg_threads, getOpenCLDeviceType(), &stats, arg_verbose);
+        }
+        catch (const std::exception& e) {
+            fail(e.what());
+        }
+        addHybridStats(stats);
+    }
+#endif
+    else {
+        b.run(n);
+    }
+}
+
+Board Main::loadBoard(const std::string& path) {
+    try {
+        return BoardIO::load(path);
+    }
+    catch (const std::exception& e) {
+        fail(e.what());
+        return Board();
+    }
 }
 
 void Main::saveBoard(const Board& board, const std::string& path) {
-    FILE* f = fopen(path.c_str(), "w");
-    if(f == NULL) {
-        fail("fopen(w) failed for file at "+path);
+    try {
+        BoardIO::save(board, path);
+    }
+    catch (const std::exception& e) {
+        fail(e.what());
     }
-    std::string s = board.toString();
-    fwrite(s.c_str(), 1, s.length(), f);
-    fclose(f);
 }
 
 void Main::logMessage(string msg) {
@@ -384,6 +1225,31 @@ void Main::logMessage(string msg) {
     cout << diffStr << ": " << msg << endl;
 }
 
+string Main::formatHash(uint64_t hash) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)hash);
+    return string(buf);
+}
+
+bool Main::parseHash(const string& str, uint64_t& hash) {
+    if (str.length() != 16 || str.find_first_not_of("0123456789abcdefABCDEF") != string::npos) {
+        return false;
+    }
+    hash = strtoull(str.c_str(), nullptr, 16);
+    return true;
+}
+
+bool Main::parseHashFile(const string& path, uint64_t& hash) {
+    FILE* f = fopen(path.c_str(), "r");
+    if (f == NULL) {
+        return false;
+    }
+    char buf[64] = { 0 };
+    bool ok = fscanf(f, "%63s", buf) == 1 && parseHash(buf, hash);
+    fclose(f);
+    return ok;
+}
+
 string Main::formatDuration(double duration) {
     int seconds = (int)lround(floor(duration));
     int milliseconds = (int)lround((duration - seconds) * 1000);
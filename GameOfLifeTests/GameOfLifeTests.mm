@@ -8,6 +8,19 @@
 
 #import <XCTest/XCTest.h>
 #include "Board.h"
+#include "BitBoard.h"
+#include "BoardIO.h"
+#include "Hash.h"
+#include "OutOfCoreBoard.h"
+#include "CycleDetector.h"
+#include "BatchRunner.h"
+#include "Checkpoint.h"
+#include "Benchmark.h"
+#include "Simulation.h"
+#include "ProcessRunner.h"
+#include "ThreadPool.h"
+#include <sys/stat.h>
+#include <string>
 
 @interface GameOfLifeTests : XCTestCase
 
@@ -20,6 +33,14 @@
 - (void)setUp {
     [super setUp];
     // Put setup code here. This method is called before the invocation of each test method in the class.
+#if USE_OPENCL
+    // The tests don't run next to the GameOfLife executable, so the kernels are taken from the source tree.
+    if (getenv("GOL_OPENCL_KERNEL") == nullptr) {
+        const std::string testFile = __FILE__;
+        const std::string kernelFile = testFile.substr(0, testFile.find_last_of('/')) + "/../GameOfLife/gol_kernel.cl";
+        setenv("GOL_OPENCL_KERNEL", kernelFile.c_str(), 0);
+    }
+#endif
 }
 
 - (void)tearDown {
@@ -156,6 +177,847 @@
     XCTAssert(b1 == b2);
 }
 
+static Board makeRandomBoard(int rows, int cols) {
+    Board b = Board(rows, cols);
+    for(int rIdx = 0; rIdx < rows; rIdx++) {
+        for(int cIdx = 0; cIdx < cols; cIdx++) {
+            if(arc4random() % 3 == 1) {
+                b.setCell(rIdx, cIdx, true);
+            }
+        }
+    }
+    return b;
+}
+
+static Board diffBoards(const Board& b1, const Board& b2) {
+    Board diff = Board(b1.getRowCount(), b1.getColCount());
+    assert(b1.getRowCount() == b2.getRowCount());
+    assert(b1.getColCount() == b2.getColCount());
+    for(int rowIdx = 0; rowIdx < b1.getRowCount(); rowIdx++) {
+        for(int colIdx = 0; colIdx < b1.getColCount(); colIdx++) {
+            bool val1 = b1.getCell(rowIdx, colIdx);
+            bool val2 = b2.getCell(rowIdx, colIdx);
+            if(val1 != val2) {
+                diff.setCell(rowIdx, colIdx, true);
+            }
+        }
+    }
+    return diff;
+}
+
+- (void)testBitBoard
+{
+    const int sizes[][2] = { {6, 6}, {20, 20}, {5, 64}, {7, 65}, {37, 130}, {64, 1}, {1, 70} };
+    for (auto& size : sizes) {
+        const Board randomBoard = makeRandomBoard(size[0], size[1]);
+        Board b1 = randomBoard;
+        Board b2 = randomBoard;
+        
+        b1.runSingleThreaded(1);
+        b2.runBits(1);
+        XCTAssert(b1 == b2, "%dx%d differs after 1 generation", size[0], size[1]);
+        
+        b1 = randomBoard;
+        b2 = randomBoard;
+        b1.runSingleThreaded(33);
+        b2.runBits(33);
+        if(b1 != b2) {
+            Board diff = diffBoards(b1, b2);
+            printf("b1 and b2 differ (33-gen). Difference: %s\n", diff.toString().c_str());
+        }
+        XCTAssert(b1 == b2);
+    }
+    
+    BitBoard bits(Board(6, 6));
+    bits.setCell(0, 0, true);
+    bits.setCell(1, 0, true);
+    bits.setCell(0, 5, true);
+    bits.setCell(1, 5, true);
+    const BitBoard square = bits;
+    bits.run(5);
+    XCTAssert(bits == square);
+}
+
+- (void)testTimeBlocked
+{
+    // Small boards (the halo wraps around more than once), and a board with many bands
+    const int sizes[][2] = { {6, 6}, {3, 70}, {37, 130}, {700, 4000} };
+    const int timeBlocks[] = { 1, 2, 5, 8 };
+    for (auto& size : sizes) {
+        const BitBoard randomBoard = BitBoard(makeRandomBoard(size[0], size[1]));
+        BitBoard expected = randomBoard;
+        expected.run(21);
+        for (int timeBlock : timeBlocks) {
+            for (int threads = 1; threads <= 3; threads += 2) {
+                BitBoard b = randomBoard;
+                b.runTimeBlocked(21, timeBlock, threads);
+                XCTAssert(b == expected, "%dx%d differs with time block %d and %d threads", size[0], size[1], timeBlock, threads);
+            }
+        }
+    }
+}
+
+- (void)testSimdKernels
+{
+    const Board::SimdKernel defaultKernel = Board::getSimdKernel();
+    const Board::SimdKernel kernels[] = { Board::SIMD_KERNEL_SSE2, Board::SIMD_KERNEL_AVX2, Board::SIMD_KERNEL_AVX512 };
+    const Board randomBoard = makeRandomBoard(50, 203);
+    
+    XCTAssert(Board::setSimdKernel(Board::SIMD_KERNEL_SCALAR));
+    Board expected = randomBoard;
+    expected.runSingleThreaded(20);
+    
+    for (Board::SimdKernel kernel : kernels) {
+        if (!Board::setSimdKernel(kernel)) {
+            printf("Skipping the %s kernel, the CPU doesn't support it.\n", Board::getSimdKernelName(kernel));
+            continue;
+        }
+        Board b = randomBoard;
+        b.runSingleThreaded(20);
+        XCTAssert(b == expected, "%s kernel differs from the scalar kernel", Board::getSimdKernelName(kernel));
+    }
+    
+    Board::setSimdKernel(defaultKernel);
+}
+
+- (void)testThreaded
+{
+    const int threadCounts[] = { 1, 2, 3, 7 };
+    const Board randomBoard = makeRandomBoard(23, 41);
+    Board expected = randomBoard;
+    expected.runSingleThreaded(17);
+    
+    for (int threads : threadCounts) {
+        Board b = randomBoard;
+        b.runThreaded(17, threads);
+        XCTAssert(b == expected, "%d threads differ from single-threaded", threads);
+    }
+    
+    // Too many threads for this board: falls back to fewer threads
+    Board small = makeRandomBoard(7, 9);
+    Board smallExpected = small;
+    smallExpected.runSingleThreaded(5);
+    small.runThreaded(5, 8);
+    XCTAssert(small == smallExpected);
+
+    // The same threads in every run, with more or fewer tasks than before
+    Board b = randomBoard;
+    for (int threads : { 3, 7, 2, 7 }) {
+        b.runThreaded(1, threads);
+    }
+    expected = randomBoard;
+    expected.runSingleThreaded(4);
+    XCTAssert(b == expected);
+    ThreadPool pool;
+    std::vector<int> calls(5, 0);
+    for (int taskCount : { 5, 2, 5 }) {
+        pool.run(taskCount, [&calls](int i) { calls[i]++; });
+    }
+    XCTAssertEqual(pool.getThreadCount(), 4);
+    XCTAssert(calls == std::vector<int>({ 3, 3, 2, 2, 2 }));
+}
+
+- (void)testTiles
+{
+    // Bigger than one tile, and not a multiple of the tile size
+    const Board randomBoard = makeRandomBoard(150, 130);
+    Board b1 = randomBoard;
+    Board b2 = randomBoard;
+    b1.runSingleThreaded(60);
+    b2.runTiles(60);
+    XCTAssert(b1 == b2);
+    
+    // A glider on an otherwise empty board, crossing tile borders and the wrap-around
+    Board glider = Board(200, 140);
+    glider.setCell(0, 1, true);
+    glider.setCell(1, 2, true);
+    glider.setCell(2, 0, true);
+    glider.setCell(2, 1, true);
+    glider.setCell(2, 2, true);
+    b1 = glider;
+    b2 = glider;
+    b1.runSingleThreaded(400);
+    b2.runTiles(400);
+    XCTAssert(b1 == b2);
+}
+
+- (void)testWorkStealing
+{
+    // Several tiles in both directions, not a multiple of the tile size
+    const Board randomBoard = makeRandomBoard(150, 600);
+    Board expected = randomBoard;
+    expected.runBits(40);
+    for (int threads = 1; threads <= 4; threads++) {
+        Board b = randomBoard;
+        std::vector<BitBoard::ThreadStats> stats;
+        b.runWorkStealing(40, threads, &stats);
+        XCTAssert(b == expected, "%d threads differ", threads);
+        XCTAssert((int)stats.size() == threads);
+    }
+
+    // A glider on an otherwise empty board, crossing tile borders and the wrap-around
+    Board glider = Board(200, 300);
+    glider.setCell(0, 1, true);
+    glider.setCell(1, 2, true);
+    glider.setCell(2, 0, true);
+    glider.setCell(2, 1, true);
+    glider.setCell(2, 2, true);
+    Board b1 = glider;
+    Board b2 = glider;
+    b1.runBits(800);
+    b2.runWorkStealing(800, 3);
+    XCTAssert(b1 == b2);
+}
+
+- (void)testHashLife
+{
+    const int sizes[3][2] = { {3, 5}, {37, 64}, {150, 130} };
+    const int generations[4] = { 1, 5, 6, 100 };
+    for (auto& size : sizes) {
+        const Board randomBoard = makeRandomBoard(size[0], size[1]);
+        for (int g : generations) {
+            Board b1 = randomBoard;
+            Board b2 = randomBoard;
+            b1.runBits(g);
+            b2.runHashLife(g);
+            XCTAssert(b1 == b2, "rows=%d cols=%d generations=%d", size[0], size[1], g);
+        }
+    }
+    
+    // A glider on a 64x64 torus is back at its start every 256 generations.
+    Board glider = Board(64, 64);
+    glider.setCell(0, 1, true);
+    glider.setCell(1, 2, true);
+    glider.setCell(2, 0, true);
+    glider.setCell(2, 1, true);
+    glider.setCell(2, 2, true);
+    Board b = glider;
+    b.runHashLife(1000000000LL);
+    XCTAssert(b == glider);
+
+    // Jumps so big that the torus, tiled into one node, has more than 2^64 cells
+    for (int64_t generations : { (1LL << 36) + 5, (1LL << 40) + 3, (1LL << 59) + 7 }) {
+        b = glider;
+        b.runHashLife(generations);
+        Board expectedGlider = glider;
+        expectedGlider.runSingleThreaded((int)(generations % 256));
+        XCTAssert(b == expectedGlider, "generations=%lld", (long long)generations);
+    }
+    
+    // On the infinite plane, the glider moves away
+    b = glider;
+    b.runHashLife(4, true);
+    Board expected = Board(64, 64);
+    expected.setCell(1, 2, true);
+    expected.setCell(2, 3, true);
+    expected.setCell(3, 1, true);
+    expected.setCell(3, 2, true);
+    expected.setCell(3, 3, true);
+    XCTAssert(b == expected);
+    b = glider;
+    b.runHashLife(1000000000LL, true);
+    XCTAssert(b == Board(64, 64));
+}
+
+- (void)testCycleDetection
+{
+    std::function<void(Board&, int)> runSeq = [](Board& b, int n) { b.runSingleThreaded(n); };
+    std::function<void(BitBoard&, int)> runBits = [](BitBoard& b, int n) { b.run(n); };
+
+    // A glider on a 20x20 torus is back at its start every 80 generations.
+    Board glider = Board(20, 20);
+    glider.setCell(0, 1, true);
+    glider.setCell(1, 2, true);
+    glider.setCell(2, 0, true);
+    glider.setCell(2, 1, true);
+    glider.setCell(2, 2, true);
+    Board expected = glider;
+    expected.runSingleThreaded(1000003 % 80);
+    Board b = glider;
+    CycleInfo info = runWithCycleDetection(b, 1000003, runSeq);
+    XCTAssert(b == expected);
+    XCTAssert(info.found && info.transientUpperBound == 0 && info.period == 80);
+
+    // The period must not be longer than the maximum
+    b = glider;
+    info = runWithCycleDetection(b, 1043, runSeq, 79);
+    XCTAssert(!info.found);
+    XCTAssert(b == expected);
+
+    // On a 10x10 torus the period is 40, which isn't a multiple of the check interval
+    Board smallGlider = Board(10, 10);
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            smallGlider.setCell(row, col, glider.getCell(row, col));
+        }
+    }
+    expected = smallGlider;
+    expected.runSingleThreaded(1000003 % 40);
+    info = runWithCycleDetection(smallGlider, 1000003, runSeq);
+    XCTAssert(smallGlider == expected);
+    XCTAssert(info.found && info.transientUpperBound == 0 && info.period == 40);
+
+    // Random boards, with and without a cycle before the end
+    const int generations[] = { 3, 500, 20000 };
+    for (int g : generations) {
+        const Board randomBoard = makeRandomBoard(30, 40);
+        BitBoard bits = BitBoard(randomBoard);
+        BitBoard bitsExpected = bits;
+        bitsExpected.run(g);
+        runWithCycleDetection(bits, g, runBits);
+        XCTAssert(bits == bitsExpected, "differs after %d generations", g);
+    }
+}
+
+/// One generation, calculated the slow way, cell by cell.
+static Board nextGenerationByHand(const Board& b, const Rule& rule) {
+    Board next = Board(b.getRowCount(), b.getColCount());
+    for (int row = 0; row < b.getRowCount(); row++) {
+        for (int col = 0; col < b.getColCount(); col++) {
+            int neighbours = 0;
+            for (int dRow = -1; dRow <= 1; dRow++) {
+                for (int dCol = -1; dCol <= 1; dCol++) {
+                    int r = (row + dRow + b.getRowCount()) % b.getRowCount();
+                    int c = (col + dCol + b.getColCount()) % b.getColCount();
+                    neighbours += ((dRow != 0 || dCol != 0) && b.getCell(r, c)) ? 1 : 0;
+                }
+            }
+            bool alive = b.getCell(row, col) ? rule.survives(neighbours) : rule.isBorn(neighbours);
+            next.setCell(row, col, alive);
+        }
+    }
+    return next;
+}
+
+- (void)testRules
+{
+    XCTAssert(Rule::parse("B3/S23") == Rule());
+    XCTAssert(Rule::parse("s23/b36") == Rule::parse("B36/S23"));
+    XCTAssert(Rule::parse("23/3") == Rule());
+    XCTAssert(Rule::parse("B2/S").toString() == "B2/S");
+    XCTAssert(Rule::parse("b3678/s34678").toString() == "B3678/S34678");
+    const char* invalidRules[] = { "", "B3", "B9/S23", "B33/S23", "X3/S23", "B3/B23" };
+    for (const char* str : invalidRules) {
+        bool failed = false;
+        try {
+            Rule::parse(str);
+        } catch (const std::exception&) {
+            failed = true;
+        }
+        XCTAssert(failed, "'%s'", str);
+    }
+
+    // HighLife, Day & Night and Seeds have their own template specialization, the others don't.
+    const char* rules[] = { "B36/S23", "B3678/S34678", "B2/S", "B35678/S5678", "B1357/S02468", "B0/S8" };
+    const Board::SimdKernel defaultKernel = Board::getSimdKernel();
+    const Board::SimdKernel kernels[] = {
+        Board::SIMD_KERNEL_SCALAR, Board::SIMD_KERNEL_SSE2, Board::SIMD_KERNEL_AVX2, Board::SIMD_KERNEL_AVX512
+    };
+    const int generations = 12;
+    for (const char* str : rules) {
+        const Rule rule = Rule::parse(str);
+        Board randomBoard = makeRandomBoard(70, 150);
+        randomBoard.setRule(rule);
+        Board expected = randomBoard;
+        for (int g = 0; g < generations; g++) {
+            expected = nextGenerationByHand(expected, rule);
+        }
+
+        for (Board::SimdKernel kernel : kernels) {
+            if (Board::setSimdKernel(kernel)) {
+                Board b = randomBoard;
+                b.runSingleThreaded(generations);
+                XCTAssert(b == expected, "%s: %s kernel differs", str, Board::getSimdKernelName(kernel));
+            }
+        }
+        Board::setSimdKernel(defaultKernel);
+
+        Board b = randomBoard;
+        b.runBits(generations);
+        XCTAssert(b == expected, "%s: bits differ", str);
+        XCTAssert(b.getRule() == rule);
+        b = randomBoard;
+        b.runTiles(generations);
+        XCTAssert(b == expected, "%s: tiles differ", str);
+        b = randomBoard;
+        b.runThreaded(generations, 3);
+        XCTAssert(b == expected, "%s: threads differ", str);
+        b = randomBoard;
+        b.runTimeBlocked(generations, 5, 2);
+        XCTAssert(b == expected, "%s: timeblock differs", str);
+        b = randomBoard;
+        b.runWorkStealing(generations, 2);
+        XCTAssert(b == expected, "%s: steal differs", str);
+        // HashLife doesn't support B0
+        b = randomBoard;
+        bool failed = false;
+        try {
+            b.runHashLife(generations);
+        } catch (const std::exception&) {
+            failed = true;
+        }
+        XCTAssert(failed ? rule.isBorn(0) : b == expected, "%s: hashlife differs", str);
+    }
+}
+
+static std::string writeTemporaryFile(const char* name, const std::string& contents) {
+    std::string path = std::string([NSTemporaryDirectory() UTF8String]) + "/" + name;
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(contents.data(), 1, contents.size(), f);
+    fclose(f);
+    return path;
+}
+
+- (void)testStats
+{
+    // Every engine against the counts of the last two generations
+    const Board randomBoard = makeRandomBoard(70, 200);
+    const int generations = 9;
+    Board before = randomBoard;
+    before.runBits(generations - 1);
+    Board after = before;
+    after.runBits(1);
+    GenerationStats expected;
+    for (int row = 0; row < 70; row++) {
+        for (int col = 0; col < 200; col++) {
+            expected.population += after.getCell(row, col);
+            expected.births += after.getCell(row, col) && !before.getCell(row, col);
+            expected.deaths += !after.getCell(row, col) && before.getCell(row, col);
+        }
+    }
+    auto same = [](const GenerationStats& s1, const GenerationStats& s2) {
+        return s1.population == s2.population && s1.births == s2.births && s1.deaths == s2.deaths;
+    };
+    XCTAssert(expected.births > 0 && expected.deaths > 0);
+
+    Board loaded = BoardIO::loadText(writeTemporaryFile("stats.gol", randomBoard.toString()));
+    XCTAssert(loaded.getStats().population == BitBoard(randomBoard).getPopulation() && loaded.getStats().births == 0);
+
+    const Board::SimdKernel defaultKernel = Board::getSimdKernel();
+    const Board::SimdKernel kernels[] = {
+        Board::SIMD_KERNEL_SCALAR, Board::SIMD_KERNEL_SSE2, Board::SIMD_KERNEL_AVX2, Board::SIMD_KERNEL_AVX512
+    };
+    for (Board::SimdKernel kernel : kernels) {
+        if (Board::setSimdKernel(kernel)) {
+            Board b = randomBoard;
+            b.runSingleThreaded(generations);
+            XCTAssert(same(b.getStats(), expected), "%s kernel", Board::getSimdKernelName(kernel));
+            b = randomBoard;
+            b.runThreaded(generations, 3);
+            XCTAssert(same(b.getStats(), expected), "threads, %s kernel", Board::getSimdKernelName(kernel));
+        }
+    }
+    Board::setSimdKernel(defaultKernel);
+#if USE_OPENMP
+    Board b = randomBoard;
+    b.runOpenMP(generations, 3);
+    XCTAssert(same(b.getStats(), expected), "openmp");
+#endif
+
+    Board b1 = randomBoard;
+    b1.runTiles(generations);
+    XCTAssert(same(b1.getStats(), expected), "tiles");
+    Board b2 = randomBoard;
+    b2.runBits(generations);
+    XCTAssert(same(b2.getStats(), expected), "bits");
+    for (int timeBlock : { 1, 4, 8 }) {
+        BitBoard bits(randomBoard);
+        bits.runTimeBlocked(generations, timeBlock, 2);
+        XCTAssert(same(bits.getStats(), expected), "timeblock %d", timeBlock);
+    }
+    BitBoard bits(randomBoard);
+    bits.runWorkStealing(generations, 2);
+    XCTAssert(same(bits.getStats(), expected), "steal");
+
+    // Changing cells by hand updates the population, but they aren't births
+    b2.setCell(0, 0, !b2.getCell(0, 0));
+    XCTAssert(b2.getStats().population == expected.population + (b2.getCell(0, 0) ? 1 : -1));
+    bits.setCell(0, 0, true);
+    XCTAssert(bits.getStats().births == 0 && bits.getStats().deaths == 0);
+}
+
+- (void)testLoadText
+{
+    // Big enough to be parsed by several threads
+    const Board randomBoard = makeRandomBoard(1000, 1100);
+    std::string path = writeTemporaryFile("random.gol", randomBoard.toString());
+    XCTAssert(BoardIO::loadText(path, 3) == randomBoard);
+    XCTAssert(BoardIO::loadTextBits(path, 3) == BitBoard(randomBoard));
+    
+    Board expected = Board(3, 4);
+    expected.setCell(0, 0, true);
+    expected.setCell(1, 3, true);
+    expected.setCell(2, 1, true);
+    expected.setCell(2, 2, true);
+    // Windows line endings, no newline at the end
+    path = writeTemporaryFile("crlf.gol", "4,3\r\nx...\r\n...x\r\n.xx.");
+    XCTAssert(BoardIO::loadText(path) == expected);
+    XCTAssert(BoardIO::loadTextBits(path) == BitBoard(expected));
+    // Lines of different length, missing cells are dead
+    path = writeTemporaryFile("short.gol", "4,3\nx\n...x\n.XX\n");
+    XCTAssert(BoardIO::loadText(path) == expected);
+    XCTAssert(BoardIO::loadTextBits(path) == BitBoard(expected));
+    
+    // Missing rows
+    path = writeTemporaryFile("missing.gol", "4,3\nx...\n...x\n");
+    bool failed = false;
+    try {
+        BoardIO::loadText(path);
+    } catch (const std::exception&) {
+        failed = true;
+    }
+    XCTAssert(failed);
+    failed = false;
+    try {
+        BoardIO::loadTextBits(path);
+    } catch (const std::exception&) {
+        failed = true;
+    }
+    XCTAssert(failed);
+}
+
+- (void)testSaveText
+{
+    // Several chunks of rows, and a width that isn't a multiple of 8
+    const Board randomBoard = makeRandomBoard(3000, 1501);
+    const std::string expected = randomBoard.toString();
+    std::string path = std::string([NSTemporaryDirectory() UTF8String]) + "/saved.gol";
+    for (bool useWriterThread : { false, true }) {
+        BoardIO::saveText(randomBoard, path, useWriterThread);
+        XCTAssert(BoardIO::loadText(path) == randomBoard);
+        BoardIO::saveText(BitBoard(randomBoard), path, useWriterThread);
+        FILE* f = fopen(path.c_str(), "rb");
+        std::string contents(expected.size() + 1, 0);
+        contents.resize(fread(&contents[0], 1, contents.size(), f));
+        fclose(f);
+        XCTAssert(contents == expected);
+    }
+}
+
+- (void)testXxHash64
+{
+    XCTAssert(xxHash64("", 0) == 0xEF46DB3751D8E999ULL);
+    XCTAssert(xxHash64("abc", 3) == 0x44BC2CF5AD770999ULL);
+    const char* s = "Nobody inspects the spammish repetition";
+    XCTAssert(xxHash64(s, strlen(s)) == 0xFBCEA83C8A378BF1ULL);
+    
+    // The same data in pieces
+    std::vector<unsigned char> data(1000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (unsigned char)(i * 7);
+    }
+    for (size_t pieceSize : { 1, 5, 31, 32, 33, 100 }) {
+        XxHash64 hash;
+        for (size_t i = 0; i < data.size(); i += pieceSize) {
+            hash.update(&data[i], std::min(pieceSize, data.size() - i));
+        }
+        XCTAssert(hash.digest() == xxHash64(&data[0], data.size()));
+    }
+}
+
+- (void)testVerify
+{
+    Board board = makeRandomBoard(37, 130);
+    XCTAssert(board.getHash() == BitBoard(board).getHash());
+    Board other = board;
+    other.setCell(36, 129, !other.getCell(36, 129));
+    XCTAssert(board.getHash() != other.getHash());
+    XCTAssert(Board(2, 3).getHash() != Board(3, 2).getHash());
+    
+    std::string dir = [NSTemporaryDirectory() UTF8String];
+    BoardIO::save(board, dir + "/verify.gol");
+    BoardIO::save(board, dir + "/verify.golb");
+    for (std::string name : { "/verify.gol", "/verify.golb" }) {
+        XCTAssert(BoardIO::verify(board, dir + name));
+        XCTAssert(BoardIO::verify(BitBoard(board), dir + name));
+        XCTAssert(!BoardIO::verify(other, dir + name));
+        XCTAssert(!BoardIO::verify(BitBoard(other), dir + name));
+        XCTAssert(!BoardIO::verify(Board(37, 129), dir + name));
+    }
+}
+
+- (void)testBinaryFormat
+{
+    const Board randomBoard = makeRandomBoard(37, 130);
+    std::string path = std::string([NSTemporaryDirectory() UTF8String]) + "/random.golb";
+    BoardIO::save(randomBoard, path);
+    XCTAssert(BoardIO::isBinaryFile(path));
+    XCTAssert(BoardIO::loadBinary(path) == BitBoard(randomBoard));
+    XCTAssert(BoardIO::load(path) == randomBoard);
+    
+    // Flip one cell in the file
+    FILE* f = fopen(path.c_str(), "r+b");
+    fseek(f, 100, SEEK_SET);
+    int c = fgetc(f);
+    fseek(f, 100, SEEK_SET);
+    fputc(c ^ 1, f);
+    fclose(f);
+    bool failed = false;
+    try {
+        BoardIO::load(path);
+    } catch (const std::exception&) {
+        failed = true;
+    }
+    XCTAssert(failed);
+}
+
+- (void)testCheckpoint
+{
+    const std::string directory = std::string([NSTemporaryDirectory() UTF8String]) + "/checkpoints";
+    Board board = makeRandomBoard(37, 130);
+    board.setRule(Rule::parse("B36/S23"));
+    BitBoard expected = BitBoard(board);
+    expected.run(30);
+    {
+        Checkpointer checkpointer(directory);
+        for (int generation = 10; generation <= 30; generation += 10) {
+            board.runSingleThreaded(10);
+            checkpointer.save(board, generation);
+        }
+        checkpointer.wait();
+    }
+    std::string path;
+    int64_t generation = 0;
+    XCTAssert(Checkpointer::findLatest(directory, path, generation));
+    XCTAssertEqual(generation, 30);
+    BitBoard resumed = BoardIO::loadBinary(path);
+    XCTAssert(resumed == expected);
+    XCTAssert(resumed.getRule() == Rule::parse("B36/S23"));
+
+    // A broken checkpoint is skipped. (Only the newest 2 are kept.)
+    FILE* f = fopen(path.c_str(), "r+b");
+    fseek(f, 100, SEEK_SET);
+    int c = fgetc(f);
+    fseek(f, 100, SEEK_SET);
+    fputc(c ^ 1, f);
+    fclose(f);
+    XCTAssert(Checkpointer::findLatest(directory, path, generation));
+    XCTAssertEqual(generation, 20);
+    resumed = BoardIO::loadBinary(path);
+    resumed.run(10);
+    XCTAssert(resumed == expected);
+
+    // A failed checkpoint is reported by the next save(), and the next one is written anyway.
+    // (The checkpoint at generation 40 can't be renamed to its name, because there is a directory.)
+    const std::string failingDirectory = directory + "/failing";
+    {
+        Checkpointer checkpointer(failingDirectory);
+        mkdir((failingDirectory + "/checkpoint-000000000040.golb").c_str(), 0777);
+        XCTAssert(checkpointer.save(board, 40) == "");
+        XCTAssert(checkpointer.save(board, 50).find("generation 40") != std::string::npos);
+        checkpointer.wait();
+    }
+    XCTAssert(Checkpointer::findLatest(failingDirectory, path, generation));
+    XCTAssertEqual(generation, 50);
+}
+
+- (void)testBenchmark
+{
+    for (const std::string& workload : Benchmark::getWorkloads()) {
+        BitBoard board = Benchmark::makeBoard(workload, 100, 90);
+        XCTAssert(board == Benchmark::makeBoard(workload, 100, 90));
+        XCTAssert(board.getPopulation() > 0);
+    }
+    XCTAssert(Benchmark::makeBoard("random", 100, 90, 0.3, 1) != Benchmark::makeBoard("random", 100, 90, 0.3, 2));
+
+    Benchmark benchmark(64, 70);
+    benchmark.setWorkloads({ "gliders" });
+    benchmark.setThreadCounts({ 1, 2 });
+    benchmark.setMinSeconds(0.001);
+    std::vector<BenchmarkResult> results = benchmark.run();
+    size_t expectedCount = 0;
+    for (const std::string& mode : Benchmark::getModes()) {
+        expectedCount += Benchmark::isMultiThreaded(mode) ? 2 : 1;
+    }
+    XCTAssertEqual(results.size(), expectedCount);
+    for (const BenchmarkResult& r : results) {
+        XCTAssert(r.generations > 0 && r.seconds > 0 && r.getCellsPerSecond() > 0);
+    }
+}
+
+- (void)testOutOfCore
+{
+    const Board randomBoard = makeRandomBoard(75, 200);
+    std::string inputPath = std::string([NSTemporaryDirectory() UTF8String]) + "/outofcore_in.golb";
+    std::string outputPath = std::string([NSTemporaryDirectory() UTF8String]) + "/outofcore_out.golb";
+    BoardIO::save(randomBoard, inputPath);
+    BitBoard expected = BitBoard(randomBoard);
+    expected.run(7);
+
+    // A band of 2 rows, so that there are many bands.
+    for (int threads = 1; threads <= 3; threads++) {
+        uint64_t hash;
+        {
+            OutOfCoreBoard board(inputPath, outputPath, threads, 2 * 4 * sizeof(uint64_t));
+            board.run(3);
+            board.run(4);
+            hash = board.finish();
+        }
+        XCTAssert(BoardIO::loadBinary(outputPath) == expected);
+        XCTAssert(hash == expected.getHash());
+    }
+}
+
+- (void)testBatch
+{
+    // Text and binary files, one job without an output file, and one job that fails
+    const std::string dir = std::string([NSTemporaryDirectory() UTF8String]) + "/";
+    std::vector<Board> boards;
+    std::string manifest = "# comment\n\n";
+    for (int i = 0; i < 20; i++) {
+        boards.push_back(makeRandomBoard(20 + i, 90 - i));
+        std::string ext = (i % 2 == 0) ? ".gol" : ".golb";
+        BoardIO::save(boards[i], dir + "batch_in" + std::to_string(i) + ext);
+        manifest += dir + "batch_in" + std::to_string(i) + ext + " " + std::to_string(i);
+        manifest += (i == 3) ? "\n" : " " + dir + "batch_out" + std::to_string(i) + ext + "\n";
+    }
+    manifest += dir + "batch_missing.gol 5 " + dir + "batch_out_missing.gol\n";
+    std::vector<BatchJob> jobs = BatchRunner::parseManifest(writeTemporaryFile("batch_manifest.txt", manifest));
+    XCTAssert(jobs.size() == 21);
+
+    BatchRunner runner(jobs, 3, [](Board& b, int64_t n) { b.runBits((int)n); });
+    runner.setNumberOfIOThreads(2);
+    std::vector<BatchResult> results = runner.run();
+    XCTAssert(results.size() == 21);
+    double cellGenerations = 0;
+    for (int i = 0; i < 20; i++) {
+        Board expected = boards[i];
+        expected.runBits(i);
+        cellGenerations += (double)expected.getRowCount() * expected.getColCount() * i;
+        XCTAssert(results[i].ok && results[i].hash == expected.getHash(), "job %d", i);
+        if (i != 3) {
+            XCTAssert(BoardIO::load(jobs[i].outputPath) == expected, "job %d", i);
+        }
+    }
+    XCTAssert(!results[20].ok && !results[20].error.empty());
+    XCTAssert(runner.getCellGenerations() == cellGenerations);
+
+    bool failed = false;
+    try {
+        BatchRunner::parseManifest(writeTemporaryFile("batch_bad.txt", "in.gol 10 out.gol extra\n"));
+    } catch (const std::exception&) {
+        failed = true;
+    }
+    XCTAssert(failed);
+}
+
+- (void)testSimulation
+{
+    // Byte and bit rectangles at odd offsets, then every engine against runBits()
+    Board randomBoard = makeRandomBoard(90, 150);
+    Simulation sim(90, 150);
+    std::vector<uint8_t> cells(90 * 160);
+    for (int row = 0; row < 90; row++) {
+        for (int col = 0; col < 150; col++) {
+            cells[row * 160 + col] = randomBoard.getCell(row, col) ? (uint8_t)(1 + row % 7) : 0;
+        }
+    }
+    sim.importCells(0, 0, 90, 150, &cells[0], 160);
+    XCTAssert(sim.getHash() == randomBoard.getHash());
+    uint64_t population = 0;
+    for (uint8_t cell : cells) {
+        population += cell != 0;
+    }
+    XCTAssert(sim.getPopulation() == population);
+
+    std::vector<uint8_t> region(37 * 71, 0xAA);
+    sim.exportCells(5, 13, 37, 71, &region[0], 71);
+    bool same = true;
+    for (int row = 0; row < 37; row++) {
+        for (int col = 0; col < 71; col++) {
+            same = same && region[row * 71 + col] == (randomBoard.getCell(5 + row, 13 + col) ? 1 : 0);
+        }
+    }
+    XCTAssert(same);
+
+    std::vector<uint64_t> bits(37 * 3);
+    sim.exportBits(5, 13, 37, 71, &bits[0], 3);
+    XCTAssert((bits[1] >> 7) == 0 && bits[2] == 0);
+    sim.clear();
+    XCTAssert(sim.getPopulation() == 0);
+    sim.importCells(0, 0, 90, 150, &cells[0], 160);
+    sim.importBits(50, 77, 37, 71, &bits[0], 3);
+    for (int row = 0; row < 37; row++) {
+        for (int col = 0; col < 71; col++) {
+            randomBoard.setCell(50 + row, 77 + col, randomBoard.getCell(5 + row, 13 + col));
+        }
+    }
+    XCTAssert(sim.getHash() == randomBoard.getHash());
+
+    Board expected = randomBoard;
+    expected.runBits(25);
+    const Simulation::Engine engines[] = {
+        Simulation::ENGINE_BITS, Simulation::ENGINE_TIMEBLOCK, Simulation::ENGINE_STEAL, Simulation::ENGINE_HASHLIFE
+    };
+    for (Simulation::Engine engine : engines) {
+        Simulation s(90, 150);
+        s.importCells(0, 0, 90, 150, &cells[0], 160);
+        s.importBits(50, 77, 37, 71, &bits[0], 3);
+        s.setEngine(engine);
+        s.setThreadCount(3);
+        s.step(10);
+        s.step(15);
+        XCTAssert(s.getGeneration() == 25 && s.getHash() == expected.getHash(), "engine %d", (int)engine);
+    }
+
+    // stepAsync() with a future and with a completion
+    sim.stepAsync(20).get();
+    int64_t generationInCompletion = 0;
+    std::shared_future<void> done = sim.stepAsync(5, [&](Simulation& s, std::exception_ptr error) {
+        generationInCompletion = error ? -1 : s.getGeneration();
+    });
+    done.wait();
+    XCTAssert(!sim.isRunning() && generationInCompletion == 25 && sim.getHash() == expected.getHash());
+
+    // The completion may use the Simulation again
+    std::shared_future<void> next;
+    sim.stepAsync(2, [&](Simulation& s, std::exception_ptr error) {
+        s.wait();
+        s.step(1);
+        next = s.stepAsync(3);
+    }).get();
+    next.get();
+    sim.wait();
+    XCTAssert(sim.getGeneration() == 31);
+
+    bool failed = false;
+    try {
+        sim.exportCells(60, 100, 31, 51, &region[0], 71);
+    } catch (const std::exception&) {
+        failed = true;
+    }
+    XCTAssert(failed);
+}
+
+#if USE_PROCESSES
+- (void)testProcesses
+{
+    // Grids that are 1 or 2 blocks wide (where a process is its own neighbour), blocks that aren't
+    // a multiple of 64 columns, and a board that is too small for all processes.
+    const int sizes[][2] = {{1, 1}, {3, 200}, {50, 70}, {64, 130}};
+    for(const auto& size: sizes) {
+        for(int processCount: {1, 2, 4, 6}) {
+            for(Transport::Type transport: {Transport::SHARED_MEMORY, Transport::UNIX_SOCKETS}) {
+                BitBoard b1 = BitBoard(makeRandomBoard(size[0], size[1]));
+                b1.setRule(Rule::parse(processCount == 6 ? "B36/S23" : "B3/S23"));
+                BitBoard b2 = b1;
+                b1.run(21);
+                ProcessRunner(processCount, transport).run(b2, 21);
+                XCTAssert(b1 == b2);
+            }
+        }
+    }
+
+    int gridRows = 0, gridCols = 0;
+    ProcessRunner::chooseGrid(1000, 1000, 8, gridRows, gridCols);
+    XCTAssert(gridRows * gridCols == 8 && gridRows >= 2 && gridCols >= 2);
+    ProcessRunner::chooseGrid(2, 1000, 8, gridRows, gridCols);
+    XCTAssert(gridRows * gridCols == 8 && gridRows <= 2);
+    ProcessRunner::chooseGrid(2, 3, 7, gridRows, gridCols);
+    XCTAssert(gridRows * gridCols == 6);
+}
+#endif
+
 #if USE_OPENCL
 - (void)testOpenCL
 {
@@ -187,34 +1049,6 @@
     XCTAssert(b1 == b2);
 }
 
-static Board makeRandomBoard(int rows, int cols) {
-    Board b = Board(rows, cols);
-    for(int rIdx = 0; rIdx < rows; rIdx++) {
-        for(int cIdx = 0; cIdx < cols; cIdx++) {
-            if(arc4random() % 3 == 1) {
-                b.setCell(rIdx, cIdx, true);
-            }
-        }
-    }
-    return b;
-}
-
-static Board diffBoards(const Board& b1, const Board& b2) {
-    Board diff = Board(b1.getRowCount(), b1.getColCount());
-    assert(b1.getRowCount() == b2.getRowCount());
-    assert(b1.getColCount() == b2.getColCount());
-    for(int rowIdx = 0; rowIdx < b1.getRowCount(); rowIdx++) {
-        for(int colIdx = 0; colIdx < b1.getColCount(); colIdx++) {
-            bool val1 = b1.getCell(rowIdx, colIdx);
-            bool val2 = b2.getCell(rowIdx, colIdx);
-            if(val1 != val2) {
-                diff.setCell(rowIdx, colIdx, true);
-            }
-        }
-    }
-    return diff;
-}
-
 - (void)testOpenCL_moreComplicated
 {
     const Board randomBoard = makeRandomBoard(20, 20);
@@ -264,6 +1098,109 @@ static Board diffBoards(const Board& b1, const Board& b2) {
     }
     XCTAssert(b1 == b2);
 }
+
+- (void)testOpenCL_smallAndOddBoards
+{
+    // Boards that are smaller than a tile, or smaller than the halo (the torus repeats),
+    // and boards that aren't a multiple of the tile size.
+    const int sizes[][2] = {{1, 1}, {2, 3}, {3, 3}, {4, 7}, {5, 5}, {6, 1}, {13, 17}, {65, 63}, {100, 129}};
+    for(const auto& size: sizes) {
+        const Board randomBoard = makeRandomBoard(size[0], size[1]);
+        Board b1 = randomBoard;
+        Board b2 = randomBoard;
+        b1.runSingleThreaded(19);
+        b2.runOpenCL(19, Board::DEVICE_TYPE_DONT_CARE);
+        if(b1 != b2) {
+            printf("%dx%d: b1 and b2 differ. Difference: %s\n", size[0], size[1], diffBoards(b1, b2).toString().c_str());
+        }
+        XCTAssert(b1 == b2);
+    }
+}
+
+- (void)testOpenCL_bitBoard
+{
+    // Column counts around the word sizes (32 on the device, 64 in BitBoard), and a non-default rule.
+    const int sizes[][2] = {{3, 5}, {40, 31}, {40, 32}, {40, 33}, {20, 64}, {70, 95}, {33, 200}};
+    for(const auto& size: sizes) {
+        for(const char* rule: {"B3/S23", "B36/S23"}) {
+            BitBoard b1 = BitBoard(makeRandomBoard(size[0], size[1]));
+            b1.setRule(Rule::parse(rule));
+            BitBoard b2 = b1;
+            b1.run(23);
+            b2.runOpenCL(23, BitBoard::DEVICE_TYPE_DONT_CARE);
+            XCTAssert(b1 == b2);
+        }
+    }
+}
+
+- (void)testOpenCL_hybrid
+{
+    // Small boards (where the halo is as big as a band), and generation counts that aren't a multiple of the time block.
+    const int sizes[][2] = {{2, 5}, {3, 40}, {17, 33}, {64, 64}, {300, 70}};
+    for(const auto& size: sizes) {
+        for(int timeBlock: {1, 4, 8}) {
+            BitBoard b1 = BitBoard(makeRandomBoard(size[0], size[1]));
+            b1.setRule(Rule::parse(timeBlock == 4 ? "B36/S23" : "B3/S23"));
+            BitBoard b2 = b1;
+            b1.run(45);
+            BitBoard::HybridStats stats;
+            b2.runHybrid(45, timeBlock, 3, BitBoard::DEVICE_TYPE_DONT_CARE, &stats);
+            XCTAssert(b1 == b2);
+            XCTAssert(stats.deviceRows >= 1 && stats.deviceRows < size[0]);
+        }
+    }
+}
+
+- (void)testOpenCL_twoBoardsTakeTurns
+{
+    // The device keeps the last board between two calls; it must notice when it gets a different one.
+    const Board randomBoard1 = makeRandomBoard(60, 70);
+    const Board randomBoard2 = makeRandomBoard(60, 70);
+    Board b1 = randomBoard1, b2 = randomBoard2;
+    Board expected1 = randomBoard1, expected2 = randomBoard2;
+    
+    for(int i = 0; i < 3; i++) {
+        b1.runOpenCL(5, Board::DEVICE_TYPE_DONT_CARE);
+        b2.runOpenCL(5, Board::DEVICE_TYPE_DONT_CARE);
+        expected1.runSingleThreaded(5);
+        expected2.runSingleThreaded(5);
+        XCTAssert(b1 == expected1);
+        XCTAssert(b2 == expected2);
+    }
+}
+
+- (void)testOpenCL_changedBetweenCalls
+{
+    // The device keeps the board as long as its version is the same; every change on the host needs a new upload.
+    const Board randomBoard = makeRandomBoard(60, 70);
+    BitBoard bits(randomBoard);
+    BitBoard expected(randomBoard);
+    bits.runOpenCL(3, BitBoard::DEVICE_TYPE_DONT_CARE);
+    expected.run(3);
+    const BitBoard copy = bits;
+    XCTAssert(copy.getVersion() == bits.getVersion());
+    
+    bits.setCell(5, 5, !bits.getCell(5, 5));
+    expected.setCell(5, 5, !expected.getCell(5, 5));
+    XCTAssert(bits.getVersion() != copy.getVersion());
+    bits.runOpenCL(3, BitBoard::DEVICE_TYPE_DONT_CARE);
+    expected.run(3);
+    XCTAssert(bits == expected);
+    
+    bits.getRow(7)[0] ^= 1;
+    bits.markChanged();
+    expected.getRow(7)[0] ^= 1;
+    bits.runOpenCL(3, BitBoard::DEVICE_TYPE_DONT_CARE);
+    expected.run(3);
+    XCTAssert(bits == expected);
+    
+    Board cells = randomBoard, expectedCells = randomBoard;
+    cells.runOpenCL(2, Board::DEVICE_TYPE_DONT_CARE);
+    cells.runSingleThreaded(1);
+    cells.runOpenCL(2, Board::DEVICE_TYPE_DONT_CARE);
+    expectedCells.runSingleThreaded(5);
+    XCTAssert(cells == expectedCells);
+}
 #endif
 
 @end
@@ -6,7 +6,10 @@ use strict;
 my $SCRIPT_NAME = $0;
 
 sub usage {
-	print "Usage: $SCRIPT_NAME width,height > outputFilePath.gol\n";
+	print "Usage: $SCRIPT_NAME width,height [density [seed]] > outputFilePath.gol\n";
+	print "  density: fraction of alive cells (default: 0.5)\n";
+	print "  seed: for the random number generator, the same seed gives the same board (default: random)\n";
+	print "For benchmarks, see also: GameOfLife --benchmark\n";
 	exit(1);
 }
 
@@ -26,11 +29,30 @@ if($w<=0 || $h<=0) {
 	usage();
 }
 
-print "$w,$h\n";
+my $density = @ARGV ? shift @ARGV : 0.5;
+if($density < 0 || $density > 1) {
+	usage();
+}
+if(@ARGV) {
+	srand(int(shift @ARGV));
+}
+
+# Printing (and calling rand()) for every single cell was very slow for big boards. So every
+# rand() call makes 4 random bytes, and one tr/// turns a whole row of bytes into cells:
+# a byte is an alive cell if it is less than $threshold. (So the density is rounded to 1/256.)
+my $threshold = int($density * 256 + 0.5);
+my $toCells = eval sprintf('sub { $_[0] =~ tr/\x00-\xff/%s/ }', ('x' x $threshold) . ('.' x (256 - $threshold)));
+my $wordsPerRow = int(($w + 3) / 4);
+
+binmode(STDOUT);
+my $out = "$w,$h\n";
 for(my $i=0; $i<$h; $i++) {
-	for(my $colIdx=0; $colIdx<$w; $colIdx++) {
-		my $r = rand();
-		print ($r > 0.5 ? "x" : ".");
+	my $row = substr(pack('V*', map { rand(4294967296) } 1..$wordsPerRow), 0, $w);
+	$toCells->($row);
+	$out .= $row . "\n";
+	if(length($out) >= 1 << 20) {
+		print $out;
+		$out = '';
 	}
-	print "\n";
 }
+print $out;